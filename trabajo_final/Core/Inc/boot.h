@@ -0,0 +1,49 @@
+#ifndef INC_BOOT_H_
+#define INC_BOOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+#define BOOT_ERR_TOO_MANY_PHASES (ERR_BASE_BOOT + 1)
+#define BOOT_ERR_DEPENDENCY (ERR_BASE_BOOT + 2)
+
+// Phases whose timings are kept, boot_run() accepts up to this many
+#define BOOT_MAX_PHASES 8
+
+// Written by a step after the last one of its phase, LCD_INIT_DONE and HT_INIT_DONE have the same value
+#define BOOT_STEP_DONE UINT32_MAX
+
+// Runs the next part of a phase without waiting, and writes the microseconds until the following one is due
+typedef app_err_t (*boot_step_t)(uint32_t* wait_us);
+
+/*
+ * Part of the start-up, usually the initialization of a device. Its steps are called again and again until
+ * it writes BOOT_STEP_DONE, interleaved with the steps of the other phases while it waits.
+ */
+typedef struct {
+	uint8_t* name;
+	boot_step_t step;
+	// Bit per phase, by its index, that must be finished before this one starts
+	uint32_t depends_on;
+} boot_phase_t;
+
+// Timings of a phase in the last boot, in microseconds since the timebase started
+typedef struct {
+	uint8_t* name;
+	uint32_t start_us;
+	uint32_t ready_us;
+	uint32_t busy_us;
+	uint16_t steps;
+	app_err_t result;
+} boot_phase_info_t;
+
+app_err_t boot_run(const boot_phase_t* phases, uint8_t amount);
+
+uint8_t boot_get_amount_of_phases();
+
+app_err_t boot_get_phase_info(uint8_t idx, boot_phase_info_t* info);
+
+uint32_t boot_get_ready_us();
+
+#endif /* INC_BOOT_H_ */
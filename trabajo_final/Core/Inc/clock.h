@@ -0,0 +1,38 @@
+#ifndef INC_CLOCK_H_
+#define INC_CLOCK_H_
+
+#include <stdint.h>
+#include "error.h"
+
+#define CLOCK_ERR_BUSY (ERR_BASE_CLOCK + 1)
+#define CLOCK_ERR_CONFIG (ERR_BASE_CLOCK + 2)
+
+/*
+ * Clock trees the board can run on. SystemClock_Config() starts it in CLOCK_PROFILE_BALANCED, the others are
+ * only reached with clock_set_profile().
+ */
+typedef enum {
+	CLOCK_PROFILE_PERFORMANCE, // 180 MHz from the PLL, voltage scale 1 with over-drive, APB1 45 MHz
+	CLOCK_PROFILE_BALANCED, // 84 MHz from the PLL, voltage scale 3, APB1 42 MHz
+	CLOCK_PROFILE_LOW, // 16 MHz straight from the HSI with the PLL off, APB1 16 MHz
+	CLOCK_PROFILE_COUNT,
+} clock_profile_t;
+
+// Frequencies of the clock tree, in Hz
+typedef struct {
+	clock_profile_t profile;
+	uint32_t sysclk_hz;
+	uint32_t pclk1_hz;
+	uint32_t pclk2_hz;
+	uint8_t flash_latency;
+} clock_info_t;
+
+app_err_t clock_set_profile(clock_profile_t profile);
+
+clock_profile_t clock_get_profile();
+
+void clock_get_info(clock_info_t* info);
+
+app_err_t clock_restore();
+
+#endif /* INC_CLOCK_H_ */
@@ -0,0 +1,32 @@
+#ifndef INC_CYCLES_H_
+#define INC_CYCLES_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+void cycles_init();
+
+uint32_t cycles_from_ns(uint32_t ns);
+
+uint32_t cycles_to_us(uint32_t cycles);
+
+/**
+ * @brief returns the current value of the DWT cycle counter
+ *
+ * @note it is inline so reading the counter does not add a call to the measured code
+ */
+static inline uint32_t cycles_now() {
+	return DWT->CYCCNT;
+}
+
+/**
+ * @brief busy waits the given amount of core cycles
+ *
+ * @note the subtraction keeps the wait correct when the counter wraps around
+ */
+static inline void cycles_delay(uint32_t cycles) {
+	uint32_t start = DWT->CYCCNT;
+	while ((DWT->CYCCNT - start) < cycles);
+}
+
+#endif /* INC_CYCLES_H_ */
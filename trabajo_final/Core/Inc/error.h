@@ -17,6 +17,13 @@ typedef int32_t app_err_t;
 #define ERR_BASE_UART       0x3000
 #define ERR_BASE_CMDPARSER  0x4000
 #define ERR_BASE_I2C  		0x5000
+#define ERR_BASE_SCHEDULER  0x6000
+#define ERR_BASE_TIMEBASE   0x7000
+#define ERR_BASE_TIMERS     0x8000
+#define ERR_BASE_LATENCY    0x9000
+#define ERR_BASE_BOOT       0xA000
+#define ERR_BASE_WATCHDOG   0xB000
+#define ERR_BASE_CLOCK      0xC000
 
 uint8_t* app_err_to_name(app_err_t err);
 
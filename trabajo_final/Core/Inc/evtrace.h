@@ -0,0 +1,75 @@
+#ifndef INC_EVTRACE_H_
+#define INC_EVTRACE_H_
+
+#include <stdint.h>
+#include "timebase.h"
+
+// Build with -DEVTRACE_ENABLED=0 to remove the event trace, EVTRACE() then expands to nothing
+#ifndef EVTRACE_ENABLED
+#define EVTRACE_ENABLED 1
+#endif
+
+// Amount of records kept, a power of two so the free-running write index wraps onto the ring
+#define EVTRACE_LENGTH 256
+
+// Rate of the timestamps, they are microseconds of the TIM2 timebase
+#define EVTRACE_TICK_HZ 1000000
+
+// How the host decoder prints the argument of an event
+typedef enum {
+	EVTRACE_ARG_NONE,
+	EVTRACE_ARG_DEC,
+	EVTRACE_ARG_HEX,
+	// app_err_t cut to 16 bits, the generic errors are negative so they are kept as 0xFFxx
+	EVTRACE_ARG_ERROR,
+	// State of the cmdparser FSM, named by cmdparser_get_state_name()
+	EVTRACE_ARG_STATE,
+} evtrace_arg_t;
+
+/*
+ * Traced events as X(id, name, argument). The list is shared with the host decoder, which takes the names
+ * and the way to print the argument from it. New events go at the end, so older dumps keep their meaning.
+ */
+#define EVTRACE_EVENTS(X) \
+	X(EVTRACE_CMD_STATE, "CMD_STATE", EVTRACE_ARG_STATE) \
+	X(EVTRACE_CMD_ERROR, "CMD_ERROR", EVTRACE_ARG_ERROR) \
+	X(EVTRACE_UART_ERROR, "UART_ERROR", EVTRACE_ARG_HEX) \
+	X(EVTRACE_I2C_ERROR, "I2C_ERROR", EVTRACE_ARG_ERROR) \
+	X(EVTRACE_I2C_BUS_RESET, "I2C_BUS_RESET", EVTRACE_ARG_ERROR) \
+	X(EVTRACE_HT_INIT_RETRY, "HT_INIT_RETRY", EVTRACE_ARG_DEC) \
+	X(EVTRACE_HT_BUSY_POLL, "HT_BUSY_POLL", EVTRACE_ARG_DEC)
+
+#define EVTRACE_ID(id, name, arg) id,
+typedef enum {
+	EVTRACE_EVENTS(EVTRACE_ID)
+	EVTRACE_EVENT_COUNT,
+} evtrace_id_t;
+#undef EVTRACE_ID
+
+/*
+ * A traced event, 8 bytes so a record is written with two stores. The timestamp wraps around every 71 minutes,
+ * the decoder only uses differences between records.
+ */
+typedef struct {
+	uint32_t timestamp;
+	uint16_t id;
+	uint16_t arg;
+} evtrace_record_t;
+
+#if EVTRACE_ENABLED
+
+#define EVTRACE(id, arg) evtrace_record((id), (uint16_t)(arg))
+
+void evtrace_record(evtrace_id_t id, uint16_t arg);
+
+uint16_t evtrace_snapshot(evtrace_record_t* buffer, uint16_t size, uint32_t* written);
+
+void evtrace_clear();
+
+#else
+
+#define EVTRACE(id, arg) ((void)0)
+
+#endif /* EVTRACE_ENABLED */
+
+#endif /* INC_EVTRACE_H_ */
@@ -0,0 +1,75 @@
+#ifndef INC_PERF_H_
+#define INC_PERF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cycles.h"
+
+// Release builds (NDEBUG) have no profiling code at all, -DPERF_ENABLED=0 or 1 overrides it
+#ifndef PERF_ENABLED
+#ifdef NDEBUG
+#define PERF_ENABLED 0
+#else
+#define PERF_ENABLED 1
+#endif
+#endif
+
+// Amount of zones a report can hold, zones beyond it are left out of the report
+#define PERF_MAX_ZONES 16
+
+/*
+ * Profiling zone, one per place measured. It is a static created by PERF_ZONE() and joins the list of zones
+ * the first time it is measured. Times are DWT cycles.
+ */
+typedef struct perf_zone {
+	uint8_t* name;
+	uint32_t count;
+	uint32_t min_cycles;
+	uint32_t max_cycles;
+	uint64_t total_cycles;
+	bool registered;
+	struct perf_zone* next;
+} perf_zone_t;
+
+// Statistics of a zone, as copied by perf_snapshot()
+typedef struct {
+	uint8_t* name;
+	uint32_t count;
+	uint32_t min_cycles;
+	uint32_t max_cycles;
+	uint32_t avg_cycles;
+	uint64_t total_cycles;
+} perf_zone_info_t;
+
+// Measurement in progress, it is recorded when the variable goes out of scope
+typedef struct {
+	perf_zone_t* zone;
+	uint32_t start;
+} perf_scope_t;
+
+#if PERF_ENABLED
+
+/*
+ * Measures from this line to the end of the enclosing block, early returns included. The name is an identifier,
+ * unique within the function, and is what the PERF command prints.
+ */
+#define PERF_ZONE(zone_name) \
+	static perf_zone_t perf_zone_##zone_name = {.name = (uint8_t*)#zone_name}; \
+	perf_scope_t perf_scope_##zone_name __attribute__((cleanup(perf_scope_end))) = { \
+			.zone = &perf_zone_##zone_name, \
+			.start = cycles_now(), \
+	}
+
+void perf_scope_end(perf_scope_t* scope);
+
+uint8_t perf_snapshot(perf_zone_info_t* buffer, uint8_t size);
+
+void perf_reset();
+
+#else
+
+#define PERF_ZONE(zone_name)
+
+#endif /* PERF_ENABLED */
+
+#endif /* INC_PERF_H_ */
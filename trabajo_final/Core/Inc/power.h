@@ -0,0 +1,19 @@
+#ifndef INC_POWER_H_
+#define INC_POWER_H_
+
+#include <stdint.h>
+
+// Stop mode is used when no timer is running, enable it with -DPOWER_STOP_ENABLED=1
+#ifndef POWER_STOP_ENABLED
+#define POWER_STOP_ENABLED 0
+#endif
+
+void power_init();
+
+void power_idle(uint32_t max_sleep_ms);
+
+void power_exti_handler();
+
+void power_rtc_handler();
+
+#endif /* INC_POWER_H_ */
@@ -55,7 +55,16 @@ void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
+void EXTI15_10_IRQHandler(void);
+void I2C1_EV_IRQHandler(void);
+void I2C1_ER_IRQHandler(void);
+void I2C3_EV_IRQHandler(void);
+void I2C3_ER_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void USART2_IRQHandler(void);
+void EXTI3_IRQHandler(void);
+void RTC_WKUP_IRQHandler(void);
+void TIM2_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,40 @@
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "error.h"
+
+#define TIMEBASE_ERR_NO_CHANNEL (ERR_BASE_TIMEBASE + 1)
+#define TIMEBASE_ERR_INVALID_CHANNEL (ERR_BASE_TIMEBASE + 2)
+
+// One-shot callbacks that can be pending at the same time, one per compare channel of TIM2
+#define TIMEBASE_CHANNELS 4
+
+// Called from the TIM2 interrupt when its deadline is reached
+typedef void (*timebase_callback_t)(void* context);
+
+app_err_t timebase_init();
+
+app_err_t timebase_update_clock();
+
+void timebase_delay_us(uint32_t us);
+
+app_err_t timebase_call_at(uint32_t deadline_us, timebase_callback_t callback, void* context, uint8_t* channel);
+
+app_err_t timebase_call_after(uint32_t delay_us, timebase_callback_t callback, void* context, uint8_t* channel);
+
+app_err_t timebase_cancel(uint8_t channel);
+
+void timebase_irq_handler();
+
+/**
+ * @brief returns the microseconds of the free-running TIM2 counter, it wraps around every 71 minutes
+ *
+ * @note it is inline so reading the counter does not add a call to the measured code
+ */
+static inline uint32_t timebase_now_us() {
+	return TIM2->CNT;
+}
+
+#endif /* INC_TIMEBASE_H_ */
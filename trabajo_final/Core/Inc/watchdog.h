@@ -0,0 +1,66 @@
+#ifndef INC_WATCHDOG_H_
+#define INC_WATCHDOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+#define WATCHDOG_ERR_TABLE_FULL (ERR_BASE_WATCHDOG + 1)
+#define WATCHDOG_ERR_INVALID_ACTIVITY (ERR_BASE_WATCHDOG + 2)
+
+#define WATCHDOG_MAX_ACTIVITIES 8
+
+// Time without a reload after which the IWDG resets the core, from the 32 kHz LSI so it may be about half or twice
+#define WATCHDOG_TIMEOUT_MS 1000
+
+// The activities are checked this often, and the IWDG is reloaded if all of them are healthy
+#define WATCHDOG_CHECK_PERIOD_MS 250
+
+// Characters of the name of the stalled activity kept across the reset
+#define WATCHDOG_NAME_LENGTH 8
+
+typedef enum {
+	WATCHDOG_RESET_UNKNOWN,
+	WATCHDOG_RESET_POWER_ON,
+	WATCHDOG_RESET_PIN,
+	WATCHDOG_RESET_BROWN_OUT,
+	WATCHDOG_RESET_SOFTWARE,
+	WATCHDOG_RESET_IWDG,
+	WATCHDOG_RESET_WWDG,
+	WATCHDOG_RESET_LOW_POWER,
+	WATCHDOG_RESET_COUNT,
+} watchdog_reset_cause_t;
+
+typedef uint8_t watchdog_id_t;
+
+// Cause of the last reset, and the activity that made the watchdog expire if it was the IWDG
+typedef struct {
+	watchdog_reset_cause_t cause;
+	uint8_t stalled[WATCHDOG_NAME_LENGTH + 1];
+	uint32_t watchdog_resets;
+} watchdog_reset_info_t;
+
+typedef struct {
+	uint8_t* name;
+	uint32_t deadline_ms;
+	uint32_t since_checkin_ms;
+	bool busy;
+} watchdog_activity_info_t;
+
+void watchdog_init();
+
+app_err_t watchdog_register(uint8_t* name, uint32_t deadline_ms, watchdog_id_t* id);
+
+void watchdog_expect(watchdog_id_t id);
+
+void watchdog_checkin(watchdog_id_t id, bool done);
+
+void watchdog_reload_if_idle();
+
+void watchdog_get_reset_info(watchdog_reset_info_t* info);
+
+uint8_t watchdog_get_amount_of_activities();
+
+app_err_t watchdog_get_activity_info(uint8_t idx, watchdog_activity_info_t* info);
+
+#endif /* INC_WATCHDOG_H_ */
@@ -0,0 +1,197 @@
+#include "boot.h"
+#include "port.h"
+#include <stddef.h>
+
+typedef struct {
+	boot_phase_info_t info;
+	boot_step_t step;
+	uint32_t depends_on;
+	// Time at which the next step is due
+	uint32_t next_us;
+	bool started;
+	bool done;
+} phase_state_t;
+
+static phase_state_t phases_state[BOOT_MAX_PHASES];
+static uint8_t amount_of_phases = 0;
+static uint32_t ready_us = 0;
+
+// Prototypes
+static phase_state_t* get_next_phase(uint32_t finished);
+static app_err_t run_step(phase_state_t* phase);
+static bool is_before(uint32_t time, uint32_t reference);
+
+/**
+ * @brief runs the phases of the start-up, interleaving their steps, and returns once all of them are finished
+ *
+ * Every phase starts at the same time, so waits that count from power-up (such as the power-on time of the
+ * devices) overlap instead of adding up. The next step to run is the one of a phase whose dependencies are
+ * finished that is due the earliest, and the core sleeps until then when no step is due yet. A wait can only
+ * get longer because a step of another phase is running, never shorter.
+ *
+ * @note the timebase and the port must be initialized before, the timings are kept for boot_get_phase_info()
+ *
+ * @return
+ * - APP_OK: if every phase is finished
+ * - APP_ERR_INVALID_ARG: if phases is NULL or a phase has no step
+ * - BOOT_ERR_TOO_MANY_PHASES: if amount is above BOOT_MAX_PHASES
+ * - BOOT_ERR_DEPENDENCY: if a phase depends on one that does not exist or on itself, directly or not
+ * - the error of the first step that fails, the other phases are not finished then
+ */
+app_err_t boot_run(const boot_phase_t* phases, uint8_t amount) {
+	if (phases == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (amount > BOOT_MAX_PHASES) {
+		return BOOT_ERR_TOO_MANY_PHASES;
+	}
+
+	uint32_t start_us = port_now_us();
+	for (uint8_t idx = 0; idx < amount; idx++) {
+		if (phases[idx].step == NULL) {
+			return APP_ERR_INVALID_ARG;
+		}
+
+		if (phases[idx].depends_on >> amount || (phases[idx].depends_on & (1UL << idx))) {
+			return BOOT_ERR_DEPENDENCY;
+		}
+
+		phases_state[idx] = (phase_state_t){
+				.info = {.name = phases[idx].name, .result = APP_OK},
+				.step = phases[idx].step,
+				.depends_on = phases[idx].depends_on,
+				.next_us = start_us,
+		};
+	}
+
+	amount_of_phases = amount;
+	ready_us = 0;
+
+	uint32_t finished = 0;
+	for (uint8_t amount_finished = 0; amount_finished < amount;) {
+		phase_state_t* phase = get_next_phase(finished);
+		if (phase == NULL) {
+			// Every phase left waits for another one that is left too
+			return BOOT_ERR_DEPENDENCY;
+		}
+
+		uint32_t now = port_now_us();
+		if (is_before(now, phase->next_us)) {
+			port_delay_us(phase->next_us - now);
+		}
+
+		app_err_t err = run_step(phase);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		if (phase->done) {
+			finished |= 1UL << (phase - phases_state);
+			amount_finished++;
+		}
+	}
+
+	ready_us = port_now_us();
+	return APP_OK;
+}
+
+uint8_t boot_get_amount_of_phases() {
+	return amount_of_phases;
+}
+
+/**
+ * @brief returns the timings of a phase of the last boot
+ *
+ * @param idx: index of the phase, from 0 to boot_get_amount_of_phases() - 1
+ *
+ * @return
+ * - APP_OK: if the information is written
+ * - APP_ERR_INVALID_ARG: if info is NULL or idx is out of range
+ */
+app_err_t boot_get_phase_info(uint8_t idx, boot_phase_info_t* info) {
+	if (info == NULL || idx >= amount_of_phases) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	*info = phases_state[idx].info;
+	return APP_OK;
+}
+
+/**
+ * @brief returns the microseconds since the timebase started at which the last boot finished, 0 if it did not
+ *
+ */
+uint32_t boot_get_ready_us() {
+	return ready_us;
+}
+
+/**
+ * @brief finds the phase to run next: among the unfinished ones whose dependencies are finished, the one whose
+ * step is due the earliest
+ *
+ * @param finished: bit per finished phase
+ *
+ * @return the phase, or NULL if no phase can run
+ */
+phase_state_t* get_next_phase(uint32_t finished) {
+	phase_state_t* next = NULL;
+
+	for (uint8_t idx = 0; idx < amount_of_phases; idx++) {
+		phase_state_t* phase = &phases_state[idx];
+		if (phase->done || (phase->depends_on & ~finished)) {
+			continue;
+		}
+
+		if (next == NULL || is_before(phase->next_us, next->next_us)) {
+			next = phase;
+		}
+	}
+
+	return next;
+}
+
+/**
+ * @brief runs the next step of the phase and updates its timings
+ *
+ * A phase that waited for its dependencies starts when it runs for the first time, and its next step is due
+ * the time it asked for after the end of this one.
+ *
+ */
+app_err_t run_step(phase_state_t* phase) {
+	uint32_t step_start = port_now_us();
+	if (!phase->started) {
+		phase->info.start_us = step_start;
+		phase->started = true;
+	}
+
+	uint32_t wait_us;
+	app_err_t err = phase->step(&wait_us);
+	uint32_t step_end = port_now_us();
+
+	phase->info.busy_us += step_end - step_start;
+	phase->info.steps++;
+
+	if (err != APP_OK) {
+		phase->info.result = err;
+		return err;
+	}
+
+	if (wait_us == BOOT_STEP_DONE) {
+		phase->info.ready_us = step_end;
+		phase->done = true;
+	} else {
+		phase->next_us = step_end + wait_us;
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief compares two times of the timebase
+ *
+ * @note the difference is taken as signed, so it is correct when the timebase wraps around
+ */
+bool is_before(uint32_t time, uint32_t reference) {
+	return (int32_t)(time - reference) < 0;
+}
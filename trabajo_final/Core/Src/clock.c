@@ -0,0 +1,233 @@
+#include "clock.h"
+#include "stm32f4xx_hal.h"
+#include "API_scheduler.h"
+#include "API_uart.h"
+#include "i2c_core.h"
+#include "i2c_trace.h"
+#include "lcd_port.h"
+#include "perf.h"
+#include "timebase.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// The HSI is divided down to 1 MHz at the input of the PLL, so PLLN is the VCO frequency in MHz
+#define PLL_INPUT_DIVIDER 16
+
+typedef struct {
+	uint32_t voltage_scale;
+	bool over_drive;
+	bool use_pll;
+	uint32_t pll_n;
+	uint32_t pll_p;
+	uint32_t apb1_divider;
+	uint32_t apb2_divider;
+	// Wait states for a supply of 2.7 V to 3.6 V
+	uint32_t flash_latency;
+} profile_config_t;
+
+static const profile_config_t PROFILES[CLOCK_PROFILE_COUNT] = {
+		[CLOCK_PROFILE_PERFORMANCE] = {
+				.voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE1,
+				.over_drive = true,
+				.use_pll = true,
+				.pll_n = 360,
+				.pll_p = RCC_PLLP_DIV2,
+				.apb1_divider = RCC_HCLK_DIV4,
+				.apb2_divider = RCC_HCLK_DIV2,
+				.flash_latency = FLASH_LATENCY_5,
+		},
+		[CLOCK_PROFILE_BALANCED] = {
+				.voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE3,
+				.over_drive = false,
+				.use_pll = true,
+				.pll_n = 336,
+				.pll_p = RCC_PLLP_DIV4,
+				.apb1_divider = RCC_HCLK_DIV2,
+				.apb2_divider = RCC_HCLK_DIV1,
+				.flash_latency = FLASH_LATENCY_2,
+		},
+		[CLOCK_PROFILE_LOW] = {
+				.voltage_scale = PWR_REGULATOR_VOLTAGE_SCALE3,
+				.over_drive = false,
+				.use_pll = false,
+				.apb1_divider = RCC_HCLK_DIV1,
+				.apb2_divider = RCC_HCLK_DIV1,
+				.flash_latency = FLASH_LATENCY_0,
+		},
+};
+
+// Set up by SystemClock_Config()
+static clock_profile_t current_profile = CLOCK_PROFILE_BALANCED;
+
+// Prototypes
+static app_err_t configure(const profile_config_t* config);
+static void update_peripherals();
+static void reset_cycle_stats();
+
+/**
+ * @brief switches the clock tree to the given profile and recomputes the settings that depend on it
+ *
+ * SysTick is programmed again by the HAL, then the TIM2 prescaler, the UART baud rate, the clock of the I2C
+ * buses and the delays of the LCD port are recomputed from the new clocks, so the timebase, the baud rate, the
+ * bus speeds and the LCD timings stay the same. The statistics kept in DWT cycles (PERF, TASKS and the I2C
+ * trace) are cleared, they could not be converted to time once the clock changes.
+ *
+ * @note it must be called from task context with the UART not transmitting. A character received during the
+ * switch is lost
+ *
+ * @return
+ * - APP_OK: if the board runs on the profile
+ * - APP_ERR_INVALID_ARG: if the profile does not exist
+ * - CLOCK_ERR_BUSY: if there are I2C transfers in progress or queued, they would go on at the wrong speed
+ * - CLOCK_ERR_CONFIG: if the clocks could not be configured, the previous profile is set up again
+ */
+app_err_t clock_set_profile(clock_profile_t profile) {
+	if (profile >= CLOCK_PROFILE_COUNT) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (profile == current_profile) {
+		return APP_OK;
+	}
+
+	if (!I2C_is_idle()) {
+		return CLOCK_ERR_BUSY;
+	}
+
+	app_err_t err = configure(&PROFILES[profile]);
+	if (err == APP_OK) {
+		current_profile = profile;
+	} else {
+		configure(&PROFILES[current_profile]);
+	}
+
+	update_peripherals();
+	if (err == APP_OK) {
+		reset_cycle_stats();
+	}
+
+	return err;
+}
+
+clock_profile_t clock_get_profile() {
+	return current_profile;
+}
+
+/**
+ * @brief returns the frequencies the board runs at
+ *
+ */
+void clock_get_info(clock_info_t* info) {
+	if (info == NULL) {
+		return;
+	}
+
+	info->profile = current_profile;
+	info->sysclk_hz = HAL_RCC_GetSysClockFreq();
+	info->pclk1_hz = HAL_RCC_GetPCLK1Freq();
+	info->pclk2_hz = HAL_RCC_GetPCLK2Freq();
+	info->flash_latency = __HAL_FLASH_GET_LATENCY();
+}
+
+/**
+ * @brief configures again the clocks of the current profile, it must be called after leaving Stop mode
+ *
+ * The core wakes up on the HSI with the PLL and the over-drive off. The bus clocks end up the same as before
+ * Stop mode, so the peripherals are not touched.
+ *
+ * @return APP_OK, or CLOCK_ERR_CONFIG if the clocks could not be configured
+ */
+app_err_t clock_restore() {
+	return configure(&PROFILES[current_profile]);
+}
+
+/**
+ * @brief sets up the clock tree of the profile, whatever it runs on
+ *
+ * The core runs from the HSI while the PLL and the regulator are changed: the voltage scale can only be
+ * written with the PLL off, and the over-drive has to be enabled with the PLL on but before it drives SYSCLK.
+ * The HAL orders the change of the flash wait states around the switch of SYSCLK.
+ *
+ */
+app_err_t configure(const profile_config_t* config) {
+	__HAL_RCC_PWR_CLK_ENABLE();
+
+	RCC_ClkInitTypeDef clk_init = {
+			.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2,
+			.SYSCLKSource = RCC_SYSCLKSOURCE_HSI,
+			.AHBCLKDivider = RCC_SYSCLK_DIV1,
+			.APB1CLKDivider = RCC_HCLK_DIV1,
+			.APB2CLKDivider = RCC_HCLK_DIV1,
+	};
+
+	if (HAL_RCC_ClockConfig(&clk_init, __HAL_FLASH_GET_LATENCY()) != HAL_OK) {
+		return CLOCK_ERR_CONFIG;
+	}
+
+	if (__HAL_PWR_GET_FLAG(PWR_FLAG_ODRDY) && HAL_PWREx_DisableOverDrive() != HAL_OK) {
+		return CLOCK_ERR_CONFIG;
+	}
+
+	RCC_OscInitTypeDef osc_init = {
+			.OscillatorType = RCC_OSCILLATORTYPE_NONE,
+			.PLL.PLLState = RCC_PLL_OFF,
+	};
+
+	if (HAL_RCC_OscConfig(&osc_init) != HAL_OK) {
+		return CLOCK_ERR_CONFIG;
+	}
+
+	__HAL_PWR_VOLTAGESCALING_CONFIG(config->voltage_scale);
+
+	if (config->use_pll) {
+		osc_init.PLL = (RCC_PLLInitTypeDef){
+				.PLLState = RCC_PLL_ON,
+				.PLLSource = RCC_PLLSOURCE_HSI,
+				.PLLM = PLL_INPUT_DIVIDER,
+				.PLLN = config->pll_n,
+				.PLLP = config->pll_p,
+				.PLLQ = 2,
+				.PLLR = 2,
+		};
+
+		if (HAL_RCC_OscConfig(&osc_init) != HAL_OK) {
+			return CLOCK_ERR_CONFIG;
+		}
+
+		if (config->over_drive && HAL_PWREx_EnableOverDrive() != HAL_OK) {
+			return CLOCK_ERR_CONFIG;
+		}
+
+		clk_init.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+	}
+
+	clk_init.APB1CLKDivider = config->apb1_divider;
+	clk_init.APB2CLKDivider = config->apb2_divider;
+
+	return (HAL_RCC_ClockConfig(&clk_init, config->flash_latency) != HAL_OK) ? CLOCK_ERR_CONFIG : APP_OK;
+}
+
+/**
+ * @brief recomputes the settings of the peripherals that are derived from the bus clocks
+ *
+ */
+void update_peripherals() {
+	timebase_update_clock();
+	uartUpdateBaudRate();
+	I2C_update_clock();
+	lcd_port_update_clock();
+}
+
+/**
+ * @brief clears the statistics measured in cycles of the previous clock
+ *
+ */
+void reset_cycle_stats() {
+	sched_reset_stats();
+#if PERF_ENABLED
+	perf_reset();
+#endif
+#if I2C_TRACE_ENABLED
+	i2c_trace_clear();
+#endif
+}
@@ -0,0 +1,37 @@
+#include "cycles.h"
+
+/**
+ * @brief enables the DWT cycle counter
+ *
+ * The counter runs at the core clock, so it gives cycle-accurate timestamps and short delays
+ * without using a hardware timer
+ *
+ */
+void cycles_init() {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief converts nanoseconds into core cycles
+ *
+ * @param ns: nanoseconds to convert
+ *
+ * @return the amount of cycles, rounded up so delays are never shorter than requested
+ */
+uint32_t cycles_from_ns(uint32_t ns) {
+	uint32_t cycles_per_us = SystemCoreClock / 1000000;
+	return ((uint64_t)ns * cycles_per_us + 999) / 1000;
+}
+
+/**
+ * @brief converts core cycles into microseconds
+ *
+ * @param cycles: cycles to convert
+ *
+ * @return the amount of microseconds
+ */
+uint32_t cycles_to_us(uint32_t cycles) {
+	return cycles / (SystemCoreClock / 1000000);
+}
@@ -4,6 +4,13 @@
 #include "API_ht_sensor.h"
 #include "i2c_core.h"
 #include "API_cmdparser.h"
+#include "API_scheduler.h"
+#include "timebase.h"
+#include "API_timers.h"
+#include "API_latency.h"
+#include "boot.h"
+#include "watchdog.h"
+#include "clock.h"
 
 /**
  * @brief returns the error code as an array of characters
@@ -34,6 +41,7 @@ uint8_t* app_err_to_name(app_err_t err) {
         case LCD_ERR_SENDING_DATA:    	return (uint8_t*)"LCD_ERR_SENDING_DATA";
         case LCD_ERR_INVALID_ROW_IDX:   return (uint8_t*)"LCD_ERR_INVALID_ROW_IDX";
         case LCD_ERR_INVALID_COL_IDX:   return (uint8_t*)"LCD_ERR_INVALID_COL_IDX";
+        case LCD_ERR_FLUSH_TIMEOUT:    	return (uint8_t*)"LCD_ERR_FLUSH_TIMEOUT";
 
         // --- UART ---
         case UART_ERR_INIT:    	return (uint8_t*)"UART_ERR_INIT";
@@ -43,6 +51,12 @@ uint8_t* app_err_to_name(app_err_t err) {
         // --- I2C ---
         case I2C_ERR_TX:    	return (uint8_t*)"I2C_ERR_TX";
         case I2C_ERR_RX:    	return (uint8_t*)"I2C_ERR_RX";
+        case I2C_ERR_QUEUE_FULL:    	return (uint8_t*)"I2C_ERR_QUEUE_FULL";
+        case I2C_ERR_TIMEOUT:    	return (uint8_t*)"I2C_ERR_TIMEOUT";
+        case I2C_ERR_NO_DEVICE:    	return (uint8_t*)"I2C_ERR_NO_DEVICE";
+        case I2C_ERR_TABLE_FULL:    	return (uint8_t*)"I2C_ERR_TABLE_FULL";
+        case I2C_ERR_BUS_STUCK:    	return (uint8_t*)"I2C_ERR_BUS_STUCK";
+        case I2C_ERR_NACK:    	return (uint8_t*)"I2C_ERR_NACK";
 
         // --- CMDParser ---
         case CMDPARSER_ERR_INIT:    		return (uint8_t*)"CMDPARSER_ERR_INIT";
@@ -53,6 +67,23 @@ uint8_t* app_err_to_name(app_err_t err) {
         case CMDPARSER_ERR_INTERNAL:    	return (uint8_t*)"CMDPARSER_ERR_INTERNAL";
         case CMDPARSER_ERR_UNKNOWN:    		return (uint8_t*)"CMDPARSER_ERR_UNKNOWN";
 
+        // --- Scheduler ---
+        case SCHED_ERR_TABLE_FULL:    		return (uint8_t*)"SCHED_ERR_TABLE_FULL";
+        case SCHED_ERR_INVALID_TASK:    	return (uint8_t*)"SCHED_ERR_INVALID_TASK";
+        case SCHED_ERR_INVALID_TIMER:    	return (uint8_t*)"SCHED_ERR_INVALID_TIMER";
+        case TIMEBASE_ERR_NO_CHANNEL:    	return (uint8_t*)"TIMEBASE_ERR_NO_CHANNEL";
+        case TIMEBASE_ERR_INVALID_CHANNEL:	return (uint8_t*)"TIMEBASE_ERR_INVALID_CHANNEL";
+        case TIMERS_ERR_TABLE_FULL:    		return (uint8_t*)"TIMERS_ERR_TABLE_FULL";
+        case TIMERS_ERR_INVALID_TIMER:    	return (uint8_t*)"TIMERS_ERR_INVALID_TIMER";
+        case LATENCY_ERR_TABLE_FULL:    	return (uint8_t*)"LATENCY_ERR_TABLE_FULL";
+        case LATENCY_ERR_INVALID_TYPE:    	return (uint8_t*)"LATENCY_ERR_INVALID_TYPE";
+        case BOOT_ERR_TOO_MANY_PHASES:    	return (uint8_t*)"BOOT_ERR_TOO_MANY_PHASES";
+        case BOOT_ERR_DEPENDENCY:    		return (uint8_t*)"BOOT_ERR_DEPENDENCY";
+        case WATCHDOG_ERR_TABLE_FULL:    	return (uint8_t*)"WATCHDOG_ERR_TABLE_FULL";
+        case WATCHDOG_ERR_INVALID_ACTIVITY:	return (uint8_t*)"WATCHDOG_ERR_INVALID_ACTIVITY";
+        case CLOCK_ERR_BUSY:    			return (uint8_t*)"CLOCK_ERR_BUSY";
+        case CLOCK_ERR_CONFIG:    			return (uint8_t*)"CLOCK_ERR_CONFIG";
+
         default:
         	return (uint8_t*)"UNKNOWN_ERROR";
     }
@@ -0,0 +1,83 @@
+#include "evtrace.h"
+
+#if EVTRACE_ENABLED
+
+#include <stddef.h>
+
+// Ring of records, the next one is written at the low bits of the amount of records written
+static evtrace_record_t records[EVTRACE_LENGTH];
+static volatile uint32_t amount_written = 0;
+
+/**
+ * @brief stores an event in the trace, overwriting the oldest one if the trace is full
+ *
+ * The slot is reserved with an atomic increment (LDREX/STREX on the Cortex-M4), so interrupts are never
+ * disabled and an interrupt that traces while a record is being written takes the next slot. That record
+ * then comes before the interrupted one with a later timestamp.
+ *
+ * @note it can be called from interrupt context
+ *
+ * @param arg: value printed along the event, its meaning depends on the event
+ */
+void evtrace_record(evtrace_id_t id, uint16_t arg) {
+	uint32_t idx = __atomic_fetch_add(&amount_written, 1, __ATOMIC_RELAXED) % EVTRACE_LENGTH;
+
+	records[idx] = (evtrace_record_t){
+			.timestamp = timebase_now_us(),
+			.id = id,
+			.arg = arg,
+	};
+}
+
+/**
+ * @brief copies the latest events, from the oldest one
+ *
+ * The copy is made with interrupts disabled, so no record changes while it is copied
+ *
+ * @param buffer: where the events are copied
+ * @param size: amount of records that fit in buffer
+ * @param written: where the amount of events traced since the last clear is written, the ones beyond
+ * EVTRACE_LENGTH were overwritten. It can be NULL
+ *
+ * @return the amount of events copied
+ */
+uint16_t evtrace_snapshot(evtrace_record_t* buffer, uint16_t size, uint32_t* written) {
+	if (buffer == NULL) {
+		return 0;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t total = amount_written;
+	uint32_t amount = (total < EVTRACE_LENGTH) ? total : EVTRACE_LENGTH;
+	if (amount > size) {
+		amount = size;
+	}
+
+	uint32_t first = total - amount;
+	for (uint32_t idx = 0; idx < amount; idx++) {
+		buffer[idx] = records[(first + idx) % EVTRACE_LENGTH];
+	}
+
+	__set_PRIMASK(primask);
+
+	if (written != NULL) {
+		*written = total;
+	}
+
+	return amount;
+}
+
+/**
+ * @brief discards every traced event
+ *
+ */
+void evtrace_clear() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	amount_written = 0;
+	__set_PRIMASK(primask);
+}
+
+#endif /* EVTRACE_ENABLED */
@@ -25,7 +25,19 @@
 #include <stdint.h>
 #include "API_ht_sensor.h"
 #include "API_cmdparser.h"
+#include "API_actions.h"
 #include "API_lcd.h"
+#include "API_views.h"
+#include "API_scheduler.h"
+#include "API_tasks.h"
+#include "API_timers.h"
+#include "i2c_core.h"
+#include "port.h"
+#include "cycles.h"
+#include "timebase.h"
+#include "power.h"
+#include "boot.h"
+#include "watchdog.h"
 #include "error.h"
 
 /* USER CODE END Includes */
@@ -47,6 +59,7 @@
 
 /* Private variables ---------------------------------------------------------*/
 I2C_HandleTypeDef hi2c1;
+I2C_HandleTypeDef hi2c3;
 
 UART_HandleTypeDef huart2;
 
@@ -59,13 +72,22 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_USART2_UART_Init(void);
 static void MX_I2C1_Init(void);
+static void MX_I2C3_Init(void);
 /* USER CODE BEGIN PFP */
+static app_err_t init_cmdparser_step(uint32_t* wait_us);
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+// Initialization of the devices, their power-on waits run at the same time
+static const boot_phase_t BOOT_PHASES[] = {
+	{(uint8_t*)"UART", init_cmdparser_step, 0},
+	{(uint8_t*)"LCD", lcd_init_step, 0},
+	{(uint8_t*)"AHT20", ht_init_step, 0},
+};
+
 /* USER CODE END 0 */
 
 /**
@@ -99,30 +121,54 @@ int main(void)
   MX_GPIO_Init();
   MX_USART2_UART_Init();
   MX_I2C1_Init();
+  MX_I2C3_Init();
   /* USER CODE BEGIN 2 */
 
-  if (cmdparser_init() != APP_OK) {
+  cycles_init();
+
+  // From here a hang ends in a reset, the start-up must finish within WATCHDOG_TIMEOUT_MS
+  watchdog_init();
+
+  if (timebase_init() != APP_OK) {
 	  HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
 	  while (1);
   }
 
-  if (lcd_init() != APP_OK) {
+  if (port_init(&PORT_HAL_OPS) != APP_OK) {
 	  HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
 	  while (1);
   }
 
-  if (ht_init() != APP_OK) {
+  timers_init();
+
+  if (boot_run(BOOT_PHASES, sizeof(BOOT_PHASES) / sizeof(BOOT_PHASES[0])) != APP_OK) {
 	  HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
 	  while (1);
   }
 
+  views_init();
+
+  if (tasks_init() != APP_OK) {
+	  HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
+	  while (1);
+  }
+
+  power_init();
+  sched_set_idle_hook(power_idle);
+
+  watchdog_reset_info_t reset_info;
+  watchdog_get_reset_info(&reset_info);
+  if (reset_info.cause == WATCHDOG_RESET_IWDG || reset_info.cause == WATCHDOG_RESET_WWDG) {
+	  watchdog_action();
+  }
+
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-	  cmdparser_read_cmd();
+	  sched_run_once();
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -211,6 +257,40 @@ static void MX_I2C1_Init(void)
 
 }
 
+/**
+  * @brief I2C3 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_I2C3_Init(void)
+{
+
+  /* USER CODE BEGIN I2C3_Init 0 */
+
+  /* USER CODE END I2C3_Init 0 */
+
+  /* USER CODE BEGIN I2C3_Init 1 */
+
+  /* USER CODE END I2C3_Init 1 */
+  hi2c3.Instance = I2C3;
+  hi2c3.Init.ClockSpeed = 100000;
+  hi2c3.Init.DutyCycle = I2C_DUTYCYCLE_2;
+  hi2c3.Init.OwnAddress1 = 0;
+  hi2c3.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+  hi2c3.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+  hi2c3.Init.OwnAddress2 = 0;
+  hi2c3.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+  hi2c3.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+  if (HAL_I2C_Init(&hi2c3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN I2C3_Init 2 */
+
+  /* USER CODE END I2C3_Init 2 */
+
+}
+
 /**
   * @brief USART2 Initialization Function
   * @param None
@@ -278,6 +358,10 @@ static void MX_GPIO_Init(void)
   GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
   HAL_GPIO_Init(LD2_GPIO_Port, &GPIO_InitStruct);
 
+  /* EXTI interrupt init*/
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+
   /* USER CODE BEGIN MX_GPIO_Init_2 */
 
   /* USER CODE END MX_GPIO_Init_2 */
@@ -285,6 +369,29 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 
+/**
+  * @brief  Boot phase of the command interface, it is initialized in a single step
+  * @param  wait_us: set to BOOT_STEP_DONE
+  * @retval APP_OK or the error of cmdparser_init()
+  */
+static app_err_t init_cmdparser_step(uint32_t* wait_us)
+{
+  *wait_us = BOOT_STEP_DONE;
+  return cmdparser_init();
+}
+
+/**
+  * @brief  EXTI line detection callback, B1 switches the page shown on the LCD
+  * @param  GPIO_Pin: pin that triggered the interrupt
+  * @retval None
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  if (GPIO_Pin == B1_Pin) {
+	  views_button_pressed();
+  }
+}
+
 /* USER CODE END 4 */
 
 /**
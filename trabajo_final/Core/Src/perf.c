@@ -0,0 +1,100 @@
+#include "perf.h"
+
+#if PERF_ENABLED
+
+#include <stddef.h>
+
+// Zones measured at least once, the most recent first
+static perf_zone_t* zones = NULL;
+
+// Prototypes
+static void clear_zone(perf_zone_t* zone);
+
+/**
+ * @brief records the cycles elapsed since the scope started, it is called by the cleanup of PERF_ZONE()
+ *
+ * @note it can run in interrupt context, the zone is updated with interrupts disabled
+ */
+void perf_scope_end(perf_scope_t* scope) {
+	uint32_t elapsed = cycles_now() - scope->start;
+	perf_zone_t* zone = scope->zone;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (!zone->registered) {
+		clear_zone(zone);
+		zone->next = zones;
+		zones = zone;
+		zone->registered = true;
+	}
+
+	if (zone->count == 0 || elapsed < zone->min_cycles) {
+		zone->min_cycles = elapsed;
+	}
+
+	if (elapsed > zone->max_cycles) {
+		zone->max_cycles = elapsed;
+	}
+
+	zone->count++;
+	zone->total_cycles += elapsed;
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief copies the statistics of the zones measured, in no particular order
+ *
+ * @param buffer: where the statistics are copied
+ * @param size: amount of zones that fit in buffer
+ *
+ * @return the amount of zones copied
+ */
+uint8_t perf_snapshot(perf_zone_info_t* buffer, uint8_t size) {
+	if (buffer == NULL) {
+		return 0;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t amount = 0;
+	for (perf_zone_t* zone = zones; zone != NULL && amount < size; zone = zone->next) {
+		buffer[amount++] = (perf_zone_info_t){
+				.name = zone->name,
+				.count = zone->count,
+				.min_cycles = zone->min_cycles,
+				.max_cycles = zone->max_cycles,
+				.avg_cycles = (zone->count > 0) ? zone->total_cycles / zone->count : 0,
+				.total_cycles = zone->total_cycles,
+		};
+	}
+
+	__set_PRIMASK(primask);
+	return amount;
+}
+
+/**
+ * @brief clears the statistics of every zone, they stay in the report with a count of 0
+ *
+ */
+void perf_reset() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	for (perf_zone_t* zone = zones; zone != NULL; zone = zone->next) {
+		clear_zone(zone);
+	}
+
+	__set_PRIMASK(primask);
+}
+
+void clear_zone(perf_zone_t* zone) {
+	zone->count = 0;
+	zone->min_cycles = 0;
+	zone->max_cycles = 0;
+	zone->total_cycles = 0;
+}
+
+#endif /* PERF_ENABLED */
@@ -0,0 +1,281 @@
+#include "power.h"
+#include "main.h"
+#include "API_scheduler.h"
+#include "clock.h"
+#include "watchdog.h"
+
+// Shortest sleep worth stopping the tick for, shorter ones just wait for the next tick
+#define MIN_SUPPRESSED_TICKS 2
+
+// The wake-up timer of the RTC counts the LSI divided by 16, the same oscillator as the IWDG
+#define LSI_HZ 32000
+#define WAKEUP_CLOCK_DIVIDER 16
+
+// Keys that unlock the write protection of the RTC, any other value locks it again
+#define RTC_KEY_1 0xCA
+#define RTC_KEY_2 0x53
+#define RTC_KEY_LOCK 0xFF
+
+// Prototypes
+static void sleep_tickless(uint32_t ticks);
+static uint32_t get_tick_cycles();
+#if POWER_STOP_ENABLED
+static void init_wakeup_timer();
+static void clear_wakeup_flag();
+static void enter_stop();
+#endif
+
+/**
+ * @brief prepares the wake-up sources of the low-power modes
+ *
+ * With Stop mode enabled, the UART RX pin is routed to EXTI3 on its falling edge, so the start bit of a
+ * character wakes the core. The wake-up timer of the RTC, on EXTI22, wakes it every WATCHDOG_CHECK_PERIOD_MS
+ * to reload the IWDG. Both interrupts are only unmasked while the core is in Stop mode.
+ *
+ */
+void power_init() {
+#if POWER_STOP_ENABLED
+	__HAL_RCC_SYSCFG_CLK_ENABLE();
+	SYSCFG->EXTICR[0] = (SYSCFG->EXTICR[0] & ~SYSCFG_EXTICR1_EXTI3) | SYSCFG_EXTICR1_EXTI3_PA;
+	EXTI->FTSR |= EXTI_FTSR_TR3;
+	EXTI->IMR &= ~EXTI_IMR_MR3;
+
+	HAL_NVIC_SetPriority(EXTI3_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+
+	init_wakeup_timer();
+#endif
+}
+
+/**
+ * @brief idle hook of the scheduler, it sleeps until the next timer deadline or an interrupt
+ *
+ * Sleeps of a single tick are a plain WFI, the next tick wakes the core. Longer ones stop the 1 ms tick and
+ * program SysTick to expire at the deadline, then the tick is advanced by the time actually slept. With
+ * Stop mode enabled and no timer running, the core enters Stop mode until the button or the UART wake it.
+ * The check of the watchdog only runs while a task is busy, so while every task is idle the IWDG is reloaded
+ * here, and no sleep lasts longer than WATCHDOG_CHECK_PERIOD_MS.
+ *
+ * @note it is called by the scheduler with interrupts disabled, an interrupt still ends the sleep and its
+ * handler runs once the scheduler enables them again
+ *
+ * @param max_sleep_ms: time until the next timer expires, SCHED_NO_DEADLINE if none is running
+ */
+void power_idle(uint32_t max_sleep_ms) {
+	watchdog_reload_if_idle();
+
+#if POWER_STOP_ENABLED
+	if (max_sleep_ms == SCHED_NO_DEADLINE) {
+		enter_stop();
+		return;
+	}
+#endif
+
+	if (max_sleep_ms > WATCHDOG_CHECK_PERIOD_MS) {
+		max_sleep_ms = WATCHDOG_CHECK_PERIOD_MS;
+	}
+
+	uint32_t ticks = max_sleep_ms / uwTickFreq;
+	uint32_t max_ticks = (SysTick_LOAD_RELOAD_Msk + 1) / get_tick_cycles();
+	if (ticks > max_ticks) {
+		ticks = max_ticks;
+	}
+
+	if (ticks < MIN_SUPPRESSED_TICKS) {
+		__DSB();
+		__WFI();
+		return;
+	}
+
+	sleep_tickless(ticks);
+}
+
+/**
+ * @brief clears the wake-up interrupt of the UART RX pin, it must be called from EXTI3_IRQHandler
+ *
+ */
+void power_exti_handler() {
+	__HAL_GPIO_EXTI_CLEAR_IT(USART_RX_Pin);
+}
+
+/**
+ * @brief clears the interrupt of the wake-up timer, it must be called from RTC_WKUP_IRQHandler
+ *
+ */
+void power_rtc_handler() {
+#if POWER_STOP_ENABLED
+	clear_wakeup_flag();
+#endif
+}
+
+/**
+ * @brief waits the given milliseconds sleeping between ticks, it replaces the busy wait of the HAL
+ *
+ * @note as the one of the HAL, it must not be called with interrupts disabled
+ */
+void HAL_Delay(uint32_t Delay) {
+	uint32_t start = HAL_GetTick();
+	uint32_t wait = Delay;
+
+	// One more tick is waited so the delay is never shorter than requested, as in the HAL
+	if (wait < HAL_MAX_DELAY) {
+		wait += (uint32_t)uwTickFreq;
+	}
+
+	while ((HAL_GetTick() - start) < wait) {
+		__WFI();
+	}
+}
+
+/**
+ * @brief sleeps up to the given amount of ticks with the tick interrupt suppressed
+ *
+ * SysTick is reloaded with the cycles left of the current tick plus the ticks to sleep, so it only fires at
+ * the deadline. If another interrupt wakes the core earlier, the ticks elapsed are taken from the counter.
+ * Either way SysTick is restarted aligned to the tick it was in, so the tick does not drift.
+ *
+ */
+void sleep_tickless(uint32_t ticks) {
+	uint32_t tick_cycles = get_tick_cycles();
+
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	uint32_t remaining = SysTick->VAL;
+	uint32_t reload = remaining + tick_cycles * (ticks - 1);
+
+	// Writing VAL also clears COUNTFLAG, so it is only set if the sleep reaches the deadline
+	SysTick->LOAD = reload;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+	__DSB();
+	__WFI();
+	__ISB();
+
+	// A write stops the counter without reading CTRL, which would clear COUNTFLAG
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+
+	uint32_t elapsed_ticks;
+	uint32_t next_tick_cycles;
+	if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+		// The pending SysTick interrupt counts the last tick of the sleep
+		uint32_t late = reload - SysTick->VAL;
+		elapsed_ticks = ticks - 1;
+		next_tick_cycles = (late < tick_cycles) ? tick_cycles - late : 1;
+	} else {
+		uint32_t slept = reload - SysTick->VAL;
+		if (slept < remaining) {
+			elapsed_ticks = 0;
+			next_tick_cycles = remaining - slept;
+		} else {
+			elapsed_ticks = 1 + (slept - remaining) / tick_cycles;
+			next_tick_cycles = tick_cycles - (slept - remaining) % tick_cycles;
+		}
+	}
+
+	uwTick += elapsed_ticks * uwTickFreq;
+
+	// The current tick ends after the cycles it has left, then the counter goes back to the tick period
+	SysTick->LOAD = (next_tick_cycles > 1) ? next_tick_cycles - 1 : 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	SysTick->LOAD = tick_cycles - 1;
+}
+
+/**
+ * @brief returns the core cycles of a tick, SysTick runs from HCLK
+ *
+ */
+uint32_t get_tick_cycles() {
+	return SystemCoreClock / (1000U / uwTickFreq);
+}
+
+#if POWER_STOP_ENABLED
+/**
+ * @brief starts the wake-up timer of the RTC with a period of WATCHDOG_CHECK_PERIOD_MS, clocked by the LSI
+ *
+ * The HAL RTC module is not built, so the registers are written directly. The RTC is only used for this
+ * timer, the backup domain is reset if it was clocked from another oscillator. The IWDG counts the same
+ * LSI, so the period stays below its timeout whatever the drift of the oscillator.
+ *
+ */
+void init_wakeup_timer() {
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR |= PWR_CR_DBP;
+
+	RCC->CSR |= RCC_CSR_LSION;
+	while (!(RCC->CSR & RCC_CSR_LSIRDY)) {
+	}
+
+	if ((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_1) {
+		RCC->BDCR |= RCC_BDCR_BDRST;
+		RCC->BDCR &= ~RCC_BDCR_BDRST;
+		RCC->BDCR |= RCC_BDCR_RTCSEL_1;
+	}
+	RCC->BDCR |= RCC_BDCR_RTCEN;
+
+	RTC->WPR = RTC_KEY_1;
+	RTC->WPR = RTC_KEY_2;
+
+	// The reload value can only be written once the timer is stopped
+	RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+	while (!(RTC->ISR & RTC_ISR_WUTWF)) {
+	}
+
+	RTC->WUTR = (LSI_HZ / WAKEUP_CLOCK_DIVIDER) * WATCHDOG_CHECK_PERIOD_MS / 1000 - 1;
+	RTC->CR &= ~RTC_CR_WUCKSEL;
+	clear_wakeup_flag();
+	RTC->CR |= RTC_CR_WUTIE | RTC_CR_WUTE;
+	RTC->WPR = RTC_KEY_LOCK;
+
+	EXTI->RTSR |= EXTI_RTSR_TR22;
+	EXTI->IMR &= ~EXTI_IMR_MR22;
+
+	HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+}
+
+/**
+ * @brief clears the flag of the wake-up timer and its EXTI line, the next period raises them again
+ *
+ */
+void clear_wakeup_flag() {
+	// The flags are cleared writing a zero, INIT is kept as it is
+	RTC->ISR = (~(RTC_ISR_WUTF | RTC_ISR_INIT) & 0xFFFF) | (RTC->ISR & RTC_ISR_INIT);
+	EXTI->PR = EXTI_PR_PR22;
+}
+
+/**
+ * @brief enters Stop mode with the low-power regulator until the button or the UART wake the core
+ *
+ * The wake-up timer of the RTC wakes the core every WATCHDOG_CHECK_PERIOD_MS, then the IWDG is reloaded and
+ * the core goes back to Stop mode on the HSI, without starting the PLL. If a task is busy or the watchdog
+ * expired the IWDG is not reloaded and resets the board.
+ *
+ * The clocks stop, so the tick is not advanced by the time spent in Stop mode. The first character that
+ * wakes the board is lost, the UART is not clocked until the PLL is started again.
+ *
+ */
+void enter_stop() {
+	HAL_SuspendTick();
+	__HAL_GPIO_EXTI_CLEAR_IT(USART_RX_Pin);
+	EXTI->IMR |= EXTI_IMR_MR3 | EXTI_IMR_MR22;
+
+	do {
+		watchdog_reload_if_idle();
+		clear_wakeup_flag();
+		NVIC_ClearPendingIRQ(RTC_WKUP_IRQn);
+
+		HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+		// Only the wake-up timer woke the core if no other unmasked line is pending
+	} while ((RTC->ISR & RTC_ISR_WUTF) && !(EXTI->PR & EXTI->IMR & ~EXTI_PR_PR22));
+
+	EXTI->IMR &= ~(EXTI_IMR_MR3 | EXTI_IMR_MR22);
+	clear_wakeup_flag();
+	NVIC_ClearPendingIRQ(RTC_WKUP_IRQn);
+
+	// The core wakes up on the HSI, the clocks of the profile have to be configured again
+	clock_restore();
+	HAL_ResumeTick();
+}
+#endif
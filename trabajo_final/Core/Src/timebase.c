@@ -0,0 +1,255 @@
+#include "timebase.h"
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Rate of the TIM2 counter
+#define TIMEBASE_FREQUENCY_HZ 1000000
+
+// Waits longer than this sleep between the 1 ms ticks, shorter ones busy wait
+#define SLEEP_THRESHOLD_US 1000
+
+typedef struct {
+	timebase_callback_t callback;
+	void* context;
+	uint32_t deadline;
+} deadline_t;
+
+static deadline_t deadlines[TIMEBASE_CHANNELS];
+
+// Compare register, interrupt enable and flag of each channel
+static volatile uint32_t* const COMPARE_REGS[TIMEBASE_CHANNELS] = {
+		&TIM2->CCR1, &TIM2->CCR2, &TIM2->CCR3, &TIM2->CCR4,
+};
+static const uint32_t CHANNEL_IT[TIMEBASE_CHANNELS] = {
+		TIM_DIER_CC1IE, TIM_DIER_CC2IE, TIM_DIER_CC3IE, TIM_DIER_CC4IE,
+};
+static const uint32_t CHANNEL_FLAG[TIMEBASE_CHANNELS] = {
+		TIM_SR_CC1IF, TIM_SR_CC2IF, TIM_SR_CC3IF, TIM_SR_CC4IF,
+};
+
+// Prototypes
+static uint32_t get_timer_clock();
+static bool is_due(uint32_t deadline, uint32_t now);
+
+/**
+ * @brief starts TIM2 as a free-running 32-bit counter of microseconds
+ *
+ * The compare channels are left in frozen mode, they only raise the interrupt of the one-shot callbacks.
+ * TIM2 is on APB1, whose timers run at twice PCLK1 when its prescaler is not 1.
+ *
+ * @return APP_OK, or APP_ERR_INTERNAL if the timer clock is not a multiple of 1 MHz
+ */
+app_err_t timebase_init() {
+	uint32_t timer_clock = get_timer_clock();
+	if (timer_clock % TIMEBASE_FREQUENCY_HZ != 0) {
+		return APP_ERR_INTERNAL;
+	}
+
+	__HAL_RCC_TIM2_CLK_ENABLE();
+
+	TIM2->CR1 = 0;
+	TIM2->DIER = 0;
+	TIM2->CCMR1 = 0;
+	TIM2->CCMR2 = 0;
+	TIM2->PSC = timer_clock / TIMEBASE_FREQUENCY_HZ - 1;
+	TIM2->ARR = 0xFFFFFFFF;
+	TIM2->CNT = 0;
+
+	// The prescaler is only loaded on an update event
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->SR = 0;
+
+	for (uint8_t channel = 0; channel < TIMEBASE_CHANNELS; channel++) {
+		deadlines[channel].callback = NULL;
+	}
+
+	HAL_NVIC_SetPriority(TIM2_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+	TIM2->CR1 = TIM_CR1_CEN;
+	return APP_OK;
+}
+
+/**
+ * @brief reprograms the prescaler after the APB1 clock changed, the counter goes on from where it was
+ *
+ * The prescaler is only loaded on an update event, which also clears the counter, so the count is written
+ * back and the callbacks whose deadline was reached meanwhile are fired by hand. The time the clocks took to
+ * switch is counted at the rate of the previous prescaler.
+ *
+ * @return APP_OK, or APP_ERR_INTERNAL if the timer clock is not a multiple of 1 MHz
+ */
+app_err_t timebase_update_clock() {
+	uint32_t timer_clock = get_timer_clock();
+	if (timer_clock % TIMEBASE_FREQUENCY_HZ != 0) {
+		return APP_ERR_INTERNAL;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t now = TIM2->CNT;
+	TIM2->PSC = timer_clock / TIMEBASE_FREQUENCY_HZ - 1;
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->CNT = now;
+	// A compare flag cleared here belongs to a deadline already reached, which is fired below
+	TIM2->SR = 0;
+
+	for (uint8_t channel = 0; channel < TIMEBASE_CHANNELS; channel++) {
+		if (deadlines[channel].callback != NULL && is_due(deadlines[channel].deadline, now)) {
+			NVIC_SetPendingIRQ(TIM2_IRQn);
+		}
+	}
+
+	__set_PRIMASK(primask);
+	return APP_OK;
+}
+
+/**
+ * @brief waits the given amount of microseconds, never less
+ *
+ * Long waits sleep until the last millisecond, which is busy waited so the wait ends on time.
+ *
+ * @note it must not be called with interrupts disabled if the wait is longer than SLEEP_THRESHOLD_US
+ */
+void timebase_delay_us(uint32_t us) {
+	uint32_t start = timebase_now_us();
+
+	// One more microsecond is waited because the call may start at the end of the current one
+	uint32_t wait = us + 1;
+
+	while ((timebase_now_us() - start) < wait) {
+		if (wait - (timebase_now_us() - start) > SLEEP_THRESHOLD_US) {
+			__WFI();
+		}
+	}
+}
+
+/**
+ * @brief calls the function from the TIM2 interrupt once the counter reaches the deadline
+ *
+ * @param deadline_us: value of timebase_now_us() at which it is called, within 2^31 us from now. A deadline
+ * already reached is called right after this function returns.
+ * @param channel: where the channel used is written, it can be given to timebase_cancel(), NULL if not needed
+ *
+ * @return
+ * - APP_OK: if the callback is scheduled
+ * - APP_ERR_INVALID_ARG: if callback is NULL
+ * - TIMEBASE_ERR_NO_CHANNEL: if TIMEBASE_CHANNELS callbacks are already pending
+ */
+app_err_t timebase_call_at(uint32_t deadline_us, timebase_callback_t callback, void* context, uint8_t* channel) {
+	if (callback == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t free = 0;
+	while (free < TIMEBASE_CHANNELS && deadlines[free].callback != NULL) {
+		free++;
+	}
+
+	if (free == TIMEBASE_CHANNELS) {
+		__set_PRIMASK(primask);
+		return TIMEBASE_ERR_NO_CHANNEL;
+	}
+
+	deadlines[free] = (deadline_t){
+			.callback = callback,
+			.context = context,
+			.deadline = deadline_us,
+	};
+
+	*COMPARE_REGS[free] = deadline_us;
+	TIM2->SR = ~CHANNEL_FLAG[free];
+	TIM2->DIER |= CHANNEL_IT[free];
+
+	// The compare only matches on equality, a deadline the counter already passed is fired by hand
+	if (is_due(deadline_us, timebase_now_us())) {
+		NVIC_SetPendingIRQ(TIM2_IRQn);
+	}
+
+	__set_PRIMASK(primask);
+
+	if (channel != NULL) {
+		*channel = free;
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief calls the function from the TIM2 interrupt after the given microseconds
+ *
+ * @return the same as timebase_call_at()
+ */
+app_err_t timebase_call_after(uint32_t delay_us, timebase_callback_t callback, void* context, uint8_t* channel) {
+	return timebase_call_at(timebase_now_us() + delay_us, callback, context, channel);
+}
+
+/**
+ * @brief cancels a pending callback, nothing happens if it was already called
+ *
+ * @return APP_OK, or TIMEBASE_ERR_INVALID_CHANNEL if the channel does not exist
+ */
+app_err_t timebase_cancel(uint8_t channel) {
+	if (channel >= TIMEBASE_CHANNELS) {
+		return TIMEBASE_ERR_INVALID_CHANNEL;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	TIM2->DIER &= ~CHANNEL_IT[channel];
+	TIM2->SR = ~CHANNEL_FLAG[channel];
+	deadlines[channel].callback = NULL;
+	__set_PRIMASK(primask);
+
+	return APP_OK;
+}
+
+/**
+ * @brief calls the callbacks whose deadline was reached, it must be called from TIM2_IRQHandler
+ *
+ */
+void timebase_irq_handler() {
+	uint32_t now = timebase_now_us();
+
+	for (uint8_t channel = 0; channel < TIMEBASE_CHANNELS; channel++) {
+		deadline_t* entry = &deadlines[channel];
+		if (entry->callback == NULL) {
+			continue;
+		}
+
+		if (!(TIM2->SR & CHANNEL_FLAG[channel]) && !is_due(entry->deadline, now)) {
+			continue;
+		}
+
+		// The channel is released first, so the callback can schedule itself again
+		timebase_callback_t callback = entry->callback;
+		TIM2->DIER &= ~CHANNEL_IT[channel];
+		TIM2->SR = ~CHANNEL_FLAG[channel];
+		entry->callback = NULL;
+
+		callback(entry->context);
+	}
+}
+
+/**
+ * @brief returns the clock of the APB1 timers
+ *
+ */
+uint32_t get_timer_clock() {
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	return ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1) ? pclk1 : pclk1 * 2;
+}
+
+/**
+ * @brief checks if the counter reached the deadline
+ *
+ * @note the difference is taken as signed, so it is correct when the counter wraps around
+ */
+bool is_due(uint32_t deadline, uint32_t now) {
+	return (int32_t)(now - deadline) >= 0;
+}
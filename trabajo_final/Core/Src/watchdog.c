@@ -0,0 +1,363 @@
+#include "watchdog.h"
+#include "API_timers.h"
+#include "port.h"
+#include "stm32f4xx.h"
+#include <stddef.h>
+
+// Keys of the IWDG key register
+#define KEY_RELOAD 0xAAAA
+#define KEY_WRITE_ACCESS 0x5555
+#define KEY_ENABLE 0xCCCC
+
+// The IWDG counts the LSI divided by 32, about one count per millisecond
+#define LSI_HZ 32000
+#define PRESCALER_DIV_32 3
+#define PRESCALER_DIVIDER 32
+
+// Marks the retained data as written by this firmware, it is garbage after a power-on
+#define RETAINED_MAGIC 0x57444F47
+
+typedef struct {
+	uint8_t* name;
+	uint32_t deadline_ms;
+	volatile uint32_t last_checkin;
+	volatile bool busy;
+} activity_t;
+
+// Kept in RAM across resets, the startup code does not initialize it
+typedef struct {
+	uint32_t magic;
+	uint32_t watchdog_resets;
+	uint8_t stalled[WATCHDOG_NAME_LENGTH + 1];
+} retained_t;
+
+static retained_t retained __attribute__((section(".noinit")));
+
+static activity_t activities[WATCHDOG_MAX_ACTIVITIES];
+static uint8_t amount_of_activities = 0;
+static timer_id_t check_timer;
+
+// The check only runs while an activity is busy, so an idle board has no timer running and can enter Stop mode
+static bool check_armed = false;
+
+static watchdog_reset_info_t reset_info;
+
+// Set once an activity missed its deadline, the IWDG is not reloaded anymore
+static bool expired = false;
+
+// Prototypes
+static watchdog_reset_cause_t get_reset_cause(uint32_t flags);
+static void arm_check();
+static void check_activities(void* context);
+static void copy_name(uint8_t* destination, const uint8_t* source);
+
+/**
+ * @brief reads the cause of the last reset and starts the IWDG
+ *
+ * The IWDG cannot be stopped once started, it resets the core unless it is reloaded within WATCHDOG_TIMEOUT_MS.
+ * Until the scheduler runs nothing reloads it, so the start-up has that long to finish. A hang
+ * with interrupts disabled, such as Error_Handler(), also ends in a reset, though no activity is blamed for it.
+ *
+ * @note it must be called before the peripherals that can hang are used, afterwards the check of the busy
+ * activities and the idle hook reload it
+ */
+void watchdog_init() {
+	uint32_t flags = RCC->CSR;
+	RCC->CSR |= RCC_CSR_RMVF;
+	reset_info.cause = get_reset_cause(flags);
+
+	if (retained.magic != RETAINED_MAGIC || reset_info.cause == WATCHDOG_RESET_POWER_ON
+			|| reset_info.cause == WATCHDOG_RESET_BROWN_OUT) {
+		retained = (retained_t){.magic = RETAINED_MAGIC};
+	}
+
+	reset_info.stalled[0] = '\0';
+	if (reset_info.cause == WATCHDOG_RESET_IWDG) {
+		retained.watchdog_resets++;
+		copy_name(reset_info.stalled, retained.stalled);
+	}
+
+	reset_info.watchdog_resets = retained.watchdog_resets;
+	retained.stalled[0] = '\0';
+
+	// The counter stops while the debugger halts the core
+	DBGMCU->APB1FZ |= DBGMCU_APB1_FZ_DBG_IWDG_STOP;
+
+	IWDG->KR = KEY_ENABLE;
+	IWDG->KR = KEY_WRITE_ACCESS;
+	IWDG->PR = PRESCALER_DIV_32;
+	IWDG->RLR = (LSI_HZ / PRESCALER_DIVIDER) * WATCHDOG_TIMEOUT_MS / 1000;
+
+	// The new values reach the LSI domain after a few of its cycles
+	while (IWDG->SR & (IWDG_SR_PVU | IWDG_SR_RVU));
+
+	IWDG->KR = KEY_RELOAD;
+}
+
+/**
+ * @brief adds an activity to the supervision, it starts idle
+ *
+ * While any activity is busy, the IWDG is reloaded by a check every WATCHDOG_CHECK_PERIOD_MS on the timer
+ * wheel, as long as every busy activity checked in within its deadline. While all of them are idle the check
+ * stops and the idle hook reloads it with watchdog_reload_if_idle().
+ *
+ * @param name: kept across the reset if the activity stalls, only its first WATCHDOG_NAME_LENGTH characters
+ * @param deadline_ms: longest time a busy activity may go without checking in
+ * @param id: where the identifier of the activity is written
+ *
+ * @return
+ * - APP_OK: if the activity is added
+ * - APP_ERR_INVALID_ARG: if a pointer is NULL or the deadline is 0
+ * - WATCHDOG_ERR_TABLE_FULL: if there are already WATCHDOG_MAX_ACTIVITIES activities
+ * - TIMERS_ERR_TABLE_FULL: if the timer wheel is full
+ */
+app_err_t watchdog_register(uint8_t* name, uint32_t deadline_ms, watchdog_id_t* id) {
+	if (name == NULL || id == NULL || deadline_ms == 0) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (amount_of_activities >= WATCHDOG_MAX_ACTIVITIES) {
+		return WATCHDOG_ERR_TABLE_FULL;
+	}
+
+	if (amount_of_activities == 0) {
+		app_err_t err = timers_create(check_activities, NULL, &check_timer);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	activities[amount_of_activities] = (activity_t){
+			.name = name,
+			.deadline_ms = deadline_ms,
+			.last_checkin = port_now(),
+	};
+
+	*id = amount_of_activities++;
+	return APP_OK;
+}
+
+/**
+ * @brief tells that work was handed to the activity, its deadline starts now unless it was busy already
+ *
+ * @note it can be called from interrupt context, usually by whoever posts the work
+ */
+void watchdog_expect(watchdog_id_t id) {
+	if (id >= amount_of_activities) {
+		return;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	activity_t* activity = &activities[id];
+	if (!activity->busy) {
+		activity->last_checkin = port_now();
+		activity->busy = true;
+		arm_check();
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief tells that the activity made progress, it is called by the activity itself
+ *
+ * @param done: true if the activity has nothing left to do, it is not supervised until the next
+ * watchdog_expect(). Otherwise its deadline starts again
+ */
+void watchdog_checkin(watchdog_id_t id, bool done) {
+	if (id >= amount_of_activities) {
+		return;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	activities[id].last_checkin = port_now();
+	activities[id].busy = !done;
+	if (!done) {
+		arm_check();
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief reloads the IWDG if no activity is busy, it is called by the idle hook before the core sleeps
+ *
+ * Nothing can be stalled then, and reaching the idle hook shows the main loop is running. Busy activities are
+ * left to the check, which reloads it only if they keep their deadlines.
+ *
+ * @note it must be called at least every WATCHDOG_CHECK_PERIOD_MS while the board is idle
+ */
+void watchdog_reload_if_idle() {
+	if (expired) {
+		return;
+	}
+
+	for (uint8_t idx = 0; idx < amount_of_activities; idx++) {
+		if (activities[idx].busy) {
+			return;
+		}
+	}
+
+	IWDG->KR = KEY_RELOAD;
+}
+
+/**
+ * @brief returns the cause of the last reset, read by watchdog_init()
+ *
+ */
+void watchdog_get_reset_info(watchdog_reset_info_t* info) {
+	if (info != NULL) {
+		*info = reset_info;
+	}
+}
+
+uint8_t watchdog_get_amount_of_activities() {
+	return amount_of_activities;
+}
+
+/**
+ * @brief returns the state of an activity
+ *
+ * @param idx: index of the activity, from 0 to watchdog_get_amount_of_activities() - 1
+ *
+ * @return
+ * - APP_OK: if the information is written
+ * - APP_ERR_INVALID_ARG: if info is NULL
+ * - WATCHDOG_ERR_INVALID_ACTIVITY: if idx is out of range
+ */
+app_err_t watchdog_get_activity_info(uint8_t idx, watchdog_activity_info_t* info) {
+	if (info == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (idx >= amount_of_activities) {
+		return WATCHDOG_ERR_INVALID_ACTIVITY;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	activity_t* activity = &activities[idx];
+	info->name = activity->name;
+	info->deadline_ms = activity->deadline_ms;
+	info->since_checkin_ms = port_now() - activity->last_checkin;
+	info->busy = activity->busy;
+
+	__set_PRIMASK(primask);
+	return APP_OK;
+}
+
+/**
+ * @brief decodes the reset flags of RCC_CSR
+ *
+ * The pin flag is set along with every other cause, since the reset is driven out on NRST, so it is checked last
+ *
+ */
+watchdog_reset_cause_t get_reset_cause(uint32_t flags) {
+	if (flags & RCC_CSR_IWDGRSTF) {
+		return WATCHDOG_RESET_IWDG;
+	}
+
+	if (flags & RCC_CSR_WWDGRSTF) {
+		return WATCHDOG_RESET_WWDG;
+	}
+
+	if (flags & RCC_CSR_LPWRRSTF) {
+		return WATCHDOG_RESET_LOW_POWER;
+	}
+
+	if (flags & RCC_CSR_SFTRSTF) {
+		return WATCHDOG_RESET_SOFTWARE;
+	}
+
+	if (flags & RCC_CSR_PORRSTF) {
+		return WATCHDOG_RESET_POWER_ON;
+	}
+
+	if (flags & RCC_CSR_BORRSTF) {
+		return WATCHDOG_RESET_BROWN_OUT;
+	}
+
+	if (flags & RCC_CSR_PINRSTF) {
+		return WATCHDOG_RESET_PIN;
+	}
+
+	return WATCHDOG_RESET_UNKNOWN;
+}
+
+/**
+ * @brief starts the periodic check if it is not running, the IWDG is reloaded so the first period is a full one
+ *
+ * @note it is called with interrupts disabled
+ */
+void arm_check() {
+	if (check_armed || expired) {
+		return;
+	}
+
+	if (timers_start(check_timer, WATCHDOG_CHECK_PERIOD_MS, WATCHDOG_CHECK_PERIOD_MS) == APP_OK) {
+		check_armed = true;
+		IWDG->KR = KEY_RELOAD;
+	}
+}
+
+/**
+ * @brief callback of the timer wheel, it reloads the IWDG if no busy activity is past its deadline
+ *
+ * Otherwise the activity furthest past its deadline is kept as the stalled one and the IWDG is left to expire.
+ * Once no activity is busy the check stops until one is busy again, with interrupts disabled so an activity
+ * that becomes busy meanwhile arms it again.
+ *
+ */
+void check_activities(void* context) {
+	if (expired) {
+		return;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t now = port_now();
+	activity_t* stalled = NULL;
+	uint32_t stalled_overdue = 0;
+	bool any_busy = false;
+
+	for (uint8_t idx = 0; idx < amount_of_activities; idx++) {
+		activity_t* activity = &activities[idx];
+		uint32_t elapsed = now - activity->last_checkin;
+		any_busy |= activity->busy;
+
+		if (activity->busy && elapsed > activity->deadline_ms && elapsed - activity->deadline_ms >= stalled_overdue) {
+			stalled = activity;
+			stalled_overdue = elapsed - activity->deadline_ms;
+		}
+	}
+
+	if (stalled != NULL) {
+		copy_name(retained.stalled, stalled->name);
+		expired = true;
+	} else {
+		IWDG->KR = KEY_RELOAD;
+	}
+
+	if (!any_busy) {
+		timers_stop(check_timer);
+		check_armed = false;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+void copy_name(uint8_t* destination, const uint8_t* source) {
+	uint8_t length = 0;
+	while (length < WATCHDOG_NAME_LENGTH && source[length] != '\0') {
+		destination[length] = source[length];
+		length++;
+	}
+
+	destination[length] = '\0';
+}
@@ -17,4 +17,22 @@ app_err_t show_measurement_action(ht_measurement_t* measurement);
 
 app_err_t reset_action();
 
+app_err_t trace_action(uint8_t* target);
+
+app_err_t scan_action();
+
+app_err_t devices_action();
+
+app_err_t tasks_action(uint8_t* option);
+
+app_err_t perf_action(uint8_t* option);
+
+app_err_t latency_action(uint8_t* option);
+
+app_err_t boot_action();
+
+app_err_t watchdog_action();
+
+app_err_t clock_action(uint8_t* option);
+
 #endif /* API_INC_API_ACTIONS_H_ */
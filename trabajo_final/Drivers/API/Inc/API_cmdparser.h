@@ -2,6 +2,7 @@
 #define API_INC_API_CMDPARSER_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "error.h"
 
 #define CMDPARSER_ERR_INIT (ERR_BASE_CMDPARSER + 1)
@@ -12,8 +13,13 @@
 #define CMDPARSER_ERR_INTERNAL (ERR_BASE_CMDPARSER + 6)
 #define CMDPARSER_ERR_UNKNOWN (ERR_BASE_CMDPARSER + 7)
 
+// Returned by cmdparser_read_cmd() when it waits for characters from the UART
+#define CMDPARSER_WAIT_INPUT UINT32_MAX
+
 app_err_t cmdparser_init();
 
-void cmdparser_read_cmd();
+uint32_t cmdparser_read_cmd();
+
+uint8_t* cmdparser_get_state_name(uint8_t state);
 
 #endif /* API_INC_API_CMDPARSER_H_ */
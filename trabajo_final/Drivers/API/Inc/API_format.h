@@ -0,0 +1,19 @@
+#ifndef API_INC_API_FORMAT_H_
+#define API_INC_API_FORMAT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FMT_MAX_PRECISION 6
+
+uint8_t fmt_uint(uint8_t* buffer, uint8_t size, uint32_t value, uint8_t width);
+
+uint8_t fmt_fixed(uint8_t* buffer, uint8_t size, int32_t value, uint8_t precision, uint8_t width);
+
+uint8_t fmt_double(uint8_t* buffer, uint8_t size, double value, uint8_t precision, uint8_t width);
+
+uint8_t fmt_hex(uint8_t* buffer, uint8_t size, uint32_t value, uint8_t digits);
+
+int32_t fmt_double_to_fixed(double value, uint8_t precision);
+
+#endif /* API_INC_API_FORMAT_H_ */
@@ -12,6 +12,12 @@
 #define HT_ERR_RESET (ERR_BASE_HTSENSOR + 5)
 #define HT_ERR_READ_MEASUREMENT (ERR_BASE_HTSENSOR + 6)
 
+// Time the AHT20 needs from the trigger until the measurement can be read
+#define HT_MEASUREMENT_TIME_US 80000
+
+// Written by ht_init_step() when the sensor is initialized
+#define HT_INIT_DONE UINT32_MAX
+
 typedef enum {
 	TEMP_OP,
 	HUM_OP,
@@ -41,10 +47,14 @@ typedef struct {
 
 app_err_t ht_init();
 
+app_err_t ht_init_step(uint32_t* wait_us);
+
 app_err_t ht_query_init(ht_query_t* query, uint8_t* operation, uint8_t* unit);
 
 app_err_t ht_trigger_measurement(ht_query_t query);
 
+uint32_t ht_get_measurement_wait();
+
 app_err_t ht_read_measurement(ht_measurement_t* measurement);
 
 app_err_t ht_reset();
@@ -0,0 +1,51 @@
+#ifndef API_INC_API_LATENCY_H_
+#define API_INC_API_LATENCY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+#define LATENCY_ERR_TABLE_FULL (ERR_BASE_LATENCY + 1)
+#define LATENCY_ERR_INVALID_TYPE (ERR_BASE_LATENCY + 2)
+
+// Kinds of commands with their own histogram
+#define LATENCY_MAX_TYPES 16
+
+// Bucket 0 holds latencies under 2 us, bucket k from 2^k to 2^(k+1) us, and the last one everything above
+#define LATENCY_BUCKETS 24
+
+// Timebase microseconds when the last byte of the command arrived, when it was parsed and executed, and when
+// the first byte of the reply was sent. The timebase keeps counting across a change of the clock profile.
+typedef struct {
+	uint32_t rx;
+	uint32_t parse;
+	uint32_t exec;
+	uint32_t reply;
+} latency_stamps_t;
+
+/*
+ * Latency of a kind of command, in microseconds. Percentiles are the upper bound of the bucket they fall in,
+ * capped to the maximum, so they are at most twice the real value. The averages split the latency in the
+ * time until the line is parsed, the parsing and the execution until the reply.
+ */
+typedef struct {
+	uint8_t* name;
+	uint32_t count;
+	uint32_t p50_us;
+	uint32_t p90_us;
+	uint32_t p99_us;
+	uint32_t max_us;
+	uint32_t avg_queue_us;
+	uint32_t avg_parse_us;
+	uint32_t avg_exec_us;
+} latency_info_t;
+
+app_err_t latency_record(uint8_t* name, const latency_stamps_t* stamps);
+
+uint8_t latency_get_amount_of_types();
+
+app_err_t latency_get_info(uint8_t idx, latency_info_t* info);
+
+void latency_reset();
+
+#endif /* API_INC_API_LATENCY_H_ */
@@ -10,9 +10,49 @@
 #define LCD_ERR_SENDING_DATA (ERR_BASE_LCD + 3)
 #define LCD_ERR_INVALID_ROW_IDX (ERR_BASE_LCD + 4)
 #define LCD_ERR_INVALID_COL_IDX (ERR_BASE_LCD + 5)
+#define LCD_ERR_FLUSH_TIMEOUT (ERR_BASE_LCD + 6)
+
+// Supported panels, select one at build time with -DLCD_PROFILE=LCD_PROFILE_20X4
+#define LCD_PROFILE_16X2 0
+#define LCD_PROFILE_20X4 1
+#define LCD_PROFILE_40X2 2
+
+#ifndef LCD_PROFILE
+#define LCD_PROFILE LCD_PROFILE_16X2
+#endif
+
+#if LCD_PROFILE == LCD_PROFILE_16X2
+#define LCD_ROWS 2
+#define LCD_COLS 16
+#elif LCD_PROFILE == LCD_PROFILE_20X4
+#define LCD_ROWS 4
+#define LCD_COLS 20
+#elif LCD_PROFILE == LCD_PROFILE_40X2
+#define LCD_ROWS 2
+#define LCD_COLS 40
+#else
+#error "Unknown LCD_PROFILE"
+#endif
+
+// Minimum time between two refreshes of the frame, updates submitted in between are coalesced
+#define LCD_MIN_REFRESH_MS 250
+
+// Returned by lcd_get_refresh_delay() when there is no frame waiting for lcd_refresh()
+#define LCD_NO_REFRESH UINT32_MAX
+
+// Written by lcd_init_step() when the LCD is initialized
+#define LCD_INIT_DONE UINT32_MAX
+
+// Called when a frame becomes pending, it can be called from interrupt context
+typedef void (*lcd_update_callback_t)();
+
+// HD44780 DDRAM layout: odd rows start at 0x40, rows 2 and 3 continue rows 0 and 1 after LCD_COLS characters
+#define LCD_ROW_ADDRESS(row) ((((row) & 1) * 0x40) + (((row) >> 1) * LCD_COLS))
 
 app_err_t lcd_init();
 
+app_err_t lcd_init_step(uint32_t* wait_us);
+
 app_err_t lcd_clear_screen();
 
 app_err_t lcd_set_cursor(uint8_t row, uint8_t col);
@@ -21,4 +61,14 @@ app_err_t lcd_print(uint8_t* message);
 
 app_err_t lcd_println(uint8_t* message);
 
+app_err_t lcd_update_row(uint8_t row, uint8_t* text);
+
+app_err_t lcd_refresh();
+
+uint32_t lcd_get_refresh_delay();
+
+void lcd_set_update_callback(lcd_update_callback_t callback);
+
+app_err_t lcd_flush();
+
 #endif /* API_INC_API_LCD_H_ */
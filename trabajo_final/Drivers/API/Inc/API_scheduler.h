@@ -0,0 +1,74 @@
+#ifndef API_INC_API_SCHEDULER_H_
+#define API_INC_API_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+#define SCHED_ERR_TABLE_FULL (ERR_BASE_SCHEDULER + 1)
+#define SCHED_ERR_INVALID_TASK (ERR_BASE_SCHEDULER + 2)
+#define SCHED_ERR_INVALID_TIMER (ERR_BASE_SCHEDULER + 3)
+
+#define SCHED_MAX_TASKS 8
+#define SCHED_MAX_TIMERS 8
+
+// Returned by sched_get_sleep_time() when no timer is running
+#define SCHED_NO_DEADLINE UINT32_MAX
+
+/*
+ * Run-to-completion scheduler. A task runs when events are posted to it, either by another task, an
+ * interrupt or one of its timers, and it returns once they are handled. Events are bit flags, so posting
+ * one that is still pending is coalesced with it. Among the ready tasks the one with the highest priority
+ * runs first, tasks of the same priority take turns.
+ */
+typedef enum {
+	SCHED_PRIORITY_LOW,
+	SCHED_PRIORITY_NORMAL,
+	SCHED_PRIORITY_HIGH,
+	SCHED_PRIORITY_COUNT,
+} sched_priority_t;
+
+typedef uint8_t sched_task_id_t;
+typedef uint8_t sched_timer_id_t;
+
+// Runs the task, events are the flags posted since its last run
+typedef void (*sched_handler_t)(uint32_t events);
+
+// Called with interrupts disabled when no task is ready, it may sleep up to max_sleep_ms or until an interrupt
+typedef void (*sched_idle_hook_t)(uint32_t max_sleep_ms);
+
+// Run-time of a task since the last sched_reset_stats(), load is the share of that time in per mille
+typedef struct {
+	uint8_t* name;
+	sched_priority_t priority;
+	uint32_t runs;
+	uint32_t run_ms;
+	uint32_t max_run_us;
+	uint16_t load;
+} sched_task_info_t;
+
+app_err_t sched_task_create(uint8_t* name, sched_handler_t handler, sched_priority_t priority, sched_task_id_t* id);
+
+app_err_t sched_post(sched_task_id_t id, uint32_t events);
+
+app_err_t sched_timer_create(sched_task_id_t task, uint32_t events, sched_timer_id_t* id);
+
+app_err_t sched_timer_start(sched_timer_id_t id, uint32_t delay_ms, uint32_t period_ms);
+
+app_err_t sched_timer_stop(sched_timer_id_t id);
+
+void sched_set_idle_hook(sched_idle_hook_t hook);
+
+void sched_run_once();
+
+uint32_t sched_get_sleep_time();
+
+uint8_t sched_get_amount_of_tasks();
+
+app_err_t sched_get_task_info(uint8_t idx, sched_task_info_t* info);
+
+uint32_t sched_get_stats_window();
+
+void sched_reset_stats();
+
+#endif /* API_INC_API_SCHEDULER_H_ */
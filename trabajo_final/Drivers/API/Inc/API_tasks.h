@@ -0,0 +1,18 @@
+#ifndef API_INC_API_TASKS_H_
+#define API_INC_API_TASKS_H_
+
+#include <stdint.h>
+#include "error.h"
+
+// Period of the I2C timeout check while there are transfers in progress
+#define TASKS_I2C_CHECK_PERIOD_MS 5
+
+// Longest time a task with work may go without running before the watchdog resets the board. The CMD task
+// blocks while a report is sent, up to 7 s for TRACE EVENTS at 9600 bit/s, and the other tasks wait behind it
+#define TASKS_CMD_DEADLINE_MS 10000
+#define TASKS_LCD_DEADLINE_MS 15000
+#define TASKS_I2C_DEADLINE_MS 15000
+
+app_err_t tasks_init();
+
+#endif /* API_INC_API_TASKS_H_ */
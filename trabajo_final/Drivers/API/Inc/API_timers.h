@@ -0,0 +1,38 @@
+#ifndef API_INC_API_TIMERS_H_
+#define API_INC_API_TIMERS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+#define TIMERS_ERR_TABLE_FULL (ERR_BASE_TIMERS + 1)
+#define TIMERS_ERR_INVALID_TIMER (ERR_BASE_TIMERS + 2)
+
+#define TIMERS_MAX 32
+
+// Returned by timers_get_sleep_time() when no timer is running
+#define TIMERS_NO_EXPIRY UINT32_MAX
+
+/*
+ * Software timers on a hierarchical timer wheel with a resolution of 1 ms. Starting, stopping and expiring a
+ * timer take constant time whatever the amount of timers running, and all of them are advanced by a single
+ * call to timers_process() per tick, made from the tick interrupt on the board.
+ */
+typedef uint8_t timer_id_t;
+
+// Called from timers_process() when the timer expires, on the board it is interrupt context
+typedef void (*timer_callback_t)(void* context);
+
+void timers_init();
+
+app_err_t timers_create(timer_callback_t callback, void* context, timer_id_t* id);
+
+app_err_t timers_start(timer_id_t id, uint32_t delay_ms, uint32_t period_ms);
+
+app_err_t timers_stop(timer_id_t id);
+
+void timers_process();
+
+uint32_t timers_get_sleep_time();
+
+#endif /* API_INC_API_TIMERS_H_ */
@@ -9,13 +9,32 @@
 #define UART_ERR_TX   (ERR_BASE_UART + 2)
 #define UART_ERR_RX   (ERR_BASE_UART + 3)
 
+// Characters received and not read yet, the ones arriving when it is full are dropped
+#define UART_RX_BUFFER_SIZE 64
+
+// Called from the UART interrupt every time a character is received
+typedef void (*uart_rx_callback_t)();
+
+// Called right before a string is sent
+typedef void (*uart_tx_callback_t)();
+
 app_err_t uartInit();
 
+app_err_t uartUpdateBaudRate();
+
 app_err_t uartSendString(uint8_t* pstring);
 
 app_err_t uartSendStringSize(uint8_t* pstring, uint16_t size);
 
-app_err_t uartReceiveStringSize(uint8_t* pstring, uint16_t size);
+app_err_t uartReceiveStringSize(uint8_t* pstring, uint16_t size, uint16_t* received);
+
+uint32_t uartGetRxTimeUs();
+
+void uartSetRxCallback(uart_rx_callback_t callback);
+
+void uartSetTxCallback(uart_tx_callback_t callback);
+
+void uartIRQHandler();
 
 
 #endif /* API_INC_API_UART_H_ */
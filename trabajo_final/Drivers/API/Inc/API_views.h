@@ -0,0 +1,35 @@
+#ifndef API_INC_API_VIEWS_H_
+#define API_INC_API_VIEWS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "API_ht_sensor.h"
+#include "error.h"
+
+// Minimum time between two accepted presses of the B1 button
+#define VIEWS_DEBOUNCE_MS 200
+
+// Called from the EXTI interrupt when a press is accepted, views_process() must run after it
+typedef void (*views_button_callback_t)();
+
+typedef enum {
+	VIEW_CURRENT,
+	VIEW_MIN_MAX,
+	VIEW_DERIVED,
+	VIEW_LINK,
+	VIEW_COUNT,
+} view_page_t;
+
+void views_init();
+
+app_err_t views_show_measurement(ht_measurement_t* measurement);
+
+void views_record_read(app_err_t err);
+
+void views_button_pressed();
+
+void views_set_button_callback(views_button_callback_t callback);
+
+app_err_t views_process();
+
+#endif /* API_INC_API_VIEWS_H_ */
@@ -1,12 +1,48 @@
 #include "API_actions.h"
 #include "API_uart.h"
 #include "API_ht_sensor.h"
-#include "API_lcd.h"
+#include "API_views.h"
+#include "API_format.h"
+#include "i2c_core.h"
+#include "i2c_trace.h"
+#include "API_scheduler.h"
+#include "API_latency.h"
+#include "cycles.h"
+#include "perf.h"
+#include "evtrace.h"
+#include "boot.h"
+#include "watchdog.h"
+#include "clock.h"
 #include <string.h>
-#include <stdio.h>
-#include <math.h>
 
-#define MAX_MESSAGE_LENGTH 16
+#define REPORT_LINE_LENGTH 64
+
+// Column where the numbers of a TASKS line start, after the task name
+#define TASK_NAME_WIDTH 8
+
+// Column where the numbers of a PERF line start, after the zone name
+#define PERF_NAME_WIDTH 24
+
+// Column where the numbers of a LATENCY line start, after the command name
+#define LATENCY_NAME_WIDTH 8
+
+// Column where the numbers of a BOOT line start, after the phase name
+#define BOOT_NAME_WIDTH 8
+
+// Column where the state of a WDT line starts, after the activity name
+#define WATCHDOG_NAME_WIDTH 8
+
+// Line of a multi-line report, it starts with a line break and is sent with line_send()
+typedef struct {
+	uint8_t text[REPORT_LINE_LENGTH];
+	uint8_t length;
+} report_line_t;
+
+// Devices that SCAN can name
+typedef struct {
+	uint16_t address;
+	uint8_t* name;
+} known_device_t;
 
 static uint8_t HELP_RESPONSE[] =
 		"\r\nCOMMANDS:\r\n"
@@ -17,16 +53,105 @@ static uint8_t HELP_RESPONSE[] =
 			"\t\t - HUM\r\n"
 			"\t\t - TEMP&HUM\r\n"
 			"\t OBS: It is used to specify in which unit the temperature is, by default is Celsius (C) but other options are: K (Kelvin) or F (Farenheit) \r\n"
-			"\tRESET: resets the AHT20 sensor";
+			"\tRESET: resets the AHT20 sensor\r\n"
+			"\tTRACE I2C: prints the last I2C transfers as: start (us), address, W/R, bytes, duration (us), result\r\n"
+			"\tTRACE EVENTS: dumps the event trace as hexadecimal records for the evtrace_decode host tool\r\n"
+			"\tSCAN: looks for devices on every I2C bus, registered ones are marked with *\r\n"
+			"\tDEVICES: prints the registered I2C devices as: address, bus, speed (kHz), completed, NACKs, errors, "
+			"average and max latency (us)\r\n"
+			"\tTASKS [RESET]: prints the scheduler tasks as: name, priority, runs, run time (ms), max run time (us), "
+			"load (per mille). RESET starts a new measurement window\r\n"
+			"\tPERF [RESET]: prints the profiling zones, the slowest in total first, as: name, count, min, average and "
+			"max cycles. RESET clears them\r\n"
+			"\tLATENCY [RESET]: prints the latency from the end of each kind of command to its reply as: name, count, "
+			"p50, p90, p99 and max (us), then the average time (us) until it is parsed, parsing and executing. "
+			"RESET clears them\r\n"
+			"\tBOOT: prints the time (us) at which the last boot finished, then its phases as: name, start, ready "
+			"and busy time (us), steps\r\n"
+			"\tWDT: prints the cause of the last reset and the task that stalled if the watchdog caused it, then "
+			"the supervised tasks as: name, BUSY/IDLE, deadline and time since the last check-in (ms)\r\n"
+			"\tCLOCK [PROFILE]: prints the clock profile with its core and APB clocks (MHz) and flash wait states. "
+			"PROFILE switches to PERFORMANCE (180 MHz), BALANCED (84 MHz) or LOW (16 MHz)";
+
+static uint8_t TRACE_I2C_TARGET[] = "I2C";
+static uint8_t TRACE_EVENTS_TARGET[] = "EVENTS";
+static uint8_t NO_DEVICES_MSG[] = "\r\nNO DEVICES";
+static uint8_t TASKS_RESET_OPTION[] = "RESET";
+static uint8_t TASKS_RESET_MSG[] = "\r\nTASK STATS RESET";
+static uint8_t PERF_RESET_OPTION[] = "RESET";
+static uint8_t LATENCY_RESET_OPTION[] = "RESET";
+static uint8_t LATENCY_RESET_MSG[] = "\r\nLATENCY STATS RESET";
+static uint8_t LATENCY_EMPTY_MSG[] = "\r\nNO COMMANDS";
+
+// Letter of each scheduler priority in the TASKS report
+static uint8_t* PRIORITY_NAMES[SCHED_PRIORITY_COUNT] = {
+		(uint8_t*)"L",
+		(uint8_t*)"N",
+		(uint8_t*)"H",
+};
 
+// Name of each reset cause in the WDT report
+static uint8_t* RESET_CAUSE_NAMES[WATCHDOG_RESET_COUNT] = {
+		(uint8_t*)"UNKNOWN",
+		(uint8_t*)"POWER-ON",
+		(uint8_t*)"PIN",
+		(uint8_t*)"BROWN-OUT",
+		(uint8_t*)"SOFTWARE",
+		(uint8_t*)"IWDG",
+		(uint8_t*)"WWDG",
+		(uint8_t*)"LOW-POWER",
+};
 
-static uint8_t TEMP_MSG_TEMPLATE[] = "TEMP: %.2f";
-static uint8_t HUM_MSG_TEMPLATE[] = "HUM: %.2f";
+// Name of each clock profile, as given to CLOCK and in its report
+static uint8_t* CLOCK_PROFILE_NAMES[CLOCK_PROFILE_COUNT] = {
+		(uint8_t*)"PERFORMANCE",
+		(uint8_t*)"BALANCED",
+		(uint8_t*)"LOW",
+};
 
-// Codes to display % and ° correctly in the LCD
-static uint8_t PERCENTAGE_SYMBOL_CODE = 0x25;
-static uint8_t DEGREE_SYMBOL_CODE = 0xDF;
+static const known_device_t KNOWN_DEVICES[] = {
+		{0x27, (uint8_t*)"PCF8574 LCD"},
+		{0x38, (uint8_t*)"AHT20"},
+		{0x3F, (uint8_t*)"PCF8574A LCD"},
+};
 
+#if I2C_TRACE_ENABLED
+static uint8_t TRACE_EMPTY_MSG[] = "\r\nNO TRANSFERS";
+
+// Copy of the trace being printed, it is too large for the stack
+static i2c_trace_record_t trace_records[I2C_TRACE_LENGTH];
+#else
+static uint8_t TRACE_DISABLED_MSG[] = "\r\nTRACE DISABLED";
+#endif
+
+#if EVTRACE_ENABLED
+// Header and end of the dump, the decoder looks for them in the captured output
+static uint8_t EVENTS_HEADER[] = "EVTRACE ";
+static uint8_t EVENTS_END_MSG[] = "\r\nEVTRACE END";
+
+// Copy of the event trace being dumped, it is too large for the stack
+static evtrace_record_t event_records[EVTRACE_LENGTH];
+#else
+static uint8_t EVENTS_DISABLED_MSG[] = "\r\nEVENTS DISABLED";
+#endif
+
+#if PERF_ENABLED
+static uint8_t PERF_RESET_MSG[] = "\r\nPERF STATS RESET";
+static uint8_t PERF_EMPTY_MSG[] = "\r\nNO ZONES";
+#else
+static uint8_t PERF_DISABLED_MSG[] = "\r\nPERF DISABLED";
+#endif
+
+// Prototypes
+static void line_start(report_line_t* line);
+static void line_append_text(report_line_t* line, uint8_t* text);
+static void line_append_uint(report_line_t* line, uint32_t value, uint8_t width);
+static void line_append_hex(report_line_t* line, uint32_t value, uint8_t digits);
+static void line_pad(report_line_t* line, uint8_t column);
+static app_err_t line_send(report_line_t* line);
+static app_err_t dump_events();
+static bool is_registered(i2c_bus_id_t bus, uint16_t address);
+static uint8_t* get_known_name(uint16_t address);
 
 /**
  * @brief prints the commands that cmdparser accepts
@@ -89,34 +214,125 @@ app_err_t read_measurement_action(ht_measurement_t* measurement) {
  *  - APP_ERR_INTERNAL: in case of an error
  */
 app_err_t show_measurement_action(ht_measurement_t* measurement) {
+	PERF_ZONE(show_measurement_action);
+
 	if (measurement == NULL) {
 		return APP_ERR_INVALID_ARG;
 	}
 
-	if (lcd_clear_screen() != APP_OK) {
-		return APP_ERR_INTERNAL;
+	return views_show_measurement(measurement);
+}
+
+/**
+ * @brief performs the reset action
+ *
+ * @return APP_OK if the action is executed correctly, otherwise the corresponding error
+ *
+ */
+app_err_t reset_action() {
+	return ht_reset();
+}
+
+/**
+ * @brief prints the trace of the given target
+ *
+ * The I2C trace is printed one transfer per line from the oldest one, the event trace is dumped for the host
+ * decoder. The traces are kept after printing them.
+ *
+ * @param target: traced module, I2C or EVENTS
+ *
+ * @return
+ *  - APP_OK: if the action is executed correctly
+ *  - APP_ERR_INVALID_ARG: if target is not a traced module
+ */
+app_err_t trace_action(uint8_t* target) {
+	if (target != NULL && !strcmp((char*)target, (char*)TRACE_EVENTS_TARGET)) {
+		return dump_events();
 	}
 
-	if (!isnan(measurement->temp_data.temp)) {
-		uint8_t temperature_msg[MAX_MESSAGE_LENGTH] = {0};
-		snprintf((char*)temperature_msg, MAX_MESSAGE_LENGTH, (char*)TEMP_MSG_TEMPLATE, measurement->temp_data.temp);
+	if (target == NULL || strcmp((char*)target, (char*)TRACE_I2C_TARGET)) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+#if I2C_TRACE_ENABLED
+	uint8_t amount = i2c_trace_snapshot(trace_records, I2C_TRACE_LENGTH);
+	if (amount == 0) {
+		return uartSendString(TRACE_EMPTY_MSG);
+	}
 
-		uint8_t msg_length = strlen((char*)temperature_msg);
-		temperature_msg[msg_length] = DEGREE_SYMBOL_CODE;
-		temperature_msg[msg_length + 1] = *measurement->temp_data.unit;
+	for (uint8_t idx = 0; idx < amount; idx++) {
+		i2c_trace_record_t* record = &trace_records[idx];
+		report_line_t line;
 
-		if (lcd_println(temperature_msg) != APP_OK) {
-			return APP_ERR_INTERNAL;
+		line_start(&line);
+		line_append_uint(&line, cycles_to_us(record->timestamp), 10);
+		line_append_text(&line, (uint8_t*)" ");
+		line_append_hex(&line, record->address, 2);
+		line_append_text(&line, (record->direction == I2C_TRACE_READ) ? (uint8_t*)" R " : (uint8_t*)" W ");
+		line_append_uint(&line, record->length, 3);
+		line_append_text(&line, (uint8_t*)" ");
+		line_append_uint(&line, cycles_to_us(record->duration), 6);
+		line_append_text(&line, (uint8_t*)" ");
+		line_append_text(&line, (record->result == APP_OK) ? (uint8_t*)"OK" : app_err_to_name(record->result));
+
+		app_err_t err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
 		}
 	}
 
-	if (!isnan(measurement->hum)) {
-		uint8_t humidity_msg[MAX_MESSAGE_LENGTH] = {0};
-		snprintf((char*)humidity_msg, MAX_MESSAGE_LENGTH, (char*)HUM_MSG_TEMPLATE, measurement->hum);
-		uint8_t msg_length = strlen((char*)humidity_msg);
-		humidity_msg[msg_length] = PERCENTAGE_SYMBOL_CODE;
-		if (lcd_print(humidity_msg) != APP_OK) {
-			return APP_ERR_INTERNAL;
+	return APP_OK;
+#else
+	return uartSendString(TRACE_DISABLED_MSG);
+#endif
+}
+
+/**
+ * @brief scans every I2C bus and prints the devices that answered
+ *
+ * One device per line as: bus, address and name if it is a known one. Registered devices are marked with *.
+ *
+ * @note the buses are blocked while they are scanned, which takes about 15 ms per bus
+ *
+ * @return APP_OK if the action is executed correctly, otherwise the corresponding error
+ */
+app_err_t scan_action() {
+	for (i2c_bus_id_t bus = 0; bus < I2C_BUS_COUNT; bus++) {
+		uint8_t amount_found;
+		app_err_t err = I2C_scan(bus, &amount_found);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		report_line_t line;
+		line_start(&line);
+		line_append_text(&line, I2C_get_bus_name(bus));
+		line_append_text(&line, (uint8_t*)": ");
+		line_append_uint(&line, amount_found, 0);
+		line_append_text(&line, (uint8_t*)" FOUND");
+
+		err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		for (uint16_t address = I2C_SCAN_FIRST_ADDRESS; address <= I2C_SCAN_LAST_ADDRESS; address++) {
+			if (!I2C_is_found(bus, address)) {
+				continue;
+			}
+
+			line_start(&line);
+			line_append_text(&line, (uint8_t*)"\t");
+			line_append_hex(&line, address, 2);
+			line_append_text(&line, is_registered(bus, address) ? (uint8_t*)" * " : (uint8_t*)"   ");
+
+			uint8_t* name = get_known_name(address);
+			line_append_text(&line, (name != NULL) ? name : (uint8_t*)"UNKNOWN");
+
+			err = line_send(&line);
+			if (err != APP_OK) {
+				return err;
+			}
 		}
 	}
 
@@ -124,12 +340,534 @@ app_err_t show_measurement_action(ht_measurement_t* measurement) {
 }
 
 /**
- * @brief performs the reset action
+ * @brief prints the profile and the health counters of every registered I2C device
  *
  * @return APP_OK if the action is executed correctly, otherwise the corresponding error
+ */
+app_err_t devices_action() {
+	uint8_t amount_of_devices = I2C_get_amount_of_devices();
+	if (amount_of_devices == 0) {
+		return uartSendString(NO_DEVICES_MSG);
+	}
+
+	for (uint8_t idx = 0; idx < amount_of_devices; idx++) {
+		i2c_device_info_t info;
+		app_err_t err = I2C_get_device_info(idx, &info);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		report_line_t line;
+		line_start(&line);
+		line_append_hex(&line, info.address, 2);
+		line_append_text(&line, (uint8_t*)" ");
+		line_append_text(&line, I2C_get_bus_name(info.bus));
+		line_append_uint(&line, info.speed / 1000, 4);
+		line_append_uint(&line, info.completed, 8);
+		line_append_uint(&line, info.nacks, 6);
+		line_append_uint(&line, info.errors, 6);
+		line_append_uint(&line, info.avg_latency_us, 7);
+		line_append_uint(&line, info.max_latency_us, 7);
+
+		err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief prints the run-time of every scheduler task, or starts a new measurement window
+ *
+ * The first line is the length of the window, then one task per line as: name, priority, runs, run time (ms),
+ * max run time (us) and load (per mille). The last line is the load left for idle, which includes the
+ * scheduler itself.
  *
+ * @param option: empty to print the tasks, or RESET to clear their counters
+ *
+ * @return
+ *  - APP_OK: if the action is executed correctly
+ *  - APP_ERR_INVALID_ARG: if the option is not valid
  */
-app_err_t reset_action() {
-	return ht_reset();
+app_err_t tasks_action(uint8_t* option) {
+	if (option != NULL && *option != '\0') {
+		if (strcmp((char*)option, (char*)TASKS_RESET_OPTION)) {
+			return APP_ERR_INVALID_ARG;
+		}
+
+		sched_reset_stats();
+		return uartSendString(TASKS_RESET_MSG);
+	}
+
+	report_line_t line;
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"WINDOW: ");
+	line_append_uint(&line, sched_get_stats_window(), 0);
+	line_append_text(&line, (uint8_t*)" MS");
+
+	app_err_t err = line_send(&line);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	uint32_t total_load = 0;
+	uint8_t amount_of_tasks = sched_get_amount_of_tasks();
+	for (uint8_t idx = 0; idx < amount_of_tasks; idx++) {
+		sched_task_info_t info;
+		err = sched_get_task_info(idx, &info);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		line_start(&line);
+		line_append_text(&line, info.name);
+		line_pad(&line, TASK_NAME_WIDTH);
+		line_append_text(&line, PRIORITY_NAMES[info.priority]);
+		line_append_uint(&line, info.runs, 9);
+		line_append_uint(&line, info.run_ms, 8);
+		line_append_uint(&line, info.max_run_us, 8);
+		line_append_uint(&line, info.load, 5);
+
+		err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		total_load += info.load;
+	}
+
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"IDLE");
+	line_pad(&line, TASK_NAME_WIDTH + 26);
+	line_append_uint(&line, (total_load < 1000) ? 1000 - total_load : 0, 5);
+
+	return line_send(&line);
+}
+
+/**
+ * @brief prints the statistics of the profiling zones, or clears them
+ *
+ * One zone per line as: name, count, min, average and max cycles. The zones are sorted by their total cycles,
+ * so the first one is where most of the time went.
+ *
+ * @param option: empty to print the zones, or RESET to clear their statistics
+ *
+ * @return
+ *  - APP_OK: if the action is executed correctly
+ *  - APP_ERR_INVALID_ARG: if the option is not valid
+ */
+app_err_t perf_action(uint8_t* option) {
+	bool reset = (option != NULL && *option != '\0');
+	if (reset && strcmp((char*)option, (char*)PERF_RESET_OPTION)) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+#if PERF_ENABLED
+	if (reset) {
+		perf_reset();
+		return uartSendString(PERF_RESET_MSG);
+	}
+
+	perf_zone_info_t zones[PERF_MAX_ZONES];
+	uint8_t amount = perf_snapshot(zones, PERF_MAX_ZONES);
+	if (amount == 0) {
+		return uartSendString(PERF_EMPTY_MSG);
+	}
+
+	// Insertion sort, the slowest zone in total first
+	for (uint8_t idx = 1; idx < amount; idx++) {
+		perf_zone_info_t zone = zones[idx];
+		uint8_t pos = idx;
+		while (pos > 0 && zones[pos - 1].total_cycles < zone.total_cycles) {
+			zones[pos] = zones[pos - 1];
+			pos--;
+		}
+
+		zones[pos] = zone;
+	}
+
+	for (uint8_t idx = 0; idx < amount; idx++) {
+		report_line_t line;
+		line_start(&line);
+		line_append_text(&line, zones[idx].name);
+		line_pad(&line, PERF_NAME_WIDTH);
+		line_append_uint(&line, zones[idx].count, 7);
+		line_append_uint(&line, zones[idx].min_cycles, 10);
+		line_append_uint(&line, zones[idx].avg_cycles, 10);
+		line_append_uint(&line, zones[idx].max_cycles, 10);
+
+		app_err_t err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	return APP_OK;
+#else
+	return uartSendString(PERF_DISABLED_MSG);
+#endif
 }
 
+/**
+ * @brief prints the latency histograms of the commands, or empties them
+ *
+ * One kind of command per line, in the order they were first seen, as: name, count, p50, p90, p99 and max
+ * latency from the last byte of the command to the first byte of its reply, then the average time until it is
+ * parsed, parsing and executing. Everything is in microseconds.
+ *
+ * @param option: empty to print the histograms, or RESET to empty them
+ *
+ * @return
+ *  - APP_OK: if the action is executed correctly
+ *  - APP_ERR_INVALID_ARG: if the option is not valid
+ */
+app_err_t latency_action(uint8_t* option) {
+	if (option != NULL && *option != '\0') {
+		if (strcmp((char*)option, (char*)LATENCY_RESET_OPTION)) {
+			return APP_ERR_INVALID_ARG;
+		}
+
+		latency_reset();
+		return uartSendString(LATENCY_RESET_MSG);
+	}
+
+	uint8_t amount_of_types = latency_get_amount_of_types();
+	if (amount_of_types == 0) {
+		return uartSendString(LATENCY_EMPTY_MSG);
+	}
+
+	for (uint8_t idx = 0; idx < amount_of_types; idx++) {
+		latency_info_t info;
+		app_err_t err = latency_get_info(idx, &info);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		report_line_t line;
+		line_start(&line);
+		line_append_text(&line, info.name);
+		line_pad(&line, LATENCY_NAME_WIDTH);
+		line_append_uint(&line, info.count, 6);
+		line_append_uint(&line, info.p50_us, 7);
+		line_append_uint(&line, info.p90_us, 7);
+		line_append_uint(&line, info.p99_us, 7);
+		line_append_uint(&line, info.max_us, 7);
+		line_append_uint(&line, info.avg_queue_us, 6);
+		line_append_uint(&line, info.avg_parse_us, 6);
+		line_append_uint(&line, info.avg_exec_us, 6);
+
+		err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief prints the timings of the last boot
+ *
+ * The first line is the time at which the device was ready, then one line per phase. Times are microseconds
+ * since the timebase started, right after the clocks were configured.
+ *
+ * @return APP_OK if the action is executed correctly, otherwise the corresponding error
+ */
+app_err_t boot_action() {
+	report_line_t line;
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"READY: ");
+	line_append_uint(&line, boot_get_ready_us(), 0);
+	line_append_text(&line, (uint8_t*)" US");
+
+	app_err_t err = line_send(&line);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	uint8_t amount_of_phases = boot_get_amount_of_phases();
+	for (uint8_t idx = 0; idx < amount_of_phases; idx++) {
+		boot_phase_info_t info;
+		err = boot_get_phase_info(idx, &info);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		line_start(&line);
+		line_append_text(&line, info.name);
+		line_pad(&line, BOOT_NAME_WIDTH);
+		line_append_uint(&line, info.start_us, 9);
+		line_append_uint(&line, info.ready_us, 9);
+		line_append_uint(&line, info.busy_us, 9);
+		line_append_uint(&line, info.steps, 6);
+		if (info.result != APP_OK) {
+			line_append_text(&line, (uint8_t*)" ");
+			line_append_text(&line, app_err_to_name(info.result));
+		}
+
+		err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief prints the cause of the last reset and the state of the supervised tasks
+ *
+ * The first line is the reset cause, followed by the task that missed its deadline when the IWDG caused it, and
+ * the second one the watchdog resets since the last power-on. Then one line per task.
+ *
+ * @return APP_OK if the action is executed correctly, otherwise the corresponding error
+ */
+app_err_t watchdog_action() {
+	watchdog_reset_info_t reset_info;
+	watchdog_get_reset_info(&reset_info);
+
+	report_line_t line;
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"RESET: ");
+	line_append_text(&line, RESET_CAUSE_NAMES[reset_info.cause]);
+	if (reset_info.stalled[0] != '\0') {
+		line_append_text(&line, (uint8_t*)" STALLED: ");
+		line_append_text(&line, reset_info.stalled);
+	}
+
+	app_err_t err = line_send(&line);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"WATCHDOG RESETS: ");
+	line_append_uint(&line, reset_info.watchdog_resets, 0);
+
+	err = line_send(&line);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	uint8_t amount_of_activities = watchdog_get_amount_of_activities();
+	for (uint8_t idx = 0; idx < amount_of_activities; idx++) {
+		watchdog_activity_info_t info;
+		err = watchdog_get_activity_info(idx, &info);
+		if (err != APP_OK) {
+			return err;
+		}
+
+		line_start(&line);
+		line_append_text(&line, info.name);
+		line_pad(&line, WATCHDOG_NAME_WIDTH);
+		line_append_text(&line, info.busy ? (uint8_t*)" BUSY" : (uint8_t*)" IDLE");
+		line_append_uint(&line, info.deadline_ms, 7);
+		line_append_uint(&line, info.since_checkin_ms, 9);
+
+		err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief prints the clock profile the board runs on, or switches to another one first
+ *
+ * The first line is the profile, the second one the core and APB clocks in MHz and the last one the flash wait
+ * states. The UART is set up again for the new clock before the report is sent.
+ *
+ * @param option: empty to print the profile, or the name of the profile to switch to
+ *
+ * @return
+ *  - APP_OK: if the action is executed correctly
+ *  - APP_ERR_INVALID_ARG: if the option is not a profile
+ *  - the error of clock_set_profile() if the switch fails
+ */
+app_err_t clock_action(uint8_t* option) {
+	if (option != NULL && *option != '\0') {
+		clock_profile_t profile = 0;
+		while (profile < CLOCK_PROFILE_COUNT && strcmp((char*)option, (char*)CLOCK_PROFILE_NAMES[profile])) {
+			profile++;
+		}
+
+		if (profile == CLOCK_PROFILE_COUNT) {
+			return APP_ERR_INVALID_ARG;
+		}
+
+		app_err_t err = clock_set_profile(profile);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	clock_info_t info;
+	clock_get_info(&info);
+
+	report_line_t line;
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"PROFILE: ");
+	line_append_text(&line, CLOCK_PROFILE_NAMES[info.profile]);
+
+	app_err_t err = line_send(&line);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"SYSCLK: ");
+	line_append_uint(&line, info.sysclk_hz / 1000000, 0);
+	line_append_text(&line, (uint8_t*)" APB1: ");
+	line_append_uint(&line, info.pclk1_hz / 1000000, 0);
+	line_append_text(&line, (uint8_t*)" APB2: ");
+	line_append_uint(&line, info.pclk2_hz / 1000000, 0);
+	line_append_text(&line, (uint8_t*)" MHZ");
+
+	err = line_send(&line);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	line_start(&line);
+	line_append_text(&line, (uint8_t*)"FLASH WAIT STATES: ");
+	line_append_uint(&line, info.flash_latency, 0);
+
+	return line_send(&line);
+}
+
+/**
+ * @brief empties the line and starts it with a line break
+ *
+ */
+void line_start(report_line_t* line) {
+	line->text[0] = '\r';
+	line->text[1] = '\n';
+	line->length = 2;
+}
+
+/**
+ * @brief appends the given text to the line, the text is truncated if it does not fit
+ *
+ */
+void line_append_text(report_line_t* line, uint8_t* text) {
+	while (*text && line->length < REPORT_LINE_LENGTH) {
+		line->text[line->length++] = *text++;
+	}
+}
+
+/**
+ * @brief appends an unsigned value right aligned to width, nothing is appended if it does not fit
+ *
+ */
+void line_append_uint(report_line_t* line, uint32_t value, uint8_t width) {
+	line->length += fmt_uint(&line->text[line->length], REPORT_LINE_LENGTH - line->length, value, width);
+}
+
+/**
+ * @brief appends a hexadecimal value with the given amount of digits, nothing is appended if it does not fit
+ *
+ */
+void line_append_hex(report_line_t* line, uint32_t value, uint8_t digits) {
+	line->length += fmt_hex(&line->text[line->length], REPORT_LINE_LENGTH - line->length, value, digits);
+}
+
+/**
+ * @brief appends spaces until the text reaches the given column, the line break of line_start() is not counted
+ *
+ */
+void line_pad(report_line_t* line, uint8_t column) {
+	while (line->length < column + 2 && line->length < REPORT_LINE_LENGTH) {
+		line->text[line->length++] = ' ';
+	}
+}
+
+/**
+ * @brief sends the line through the UART
+ *
+ */
+app_err_t line_send(report_line_t* line) {
+	return uartSendStringSize(line->text, line->length);
+}
+
+/**
+ * @brief dumps the event trace, from the oldest event
+ *
+ * The dump starts with a line "EVTRACE <timestamp rate> <records> <events traced>" and ends with "EVTRACE END".
+ * Each record goes in its own line as its timestamp, id and argument in hexadecimal.
+ *
+ */
+app_err_t dump_events() {
+#if EVTRACE_ENABLED
+	uint32_t written;
+	uint16_t amount = evtrace_snapshot(event_records, EVTRACE_LENGTH, &written);
+	report_line_t line;
+
+	line_start(&line);
+	line_append_text(&line, EVENTS_HEADER);
+	line_append_uint(&line, EVTRACE_TICK_HZ, 0);
+	line_append_text(&line, (uint8_t*)" ");
+	line_append_uint(&line, amount, 0);
+	line_append_text(&line, (uint8_t*)" ");
+	line_append_uint(&line, written, 0);
+
+	app_err_t err = line_send(&line);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	for (uint16_t idx = 0; idx < amount; idx++) {
+		evtrace_record_t* record = &event_records[idx];
+
+		line_start(&line);
+		line_append_hex(&line, record->timestamp, 8);
+		line_append_text(&line, (uint8_t*)" ");
+		line_append_hex(&line, record->id, 4);
+		line_append_text(&line, (uint8_t*)" ");
+		line_append_hex(&line, record->arg, 4);
+
+		err = line_send(&line);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	return uartSendString(EVENTS_END_MSG);
+#else
+	return uartSendString(EVENTS_DISABLED_MSG);
+#endif
+}
+
+/**
+ * @brief checks if the device is registered in the I2C core on the given bus
+ *
+ */
+bool is_registered(i2c_bus_id_t bus, uint16_t address) {
+	uint8_t amount_of_devices = I2C_get_amount_of_devices();
+	for (uint8_t idx = 0; idx < amount_of_devices; idx++) {
+		i2c_device_info_t info;
+		if (I2C_get_device_info(idx, &info) == APP_OK && info.address == address && info.bus == bus) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief returns the name of a known device, or NULL if the address is unknown
+ *
+ */
+uint8_t* get_known_name(uint16_t address) {
+	uint8_t amount_of_known = sizeof(KNOWN_DEVICES) / sizeof(KNOWN_DEVICES[0]);
+	for (uint8_t idx = 0; idx < amount_of_known; idx++) {
+		if (KNOWN_DEVICES[idx].address == address) {
+			return KNOWN_DEVICES[idx].name;
+		}
+	}
+
+	return NULL;
+}
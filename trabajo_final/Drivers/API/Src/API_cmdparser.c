@@ -1,6 +1,11 @@
 #include "API_cmdparser.h"
 #include "API_uart.h"
 #include "API_actions.h"
+#include "API_views.h"
+#include "API_latency.h"
+#include "timebase.h"
+#include "perf.h"
+#include "evtrace.h"
 #include <string.h>
 
 // Error definitions
@@ -26,19 +31,54 @@ typedef enum {
   READ_DATA,
   SHOW_DATA,
   ERROR_STATE,
+  STATE_COUNT,
 } state_t;
 
+// Names of the states, as the decoder of the event trace prints them
+static uint8_t* STATE_NAMES[STATE_COUNT] = {
+		(uint8_t*)"IDLE",
+		(uint8_t*)"RECV_CMD",
+		(uint8_t*)"PARSE_CMD",
+		(uint8_t*)"EXEC_CMD",
+		(uint8_t*)"RESET_SENSOR",
+		(uint8_t*)"MEASURE",
+		(uint8_t*)"READ_DATA",
+		(uint8_t*)"SHOW_DATA",
+		(uint8_t*)"ERROR_STATE",
+};
+
 // Valid Commands
 static uint8_t HELP_CMD[] = "HELP";
 static uint8_t GET_CMD[] = "GET";
 static uint8_t RESET_CMD[] = "RESET";
+static uint8_t TRACE_CMD[] = "TRACE";
+static uint8_t SCAN_CMD[] = "SCAN";
+static uint8_t DEVICES_CMD[] = "DEVICES";
+static uint8_t TASKS_CMD[] = "TASKS";
+static uint8_t PERF_CMD[] = "PERF";
+static uint8_t LATENCY_CMD[] = "LATENCY";
+static uint8_t BOOT_CMD[] = "BOOT";
+static uint8_t WDT_CMD[] = "WDT";
+static uint8_t CLOCK_CMD[] = "CLOCK";
 
 static uint8_t *VALID_CMDS[] = {
 		HELP_CMD,
 		GET_CMD,
 		RESET_CMD,
+		TRACE_CMD,
+		SCAN_CMD,
+		DEVICES_CMD,
+		TASKS_CMD,
+		PERF_CMD,
+		LATENCY_CMD,
+		BOOT_CMD,
+		WDT_CMD,
+		CLOCK_CMD,
 };
 
+// Kind under which the latency of the lines that are not a valid command is recorded
+static uint8_t INVALID_CMD_TYPE[] = "INVALID";
+
 static uint8_t PROMPT[] = "\r\n> ";
 
 static state_t system_state;
@@ -52,8 +92,16 @@ static uint8_t cmd_tokens[MAX_ARGS][MAX_CMD_LENGTH];
 
 static bool idle_check_flag;
 
+// Time until the FSM must run again, set by the state that just ran
+static uint32_t wait_ms;
+
 static ht_measurement_t measurement;
 
+// Latency of the command being handled, it is recorded when the first byte of its reply is sent
+static latency_stamps_t stamps;
+static uint8_t* latency_type;
+static bool reply_pending = false;
+
 // Prototypes
 static void cmdparser_reset();
 static void set_idle_state();
@@ -69,9 +117,13 @@ static void handle_measure_state();
 static void handle_read_data_state();
 static void handle_show_data_state();
 static void handle_reset_state();
+static uint8_t receive_line();
+static bool store_received(uint8_t character);
 
 static bool is_valid_char(uint8_t character);
 static bool command_exists(uint8_t* cmd);
+static uint8_t* find_command(uint8_t* cmd);
+static void record_reply();
 static void clear_buffer(uint8_t* buffer);
 static void echo(uint8_t* pstring);
 
@@ -86,6 +138,7 @@ app_err_t cmdparser_init() {
 		return CMDPARSER_ERR_INIT;
 	}
 
+	uartSetTxCallback(record_reply);
 	set_idle_state();
 	cmd_buffer_idx = 0;
 
@@ -95,9 +148,17 @@ app_err_t cmdparser_init() {
 /**
  * @brief reads the command that the user send and handle the state of the cmdparser
  *
+ * Each call runs a single state and never waits for the user or the sensor, instead it returns when it
+ * has to be called again
+ *
  * @note in case of being in an invalid state, the FSM is reseted
+ *
+ * @return the milliseconds until the next call, 0 to call it right away, or CMDPARSER_WAIT_INPUT if it waits
+ * for characters from the UART
  */
-void cmdparser_read_cmd() {
+uint32_t cmdparser_read_cmd() {
+	wait_ms = 0;
+
 	switch (system_state) {
 	case IDLE:
 		if (!idle_check_flag) {
@@ -134,13 +195,28 @@ void cmdparser_read_cmd() {
 	default:
 		cmdparser_reset();
 	}
+
+	return wait_ms;
+}
+
+/**
+ * @brief returns the name of a state of the FSM, as traced by EVTRACE_CMD_STATE
+ *
+ * @return the name, or NULL if state is not a state of the FSM
+ */
+uint8_t* cmdparser_get_state_name(uint8_t state) {
+	return (state < STATE_COUNT) ? STATE_NAMES[state] : NULL;
 }
 
 /**
- * @brief sets the state of the cmdparser
+ * @brief sets the state of the cmdparser, the transitions are traced
  *
  */
 void set_state(state_t state) {
+	if (state != system_state) {
+		EVTRACE(EVTRACE_CMD_STATE, state);
+	}
+
 	system_state = state;
 }
 
@@ -159,6 +235,7 @@ void set_idle_state() {
  *
  */
 void set_error_state(app_err_t err) {
+	EVTRACE(EVTRACE_CMD_ERROR, err);
 	set_state(ERROR_STATE);
 	error_code = err;
 }
@@ -178,23 +255,13 @@ void cmdparser_reset() {
 /**
  * @brief handles the IDLE state
  *
- * Waits for a command, and if it receive one, it transitions to RECV_CMD state and the command is copied into the buffer.
- * Otherwise, it remains in the same state.
+ * Takes the characters received, when the first character of a command arrives it transitions to RECV_CMD
+ * state and the command is copied into the buffer. Otherwise, it remains in the same state.
  *
  */
 void handle_idle_state() {
-	uint8_t raw_cmd_buffer[MAX_CMD_LENGTH];
-	clear_buffer(raw_cmd_buffer);
-	uartReceiveStringSize(raw_cmd_buffer, MAX_CMD_LENGTH);
-
-	uint8_t *pointer = raw_cmd_buffer;
-	if (strlen((char*)pointer)) {
-		echo(raw_cmd_buffer);
-		while(*pointer) {
-			cmd_buffer[cmd_buffer_idx++] = *pointer++;
-		}
-
-		set_state(RECV_CMD);
+	if (receive_line() == 0) {
+		wait_ms = CMDPARSER_WAIT_INPUT;
 	}
 }
 
@@ -209,29 +276,73 @@ void handle_idle_state() {
  * @note if its all good it pass to PARSE_CMD state
  */
 void handle_recv_state() {
+	if (receive_line() == 0) {
+		wait_ms = CMDPARSER_WAIT_INPUT;
+	}
+}
+
+/**
+ * @brief takes the received characters up to the end of the command and echoes them
+ *
+ * A whole line may arrive at once when it is pasted or sent by a script. Characters are taken one at a time,
+ * so the ones after the line break stay in the UART buffer for the next command.
+ *
+ * @return the amount of characters taken, 0 if nothing was received
+ */
+uint8_t receive_line() {
 	uint8_t raw_cmd_buffer[MAX_CMD_LENGTH];
-	clear_buffer(raw_cmd_buffer);
-	uartReceiveStringSize(raw_cmd_buffer, 1);
+	uint8_t amount = 0;
+	bool line_done = false;
+
+	// The last byte is never received, so the text is always null terminated
+	while (!line_done && amount < MAX_CMD_LENGTH - 1) {
+		uint16_t received = 0;
+		uartReceiveStringSize(&raw_cmd_buffer[amount], 1, &received);
+		if (received == 0) {
+			break;
+		}
+
+		line_done = store_received(raw_cmd_buffer[amount++]);
+	}
 
-	uint8_t *pointer = raw_cmd_buffer;
-	if (strlen((char*)pointer)) {
+	raw_cmd_buffer[amount] = '\0';
+	if (amount > 0) {
 		echo(raw_cmd_buffer);
+	}
 
-		while(*pointer) {
-			if (cmd_buffer_idx >= MAX_CMD_LENGTH) {
-				set_error_state(CMDPARSER_ERR_OVERFLOW);
-				return;
-			}
+	return amount;
+}
 
-			if (*pointer == '\n' || *pointer == '\r') {
-				cmd_buffer[cmd_buffer_idx] = '\0';
-				set_state(PARSE_CMD);
-				return;
-			}
+/**
+ * @brief appends the received character to the command until a line break or carriage return
+ *
+ * Line breaks before the first character are skipped, so "\r\n" endings do not produce empty commands.
+ *
+ * @note it moves to RECV_CMD with the first character, to PARSE_CMD when the line ends, or to
+ * CMDPARSER_ERR_OVERFLOW if it is too long
+ *
+ * @return true if the command is complete or failed
+ */
+bool store_received(uint8_t character) {
+	if (cmd_buffer_idx >= MAX_CMD_LENGTH) {
+		set_error_state(CMDPARSER_ERR_OVERFLOW);
+		return true;
+	}
 
-			cmd_buffer[cmd_buffer_idx++] = *pointer++;
-		}
+	bool line_break = (character == '\n' || character == '\r');
+	if (line_break && cmd_buffer_idx > 0) {
+		stamps.rx = uartGetRxTimeUs();
+		cmd_buffer[cmd_buffer_idx] = '\0';
+		set_state(PARSE_CMD);
+		return true;
+	}
+
+	if (!line_break) {
+		cmd_buffer[cmd_buffer_idx++] = character;
+		set_state(RECV_CMD);
 	}
+
+	return false;
 }
 
 /**
@@ -243,6 +354,14 @@ void handle_recv_state() {
  *
  */
 void handle_parse_state() {
+	PERF_ZONE(handle_parse_state);
+
+	// Until the command is known, the latency counts as the one of an invalid line
+	stamps.parse = timebase_now_us();
+	stamps.exec = stamps.parse;
+	latency_type = INVALID_CMD_TYPE;
+	reply_pending = true;
+
 	for (uint8_t idx = 0; idx < MAX_ARGS; idx++) {
 		clear_buffer(cmd_tokens[idx]);
 	}
@@ -299,6 +418,9 @@ void handle_parse_state() {
  *
  */
 void handle_exec_state() {
+	stamps.exec = timebase_now_us();
+	latency_type = find_command(cmd_tokens[0]);
+
 	char* char_cmd = (char*) cmd_tokens[0];
 	if (!strcmp(char_cmd, (char*)GET_CMD)) {
 		set_state(MEASURE);
@@ -313,6 +435,60 @@ void handle_exec_state() {
 
 	if (!strcmp(char_cmd, (char*)HELP_CMD)) {
 		help_action();
+	} else if (!strcmp(char_cmd, (char*)TRACE_CMD)) {
+		app_err_t err = trace_action(cmd_tokens[1]);
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)SCAN_CMD)) {
+		app_err_t err = scan_action();
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)DEVICES_CMD)) {
+		app_err_t err = devices_action();
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)TASKS_CMD)) {
+		app_err_t err = tasks_action(cmd_tokens[1]);
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)PERF_CMD)) {
+		app_err_t err = perf_action(cmd_tokens[1]);
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)LATENCY_CMD)) {
+		app_err_t err = latency_action(cmd_tokens[1]);
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)BOOT_CMD)) {
+		app_err_t err = boot_action();
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)WDT_CMD)) {
+		app_err_t err = watchdog_action();
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
+	} else if (!strcmp(char_cmd, (char*)CLOCK_CMD)) {
+		app_err_t err = clock_action(cmd_tokens[1]);
+		if (err != APP_OK) {
+			set_error_state(err);
+			return;
+		}
 	} else {
 		set_error_state(CMDPARSER_ERR_UNKNOWN);
 		return;
@@ -346,7 +522,9 @@ void handle_measure_state() {
 		return;
 	}
 
+	// The sensor is read once the measurement is done, meanwhile other tasks can run
 	set_state(READ_DATA);
+	wait_ms = ht_get_measurement_wait();
 }
 
 /**
@@ -355,9 +533,17 @@ void handle_measure_state() {
  *
  */
 void handle_read_data_state() {
+	// The task may be woken up by other events before the measurement is done
+	uint32_t wait = ht_get_measurement_wait();
+	if (wait > 0) {
+		wait_ms = wait;
+		return;
+	}
+
 	// Clear values from last read
 	measurement = (ht_measurement_t){0};
 	app_err_t err = read_measurement_action(&measurement);
+	views_record_read(err);
 	if (err != APP_OK) {
 		set_error_state(err);
 		return;
@@ -424,7 +610,7 @@ void clear_buffer(uint8_t* buffer) {
 /**
  * @brief checks if the given character is valid
  *
- * @note valid characters are: \n, \r, \0, _, ' ', & and letters (uppercase or lowercase)
+ * @note valid characters are: \n, \r, \0, _, ' ', &, digits and letters (uppercase or lowercase)
  *
  * @param character to be check
  */
@@ -441,6 +627,10 @@ bool is_valid_char(uint8_t character) {
         return true;
     }
 
+    if (character >= '0' && character <= '9') {
+        return true;
+    }
+
     return false;
 }
 
@@ -451,15 +641,42 @@ bool is_valid_char(uint8_t character) {
  *
  */
 bool command_exists(uint8_t* cmd) {
+	return find_command(cmd) != NULL;
+}
+
+/**
+ * @brief looks for the command among the valid ones
+ *
+ * @return the name of the command, which outlives the given one, or NULL if it does not exist
+ *
+ */
+uint8_t* find_command(uint8_t* cmd) {
 	uint8_t amount_of_commands = sizeof(VALID_CMDS) / sizeof(VALID_CMDS[0]);
 
 	for (int idx = 0; idx < amount_of_commands; idx++) {
 		if (!strcmp((char*)VALID_CMDS[idx], (char*)cmd)) {
-			return true;
+			return VALID_CMDS[idx];
 		}
 	}
 
-	return false;
+	return NULL;
+}
+
+/**
+ * @brief records the latency of the command on the first string sent after it was received
+ *
+ * The reply may be the output of the command, its error or just the prompt once it is done, so a command that
+ * only shows its result on the LCD is measured until it finishes.
+ *
+ */
+void record_reply() {
+	if (!reply_pending) {
+		return;
+	}
+
+	reply_pending = false;
+	stamps.reply = timebase_now_us();
+	latency_record(latency_type, &stamps);
 }
 
 /**
@@ -0,0 +1,186 @@
+#include "API_format.h"
+#include <math.h>
+#include <stddef.h>
+
+// Enough room for the 10 digits of a uint32_t, a sign and a decimal point
+#define MAX_DIGITS 12
+
+static const uint32_t POW10[FMT_MAX_PRECISION + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+// Prototypes
+static uint8_t format_number(uint8_t* buffer, uint8_t size, uint32_t magnitude, bool negative, uint8_t precision, uint8_t width);
+
+/**
+ * @brief writes an unsigned integer as decimal text
+ *
+ * @param buffer: where the characters are written, it is NOT null terminated
+ * @param size: amount of bytes available in buffer
+ * @param value: value to be written
+ * @param width: minimum amount of characters, the number is right aligned with spaces
+ *
+ * @return the amount of characters written, or 0 if they do not fit in buffer
+ */
+uint8_t fmt_uint(uint8_t* buffer, uint8_t size, uint32_t value, uint8_t width) {
+	return format_number(buffer, size, value, false, 0, width);
+}
+
+/**
+ * @brief writes a fixed-point value as decimal text
+ *
+ * The value is interpreted as value / 10^precision, so fmt_fixed(buf, size, -1234, 2, 0) writes "-12.34".
+ * This replaces snprintf("%.*f") without pulling the floating point printf from newlib.
+ *
+ * @param buffer: where the characters are written, it is NOT null terminated
+ * @param size: amount of bytes available in buffer
+ * @param value: fixed-point value
+ * @param precision: amount of fractional digits, up to FMT_MAX_PRECISION
+ * @param width: minimum amount of characters, the number is right aligned with spaces
+ *
+ * @return the amount of characters written, or 0 if they do not fit in buffer or precision is invalid
+ */
+uint8_t fmt_fixed(uint8_t* buffer, uint8_t size, int32_t value, uint8_t precision, uint8_t width) {
+	if (precision > FMT_MAX_PRECISION) {
+		return 0;
+	}
+
+	bool negative = value < 0;
+	uint32_t magnitude = negative ? (0u - (uint32_t)value) : (uint32_t)value;
+
+	return format_number(buffer, size, magnitude, negative, precision, width);
+}
+
+/**
+ * @brief writes a double with the given amount of fractional digits, the same text as snprintf("%*.*f")
+ *
+ * The value is rounded as fmt_double_to_fixed() does. A negative value that rounds to zero keeps its sign,
+ * so -0.001 is written as "-0.00" like printf does.
+ *
+ * @param buffer: where the characters are written, it is NOT null terminated
+ * @param size: amount of bytes available in buffer
+ * @param value: value to be written, it must fit in an int32_t once scaled by 10^precision
+ * @param precision: amount of fractional digits, up to FMT_MAX_PRECISION
+ * @param width: minimum amount of characters, the number is right aligned with spaces
+ *
+ * @return the amount of characters written, or 0 if they do not fit in buffer or precision is invalid
+ */
+uint8_t fmt_double(uint8_t* buffer, uint8_t size, double value, uint8_t precision, uint8_t width) {
+	if (precision > FMT_MAX_PRECISION) {
+		return 0;
+	}
+
+	int32_t fixed_value = fmt_double_to_fixed(value, precision);
+	uint32_t magnitude = (fixed_value < 0) ? (0u - (uint32_t)fixed_value) : (uint32_t)fixed_value;
+
+	return format_number(buffer, size, magnitude, signbit(value) && !isnan(value), precision, width);
+}
+
+/**
+ * @brief writes an unsigned integer as hexadecimal text with a 0x prefix
+ *
+ * @param buffer: where the characters are written, it is NOT null terminated
+ * @param size: amount of bytes available in buffer
+ * @param value: value to be written
+ * @param digits: amount of hexadecimal digits, the value is padded with zeros, from 1 to 8
+ *
+ * @return the amount of characters written, or 0 if they do not fit in buffer or digits is invalid
+ */
+uint8_t fmt_hex(uint8_t* buffer, uint8_t size, uint32_t value, uint8_t digits) {
+	if (buffer == NULL || digits == 0 || digits > 8 || size < digits + 2) {
+		return 0;
+	}
+
+	buffer[0] = '0';
+	buffer[1] = 'x';
+	for (uint8_t idx = 0; idx < digits; idx++) {
+		uint8_t nibble = (value >> (4 * (digits - 1 - idx))) & 0x0F;
+		buffer[2 + idx] = (nibble < 10) ? '0' + nibble : 'A' + nibble - 10;
+	}
+
+	return digits + 2;
+}
+
+/**
+ * @brief converts a double into a fixed-point value with the given amount of fractional digits
+ *
+ * Ties are rounded to even, which is what printf does, so the text produced by fmt_double() matches "%.*f"
+ *
+ * @param value: value to be converted, values out of the int32_t range are saturated
+ * @param precision: amount of fractional digits, up to FMT_MAX_PRECISION
+ *
+ * @return value * 10^precision rounded to the nearest integer, 0 if value is NaN or precision is invalid
+ */
+int32_t fmt_double_to_fixed(double value, uint8_t precision) {
+	if (isnan(value) || precision > FMT_MAX_PRECISION) {
+		return 0;
+	}
+
+	double scaled = value * POW10[precision];
+	if (scaled >= (double)INT32_MAX) {
+		return INT32_MAX;
+	}
+
+	if (scaled <= (double)INT32_MIN) {
+		return INT32_MIN;
+	}
+
+	double integral = floor(scaled);
+	double fraction = scaled - integral;
+	int32_t result = (int32_t)integral;
+
+	// The product may have been rounded onto an exact tie, the fma residual tells on which side the real value is
+	if (fraction == 0.5) {
+		double residual = fma(value, POW10[precision], -scaled);
+		if (residual > 0 || (residual == 0 && (result & 1))) {
+			result++;
+		}
+	} else if (fraction > 0.5) {
+		result++;
+	}
+
+	return result;
+}
+
+/**
+ * @brief writes the digits of magnitude with the decimal point placed before the last precision digits
+ *
+ * @return the amount of characters written, or 0 if they do not fit in buffer
+ */
+uint8_t format_number(uint8_t* buffer, uint8_t size, uint32_t magnitude, bool negative, uint8_t precision, uint8_t width) {
+	if (buffer == NULL) {
+		return 0;
+	}
+
+	// Digits are generated from the least significant one, so they are stored reversed
+	uint8_t reversed[MAX_DIGITS];
+	uint8_t length = 0;
+	uint8_t min_digits = precision + 1;
+
+	for (uint8_t digit = 0; magnitude != 0 || digit < min_digits; digit++) {
+		if (precision != 0 && digit == precision) {
+			reversed[length++] = '.';
+		}
+
+		reversed[length++] = '0' + (magnitude % 10);
+		magnitude /= 10;
+	}
+
+	if (negative) {
+		reversed[length++] = '-';
+	}
+
+	uint8_t padding = (width > length) ? width - length : 0;
+	if (padding + length > size) {
+		return 0;
+	}
+
+	uint8_t idx = 0;
+	while (idx < padding) {
+		buffer[idx++] = ' ';
+	}
+
+	while (length) {
+		buffer[idx++] = reversed[--length];
+	}
+
+	return idx;
+}
@@ -1,7 +1,9 @@
 #include "API_ht_sensor.h"
 #include "ht_port.h"
 #include "math.h"
-#include "stm32f4xx_hal.h"
+#include "port.h"
+#include "perf.h"
+#include "evtrace.h"
 #include <string.h>
 
 #define MAX_RETRIES 10
@@ -9,6 +11,15 @@
 #define FARENHEIT_STR "F"
 #define KELVIN_STR "K"
 #define HT_NO_VALUE NAN
+#define MEASUREMENT_RESPONSE_SIZE 7
+
+// Waits of the AHT20 datasheet
+#define POWER_ON_WAIT_US 40000
+#define CALIBRATION_WAIT_US 10000
+
+// The busy bit is polled this often after the measurement time, for up to MAX_BUSY_POLLS times
+#define BUSY_POLL_US 500
+#define MAX_BUSY_POLLS 20
 
 // Commands for AHT20 sensor
 static uint8_t STATUS_CMD = 0X71;
@@ -17,7 +28,6 @@ static uint8_t INIT_CMD[3] = {0xBE, 0x08, 0x00};
 static uint8_t RESET_CMD = 0xBA;
 
 static const uint16_t STATUS_RESPONSE_SIZE = 1;
-static const uint8_t MEASUREMENT_RESPONSE_SIZE = 7;
 
 // Data indexes for humidity and temperature
 static const uint8_t HIGH_HUM_BYTE_IDX = 1;
@@ -41,8 +51,21 @@ static const uint8_t TEMP_HUM_OP_STR[] = "TEMP&HUM";
 // Masks
 static const uint8_t THIRD_BIT_MASK = 0x08;
 
+// Steps of the initialization, run by ht_init_step()
+typedef enum {
+	INIT_POWER_ON,
+	INIT_PORT,
+	INIT_CHECK_STATUS,
+} init_step_t;
+
 // private global variable to store the query to be made by the sensor
 static ht_query_t query;
+// Time of the last trigger, the measurement is ready HT_MEASUREMENT_TIME_US after it
+static uint32_t trigger_us;
+
+static init_step_t init_step = INIT_POWER_ON;
+static bool init_cmd_triggered = false;
+static uint8_t init_retries = 0;
 
 // Prototypes
 static app_err_t set_operation(ht_query_t* query, uint8_t* operation);
@@ -54,45 +77,96 @@ static uint8_t* unit_to_string();
 /**
  * @brief Inits the HT sensor
  *
- * Executes the initialization commands, and if after @MAX_RETRIES the sensor could not be initialized, an error is returned.
+ * Runs every step of ht_init_step() waiting between them
  *
  * @return
  * 	- APP_OK if the sensor is initialized correctly
  * 	- APP_ERR_INTERNAL, HT_ERR_INIT_SENSOR in case of an error
  */
 app_err_t ht_init() {
-	HAL_Delay(40);
-	bool init_cmd_triggered = false;
-	uint8_t retry_counter = 0;
+	uint32_t wait_us = 0;
+	app_err_t err;
 
-	if (write_command(&STATUS_CMD, 1) != APP_OK) {
-		return APP_ERR_INTERNAL;
+	while ((err = ht_init_step(&wait_us)) == APP_OK && wait_us != HT_INIT_DONE) {
+		port_delay_us(wait_us);
 	}
 
-check_status:
-	HAL_Delay(10);
-	uint8_t buffer_status = {0};
-	if (read_data(&buffer_status, STATUS_RESPONSE_SIZE) != APP_OK) {
-		return APP_ERR_INTERNAL;
+	return err;
+}
+
+/**
+ * @brief runs the next step of the initialization of the HT sensor, the first call starts it
+ *
+ * Waits for the power-on time, then checks the calibration bit every CALIBRATION_WAIT_US, sending the
+ * initialization command once. If the sensor is not calibrated after @MAX_RETRIES checks, an error is returned.
+ * The steps never wait, so the initialization can be interleaved with the one of other devices.
+ *
+ * @param wait_us: where the microseconds until the next step are written, HT_INIT_DONE after the last one
+ *
+ * @return
+ * 	- APP_OK if the step is done, the initialization starts over with the next call once it is finished
+ * 	- APP_ERR_INTERNAL, HT_ERR_INIT_SENSOR in case of an error, which also starts it over
+ */
+app_err_t ht_init_step(uint32_t* wait_us) {
+	if (wait_us == NULL) {
+		return APP_ERR_INVALID_ARG;
 	}
 
-	if ((buffer_status & THIRD_BIT_MASK) >> 3) {
-		// Already initialized
+	app_err_t err = APP_OK;
+
+	switch (init_step) {
+	case INIT_POWER_ON:
+		init_cmd_triggered = false;
+		init_retries = 0;
+		init_step = INIT_PORT;
+		*wait_us = POWER_ON_WAIT_US;
 		return APP_OK;
-	}
+	case INIT_PORT:
+		if (ht_port_init() != APP_OK) {
+			err = APP_ERR_INTERNAL;
+			break;
+		}
 
-	if (!init_cmd_triggered && write_command(INIT_CMD, sizeof(INIT_CMD)) != APP_OK) {
-		return HT_ERR_INIT_SENSOR;
-	}
+		init_step = INIT_CHECK_STATUS;
+		*wait_us = CALIBRATION_WAIT_US;
+		return APP_OK;
+	case INIT_CHECK_STATUS: {
+		uint8_t buffer_status = {0};
+		if (write_read(&STATUS_CMD, sizeof(STATUS_CMD), &buffer_status, STATUS_RESPONSE_SIZE) != APP_OK) {
+			err = APP_ERR_INTERNAL;
+			break;
+		}
+
+		if ((buffer_status & THIRD_BIT_MASK) >> 3) {
+			// Already initialized
+			init_step = INIT_POWER_ON;
+			*wait_us = HT_INIT_DONE;
+			return APP_OK;
+		}
+
+		if (!init_cmd_triggered && write_command(INIT_CMD, sizeof(INIT_CMD)) != APP_OK) {
+			err = HT_ERR_INIT_SENSOR;
+			break;
+		}
 
-	init_cmd_triggered = true;
-	retry_counter++;
+		init_cmd_triggered = true;
+		init_retries++;
+		EVTRACE(EVTRACE_HT_INIT_RETRY, init_retries);
 
-	if (retry_counter > MAX_RETRIES) {
-		return HT_ERR_INIT_SENSOR;
+		if (init_retries > MAX_RETRIES) {
+			err = HT_ERR_INIT_SENSOR;
+			break;
+		}
+
+		*wait_us = CALIBRATION_WAIT_US;
+		return APP_OK;
+	}
+	default:
+		err = APP_ERR_INTERNAL;
 	}
 
-	goto check_status;
+	init_step = INIT_POWER_ON;
+	return err;
 }
 
 /**
@@ -126,9 +200,22 @@ app_err_t ht_trigger_measurement(ht_query_t ht_query) {
 	}
 
 	query = ht_query;
+	trigger_us = port_now_us();
 	return APP_OK;
 }
 
+/**
+ * @brief returns the time left until the triggered measurement is ready
+ *
+ * Reading it earlier is allowed, ht_read_measurement() waits for the rest of the time
+ *
+ * @return the milliseconds to wait, rounded up so the measurement is ready after them, 0 if it is ready
+ */
+uint32_t ht_get_measurement_wait() {
+	uint32_t elapsed = port_now_us() - trigger_us;
+	return (elapsed < HT_MEASUREMENT_TIME_US) ? (HT_MEASUREMENT_TIME_US - elapsed + 999) / 1000 : 0;
+}
+
 /**
  * @brief reads the measurement from the sensor
  *
@@ -207,29 +294,35 @@ app_err_t ht_reset() {
  * 	- HT_ERR_READ_MEASUREMENT: in case of an error reading the measurement
  */
 app_err_t ht_get_temp_and_hum(double* temp, double* hum) {
-	HAL_Delay(80);
+	PERF_ZONE(ht_get_temp_and_hum);
+
+	uint32_t elapsed = port_now_us() - trigger_us;
+	if (elapsed < HT_MEASUREMENT_TIME_US) {
+		port_delay_us(HT_MEASUREMENT_TIME_US - elapsed);
+	}
 
 	uint8_t read_status = {0};
 	uint8_t retry_counter = 0;
 
-	if (read_data(&read_status, STATUS_RESPONSE_SIZE) != APP_OK) {
+	if (write_read(&STATUS_CMD, sizeof(STATUS_CMD), &read_status, STATUS_RESPONSE_SIZE) != APP_OK) {
 		return HT_ERR_READ_MEASUREMENT;
 	}
 
 	// if the seventh bit is 1 we can read the whole measurement
 	while (read_status >> 7) {
-		HAL_Delay(1);
-		if (read_data(&read_status, STATUS_RESPONSE_SIZE) != APP_OK) {
+		EVTRACE(EVTRACE_HT_BUSY_POLL, retry_counter);
+		port_delay_us(BUSY_POLL_US);
+		if (write_read(&STATUS_CMD, sizeof(STATUS_CMD), &read_status, STATUS_RESPONSE_SIZE) != APP_OK) {
 			return HT_ERR_READ_MEASUREMENT;
 		}
 
-		if (retry_counter++ > MAX_RETRIES) {
+		if (retry_counter++ > MAX_BUSY_POLLS) {
 			return HT_ERR_READ_MEASUREMENT;
 		}
 	}
 
 
-	uint8_t sensor_data_buffer[1] = {0};
+	uint8_t sensor_data_buffer[MEASUREMENT_RESPONSE_SIZE] = {0};
 	if (read_data(sensor_data_buffer, MEASUREMENT_RESPONSE_SIZE) != APP_OK) {
 		return HT_ERR_READ_MEASUREMENT;
 	}
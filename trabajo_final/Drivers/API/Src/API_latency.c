@@ -0,0 +1,162 @@
+#include "API_latency.h"
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+	uint8_t* name;
+	uint32_t count;
+	uint32_t buckets[LATENCY_BUCKETS];
+	uint32_t max_us;
+	uint64_t queue_us;
+	uint64_t parse_us;
+	uint64_t exec_us;
+} histogram_t;
+
+static histogram_t histograms[LATENCY_MAX_TYPES];
+static uint8_t amount_of_types = 0;
+
+// Prototypes
+static histogram_t* find_histogram(uint8_t* name);
+static uint8_t get_bucket(uint32_t latency_us);
+static uint32_t get_percentile(const histogram_t* histogram, uint16_t per_mille);
+
+/**
+ * @brief adds the latency of a command to the histogram of its kind, which is created the first time
+ *
+ * @param name: kind of command, it must outlive the histograms
+ * @param stamps: cycle counter at each step, latencies longer than a lap of the counter are not valid
+ *
+ * @return
+ * - APP_OK: if the latency is recorded
+ * - APP_ERR_INVALID_ARG: if a pointer is NULL
+ * - LATENCY_ERR_TABLE_FULL: if the kind is new and there are already LATENCY_MAX_TYPES kinds
+ */
+app_err_t latency_record(uint8_t* name, const latency_stamps_t* stamps) {
+	if (name == NULL || stamps == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	histogram_t* histogram = find_histogram(name);
+	if (histogram == NULL) {
+		if (amount_of_types >= LATENCY_MAX_TYPES) {
+			return LATENCY_ERR_TABLE_FULL;
+		}
+
+		histogram = &histograms[amount_of_types++];
+		*histogram = (histogram_t){.name = name};
+	}
+
+	uint32_t latency_us = stamps->reply - stamps->rx;
+
+	histogram->count++;
+	histogram->buckets[get_bucket(latency_us)]++;
+	if (latency_us > histogram->max_us) {
+		histogram->max_us = latency_us;
+	}
+
+	histogram->queue_us += stamps->parse - stamps->rx;
+	histogram->parse_us += stamps->exec - stamps->parse;
+	histogram->exec_us += stamps->reply - stamps->exec;
+
+	return APP_OK;
+}
+
+uint8_t latency_get_amount_of_types() {
+	return amount_of_types;
+}
+
+/**
+ * @brief returns the percentiles and averages of a kind of command
+ *
+ * @param idx: index of the kind, from 0 to latency_get_amount_of_types() - 1
+ *
+ * @return
+ * - APP_OK: if the information is written
+ * - APP_ERR_INVALID_ARG: if info is NULL
+ * - LATENCY_ERR_INVALID_TYPE: if idx is out of range
+ */
+app_err_t latency_get_info(uint8_t idx, latency_info_t* info) {
+	if (info == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (idx >= amount_of_types) {
+		return LATENCY_ERR_INVALID_TYPE;
+	}
+
+	const histogram_t* histogram = &histograms[idx];
+	uint32_t count = histogram->count;
+
+	info->name = histogram->name;
+	info->count = count;
+	info->p50_us = get_percentile(histogram, 500);
+	info->p90_us = get_percentile(histogram, 900);
+	info->p99_us = get_percentile(histogram, 990);
+	info->max_us = histogram->max_us;
+	info->avg_queue_us = (count > 0) ? histogram->queue_us / count : 0;
+	info->avg_parse_us = (count > 0) ? histogram->parse_us / count : 0;
+	info->avg_exec_us = (count > 0) ? histogram->exec_us / count : 0;
+
+	return APP_OK;
+}
+
+/**
+ * @brief empties every histogram, the kinds already seen are kept with a count of 0
+ *
+ */
+void latency_reset() {
+	for (uint8_t idx = 0; idx < amount_of_types; idx++) {
+		histograms[idx] = (histogram_t){.name = histograms[idx].name};
+	}
+}
+
+histogram_t* find_histogram(uint8_t* name) {
+	for (uint8_t idx = 0; idx < amount_of_types; idx++) {
+		if (!strcmp((char*)histograms[idx].name, (char*)name)) {
+			return &histograms[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief returns the bucket of the latency, the position of its highest bit set
+ *
+ */
+uint8_t get_bucket(uint32_t latency_us) {
+	if (latency_us < 2) {
+		return 0;
+	}
+
+	uint8_t bucket = 31 - __builtin_clz(latency_us);
+	return (bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS - 1;
+}
+
+/**
+ * @brief returns the latency under which the given share of the commands fall
+ *
+ * @param per_mille: share of the commands, 500 for the median
+ *
+ * @return the upper bound of the bucket that holds the percentile, capped to the maximum, 0 if it is empty
+ */
+uint32_t get_percentile(const histogram_t* histogram, uint16_t per_mille) {
+	if (histogram->count == 0) {
+		return 0;
+	}
+
+	uint32_t rank = ((uint64_t)histogram->count * per_mille + 999) / 1000;
+	uint32_t accumulated = 0;
+	uint8_t bucket = 0;
+	while (bucket < LATENCY_BUCKETS - 1) {
+		accumulated += histogram->buckets[bucket];
+		if (accumulated >= rank) {
+			break;
+		}
+
+		bucket++;
+	}
+
+	uint32_t upper_bound = (bucket < LATENCY_BUCKETS - 1) ? 2UL << bucket : histogram->max_us;
+	return (upper_bound < histogram->max_us) ? upper_bound : histogram->max_us;
+}
@@ -1,20 +1,25 @@
 #include "API_lcd.h"
 #include "lcd_port.h"
-#include "stm32f4xx_hal.h"
+#include "port.h"
+#include "stm32f4xx.h"
+#include <string.h>
 
 // LCD commands
 #define CLEAR_DISPLAY_CMD 0x01
 #define RETURN_HOME_CMD 0x02
 #define ENTRY_MODE_CMD 0x06
 #define DISPLAY_CONTROL_CMD 0x0C
-#define FUNCTION_SET_CMD 0x28
 #define SET_DDRAM_ADDRESS_CMD 0x80
 
-#define FIRST_ROW_ADDRESS 0x00
-#define SECOND_ROW_ADDRESS 0x40
+// Function set: 4-bit interface, 5x8 font and 2-line mode (panels with 4 rows are driven as 2 long lines)
+#define FUNCTION_SET_CMD ((LCD_ROWS > 1) ? 0x28 : 0x20)
 
-#define DELAY_1_MS 1
-#define DELAY_2_MS 2
+// Waits of the HD44780 datasheet, with the slowest oscillator (270 kHz) they scale to
+#define POWER_ON_WAIT_US 40000
+#define FIRST_FUNCTION_SET_WAIT_US 4100
+#define SECOND_FUNCTION_SET_WAIT_US 100
+#define EXECUTION_WAIT_US 37
+#define CLEAR_AND_HOME_WAIT_US 1520
 
 // Values of the control nibble that must be send with each command
 #define RS_IR 0
@@ -26,8 +31,17 @@
 
 static const uint8_t HIGH_NIBBLE_MASK = 0xF0;
 
+// Every LCD byte is sent as two nibbles, each one with EN high and then low
+#define PORT_BYTES_PER_LCD_BYTE 4
+
+// Port bytes needed to write a row: DDRAM address command followed by LCD_COLS characters
+#define ROW_STREAM_SIZE ((LCD_COLS + 1) * PORT_BYTES_PER_LCD_BYTE)
+
+// Maximum time the direct writes wait for a flush in progress
+#define FLUSH_WAIT_TIMEOUT_MS 100
+
 // Sequence of commands to initialize the LCD
-static uint8_t INIT_SEQUENCE[7] = {
+static uint8_t INIT_SEQUENCE[] = {
 		FUNCTION_SET_CMD,
 		DISPLAY_CONTROL_CMD,
 		CLEAR_DISPLAY_CMD,
@@ -41,15 +55,57 @@ static uint8_t CLEAR_SEQUENCE[2] = {
 		RETURN_HOME_CMD
 };
 
+// DDRAM address of the first column of each row
+static const uint8_t ROW_ADDRESSES[LCD_ROWS] = {
+		LCD_ROW_ADDRESS(0),
+		LCD_ROW_ADDRESS(1),
+#if LCD_ROWS > 2
+		LCD_ROW_ADDRESS(2),
+		LCD_ROW_ADDRESS(3),
+#endif
+};
+
+// Steps of the initialization, run by lcd_init_step()
+typedef enum {
+	INIT_POWER_ON,
+	INIT_FIRST_FUNCTION_SET,
+	INIT_SECOND_FUNCTION_SET,
+	INIT_FOUR_BIT_MODE,
+	INIT_COMMANDS,
+	INIT_MESSAGE,
+} init_step_t;
+
 // Init message to be displayed if it's all good
 static uint8_t init_msg[] = "Welcome :)";
 
-static uint8_t current_row = FIRST_ROW_ADDRESS;
+static uint8_t current_row = 0;
+
+static init_step_t init_step = INIT_POWER_ON;
+static uint8_t init_cmd_idx = 0;
+
+// Frame submitted by lcd_update_row() and frame currently on the screen
+static uint8_t pending_frame[LCD_ROWS][LCD_COLS];
+static uint8_t shown_frame[LCD_ROWS][LCD_COLS];
+static bool frame_pending = false;
+static uint32_t next_refresh_tick = 0;
+
+// Rows being written asynchronously, the streams must live until the port finishes with them
+static uint8_t row_streams[LCD_ROWS][ROW_STREAM_SIZE];
+static uint8_t sending_frame[LCD_ROWS][LCD_COLS];
+static volatile uint8_t rows_in_flight = 0;
+
+static lcd_update_callback_t update_callback = NULL;
 
 // Prototypes
 static app_err_t send_commands(uint8_t* cmds, uint8_t size);
+static uint32_t get_command_wait(uint8_t cmd);
 static app_err_t lcd_send_cmd(uint8_t cmd);
 static app_err_t lcd_send_data(uint8_t* data);
+static app_err_t lcd_send_row(uint8_t row);
+static void row_sent_callback(app_err_t result, void* context);
+static app_err_t wait_flush_done();
+static void notify_update();
+static uint8_t* encode_byte(uint8_t* stream, uint8_t data, uint8_t rs);
 static app_err_t lcd_send_byte(uint8_t data, uint8_t rs);
 static app_err_t lcd_send_nibble(uint8_t data, uint8_t rs);
 static uint8_t build_lcd_control_byte(uint8_t rs_bit, uint8_t read_op_bit, uint8_t EN_bit);
@@ -57,7 +113,7 @@ static uint8_t build_lcd_control_byte(uint8_t rs_bit, uint8_t read_op_bit, uint8
 /*
  * @brief inits the LCD
  *
- *  Sends the initialization sequence to the LCD and then shows the init message
+ *  Runs every step of lcd_init_step() waiting between them
  *
  * @return
  *  - APP_OK if the LCD is initialized correctly
@@ -65,33 +121,76 @@ static uint8_t build_lcd_control_byte(uint8_t rs_bit, uint8_t read_op_bit, uint8
  *
  */
 app_err_t lcd_init() {
-	HAL_Delay(100);
+	uint32_t wait_us = 0;
+	app_err_t err;
 
-	if (lcd_send_nibble(0x30, RS_IR) != APP_OK) {
-		return LCD_ERR_INIT;
+	while ((err = lcd_init_step(&wait_us)) == APP_OK && wait_us != LCD_INIT_DONE) {
+		port_delay_us(wait_us);
 	}
 
-	HAL_Delay(5);
+	return err;
+}
 
-	if (lcd_send_nibble(0x30, RS_IR) != APP_OK) {
-		return LCD_ERR_INIT;
+/*
+ * @brief runs the next step of the initialization of the LCD, the first call starts it
+ *
+ *  Sends the initialization sequence to the LCD one command per step and then shows the init message.
+ *  The steps never wait, so the initialization can be interleaved with the one of other devices.
+ *
+ * @param wait_us: where the microseconds until the next step are written, LCD_INIT_DONE after the last one
+ *
+ * @return
+ *  - APP_OK if the step is done, the initialization starts over with the next call once it is finished
+ *  - LCD_ERR_INIT: in case of an error, which also starts it over
+ *
+ */
+app_err_t lcd_init_step(uint32_t* wait_us) {
+	if (wait_us == NULL) {
+		return APP_ERR_INVALID_ARG;
 	}
 
-	HAL_Delay(1);
+	app_err_t err = APP_OK;
+	uint8_t amount_of_cmds = sizeof(INIT_SEQUENCE) / sizeof(INIT_SEQUENCE[0]);
 
-	if (lcd_send_nibble(0x20, RS_IR) != APP_OK) {
-		return LCD_ERR_INIT;
+	switch (init_step) {
+	case INIT_POWER_ON:
+		err = lcd_port_init();
+		init_cmd_idx = 0;
+		*wait_us = POWER_ON_WAIT_US;
+		break;
+	case INIT_FIRST_FUNCTION_SET:
+		err = lcd_send_nibble(0x30, RS_IR);
+		*wait_us = FIRST_FUNCTION_SET_WAIT_US;
+		break;
+	case INIT_SECOND_FUNCTION_SET:
+		err = lcd_send_nibble(0x30, RS_IR);
+		*wait_us = SECOND_FUNCTION_SET_WAIT_US;
+		break;
+	case INIT_FOUR_BIT_MODE:
+		err = lcd_send_nibble(0x20, RS_IR);
+		*wait_us = EXECUTION_WAIT_US;
+		break;
+	case INIT_COMMANDS:
+		err = lcd_send_cmd(INIT_SEQUENCE[init_cmd_idx]);
+		*wait_us = get_command_wait(INIT_SEQUENCE[init_cmd_idx]);
+		init_cmd_idx++;
+		break;
+	case INIT_MESSAGE:
+		err = lcd_print(init_msg);
+		*wait_us = LCD_INIT_DONE;
+		break;
+	default:
+		err = LCD_ERR_INIT;
 	}
 
-	HAL_Delay(1);
-
-	uint8_t amount_of_cmds = sizeof(INIT_SEQUENCE) / sizeof(INIT_SEQUENCE[0]);
-	if (send_commands(INIT_SEQUENCE, amount_of_cmds) != APP_OK) {
+	if (err != APP_OK) {
+		init_step = INIT_POWER_ON;
 		return LCD_ERR_INIT;
 	}
 
-	if (lcd_print(init_msg) != APP_OK) {
-		return LCD_ERR_INIT;
+	// The commands step is repeated until the whole sequence is sent
+	if (init_step != INIT_COMMANDS || init_cmd_idx >= amount_of_cmds) {
+		init_step = (init_step == INIT_MESSAGE) ? INIT_POWER_ON : init_step + 1;
 	}
 
 	return APP_OK;
@@ -106,8 +205,14 @@ app_err_t lcd_init() {
  *
  */
 app_err_t lcd_clear_screen() {
-	current_row = FIRST_ROW_ADDRESS;
-	return send_commands(CLEAR_SEQUENCE, 2);
+	app_err_t err = wait_flush_done();
+	if (err != APP_OK) {
+		return err;
+	}
+
+	current_row = 0;
+	memset(shown_frame, ' ', sizeof(shown_frame));
+	return send_commands(CLEAR_SEQUENCE, sizeof(CLEAR_SEQUENCE));
 }
 
 /*
@@ -123,22 +228,21 @@ app_err_t lcd_clear_screen() {
  *
  */
 app_err_t lcd_set_cursor(uint8_t row, uint8_t col) {
-	if (row > 2) {
+	if (row >= LCD_ROWS) {
 		return LCD_ERR_INVALID_ROW_IDX;
 	}
 
-	if (col > 15) {
+	if (col >= LCD_COLS) {
 		return LCD_ERR_INVALID_COL_IDX;
 	}
 
-	uint8_t new_row = (row == 0) ? FIRST_ROW_ADDRESS : SECOND_ROW_ADDRESS;
-	uint8_t new_address = new_row + col;
+	uint8_t new_address = ROW_ADDRESSES[row] + col;
 	app_err_t err = lcd_send_cmd(SET_DDRAM_ADDRESS_CMD | new_address);
 	if (err != APP_OK) {
 		return err;
 	}
 
-	current_row = new_row;
+	current_row = row;
 	return APP_OK;
 }
 
@@ -172,10 +276,122 @@ app_err_t lcd_println(uint8_t* message) {
 		return err;
 	}
 
-	uint8_t new_row = (current_row == FIRST_ROW_ADDRESS) ? 1 : 0;
+	uint8_t new_row = (current_row + 1) % LCD_ROWS;
 	return lcd_set_cursor(new_row, 0);
 }
 
+/*
+ * @brief replaces the content of a row of the pending frame
+ *
+ * Nothing is sent to the LCD, the frame is written by lcd_refresh() or lcd_flush(). If several updates arrive
+ * before the next refresh only the newest content is written.
+ *
+ * @param row: row to be updated
+ * @param text: null terminated text, it is truncated to LCD_COLS and padded with spaces
+ *
+ * @return
+ * - APP_OK if the row is updated
+ * - LCD_ERR_INVALID_ROW_IDX: in case of an invalid row
+ * - APP_ERR_INVALID_ARG: if text is NULL
+ *
+ */
+app_err_t lcd_update_row(uint8_t row, uint8_t* text) {
+	if (text == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (row >= LCD_ROWS) {
+		return LCD_ERR_INVALID_ROW_IDX;
+	}
+
+	for (uint8_t col = 0; col < LCD_COLS; col++) {
+		pending_frame[row][col] = *text ? *text++ : ' ';
+	}
+
+	frame_pending = true;
+	notify_update();
+	return APP_OK;
+}
+
+/*
+ * @brief writes the pending frame if LCD_MIN_REFRESH_MS have passed since the last refresh
+ *
+ * @note it is meant to be called when the update callback fires, and again after lcd_get_refresh_delay()
+ *
+ * @return APP_OK if there is nothing to do or the frame is written correctly, otherwise the corresponding error
+ *
+ */
+app_err_t lcd_refresh() {
+	if (!frame_pending) {
+		return APP_OK;
+	}
+
+	if ((int32_t)(port_now() - next_refresh_tick) < 0) {
+		return APP_OK;
+	}
+
+	return lcd_flush();
+}
+
+/*
+ * @brief returns the time until lcd_refresh() can write the pending frame
+ *
+ * @return the milliseconds to wait, 0 if it can be written now, or LCD_NO_REFRESH if there is nothing to write
+ * or the previous flush is still in progress, in which case the update callback fires when it finishes
+ *
+ */
+uint32_t lcd_get_refresh_delay() {
+	if (!frame_pending || rows_in_flight > 0) {
+		return LCD_NO_REFRESH;
+	}
+
+	int32_t remaining = next_refresh_tick - port_now();
+	return (remaining > 0) ? (uint32_t)remaining : 0;
+}
+
+/*
+ * @brief sets the function called when a frame becomes pending, NULL to remove it
+ *
+ */
+void lcd_set_update_callback(lcd_update_callback_t callback) {
+	update_callback = callback;
+}
+
+/*
+ * @brief writes the pending frame right away
+ *
+ * Only the rows that differ from what is on the screen are sent. Each row is queued as a single asynchronous
+ * write, so this function returns without waiting for the display. If the previous flush is still in progress
+ * the frame stays pending and it is written by a later call.
+ *
+ * @note if a row cannot be queued the frame stays pending and lcd_refresh() retries it after LCD_MIN_REFRESH_MS,
+ * so a failing display is not written in a loop
+ *
+ * @return APP_OK if the frame is queued correctly, otherwise the corresponding error
+ *
+ */
+app_err_t lcd_flush() {
+	if (rows_in_flight > 0) {
+		return APP_OK;
+	}
+
+	next_refresh_tick = port_now() + LCD_MIN_REFRESH_MS;
+
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {
+		if (!memcmp(pending_frame[row], shown_frame[row], LCD_COLS)) {
+			continue;
+		}
+
+		app_err_t err = lcd_send_row(row);
+		if (err != APP_OK) {
+			return err;
+		}
+	}
+
+	frame_pending = false;
+	return APP_OK;
+}
+
 app_err_t send_commands(uint8_t* cmds, uint8_t size) {
 	if (cmds == NULL) {
 		return APP_ERR_INVALID_ARG;
@@ -187,13 +403,21 @@ app_err_t send_commands(uint8_t* cmds, uint8_t size) {
 			return LCD_ERR_SENDING_CMD;
 		}
 
-		(cmd == CLEAR_DISPLAY_CMD || cmd == RETURN_HOME_CMD) ? HAL_Delay(DELAY_2_MS) : HAL_Delay(DELAY_1_MS);
+		port_delay_us(get_command_wait(cmd));
 	}
 
 
 	return APP_OK;
 }
 
+/*
+ * @brief returns the execution time of the command, clear and home take much longer than the others
+ *
+ */
+uint32_t get_command_wait(uint8_t cmd) {
+	return (cmd == CLEAR_DISPLAY_CMD || cmd == RETURN_HOME_CMD) ? CLEAR_AND_HOME_WAIT_US : EXECUTION_WAIT_US;
+}
+
 /*
  * @brief sends a command to the LCD
  *
@@ -215,6 +439,7 @@ app_err_t lcd_send_cmd(uint8_t cmd) {
  *  -APP_OK if the data is sent correctly
  *  -LCD_ERR_SENDING_DATA: in case of an error
  *  - APP_ERR_INVALID_ARG: if data is NULL
+ *  - LCD_ERR_FLUSH_TIMEOUT: if the rows of a flush are still being written after FLUSH_WAIT_TIMEOUT_MS
  *
  */
 app_err_t lcd_send_data(uint8_t* data) {
@@ -222,6 +447,14 @@ app_err_t lcd_send_data(uint8_t* data) {
 		return APP_ERR_INVALID_ARG;
 	}
 
+	// Direct writes are not tracked, so the next flush rewrites every row
+	app_err_t err = wait_flush_done();
+	if (err != APP_OK) {
+		return err;
+	}
+
+	memset(shown_frame, 0, sizeof(shown_frame));
+
 	while (*data) {
 		if (lcd_send_byte(*data++, RS_DR) != APP_OK) {
 			return LCD_ERR_SENDING_DATA;
@@ -233,41 +466,132 @@ app_err_t lcd_send_data(uint8_t* data) {
 }
 
 /*
- * @brief sends a byte to the LCD
+ * @brief queues the write of a whole row of the pending frame
  *
- * @param data: byte to send
- * @param rs: 0: if its a command, 1: if its data
+ * The address command and the characters are encoded into a single stream, so the row is written in one
+ * port transaction
  *
- * @return APP_OK if the byte is sent correctly, otherwise APP_ERR_INTERNAL
+ * @param row: row to be sent
+ *
+ * @return
+ *  -APP_OK if the row is queued correctly
+ *  -LCD_ERR_SENDING_DATA: in case of an error
  *
  */
-app_err_t lcd_send_byte(uint8_t data, uint8_t rs) {
-	uint8_t high_nibble = data & HIGH_NIBBLE_MASK;
-	uint8_t high_nibble_start = high_nibble | build_lcd_control_byte(rs, WRITE_OP, EN_START);
-	if (lcd_write(&high_nibble_start, 1) != APP_OK) {
-		return APP_ERR_INTERNAL;
+app_err_t lcd_send_row(uint8_t row) {
+	uint8_t* stream = encode_byte(row_streams[row], SET_DDRAM_ADDRESS_CMD | ROW_ADDRESSES[row], RS_IR);
+	for (uint8_t col = 0; col < LCD_COLS; col++) {
+		stream = encode_byte(stream, pending_frame[row][col], RS_DR);
 	}
 
-	uint8_t high_nibble_finish = high_nibble | build_lcd_control_byte(rs, WRITE_OP, EN_FINISH);
-	if (lcd_write(&high_nibble_finish, 1) != APP_OK) {
-		return APP_ERR_INTERNAL;
+	memcpy(sending_frame[row], pending_frame[row], LCD_COLS);
+
+	// The completion of the rows queued before decrements it from interrupt context
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	rows_in_flight++;
+	__set_PRIMASK(primask);
+
+	if (lcd_write_async(row_streams[row], ROW_STREAM_SIZE, row_sent_callback, (void*)(uintptr_t)row) != APP_OK) {
+		primask = __get_PRIMASK();
+		__disable_irq();
+		rows_in_flight--;
+		__set_PRIMASK(primask);
+
+		memset(shown_frame[row], 0, LCD_COLS);
+		return LCD_ERR_SENDING_DATA;
 	}
 
-	uint8_t low_nibble = (data << 4) & HIGH_NIBBLE_MASK;
-	uint8_t low_nibble_start = low_nibble | build_lcd_control_byte(rs, WRITE_OP, EN_START);
-	if (lcd_write(&low_nibble_start, 1) != APP_OK) {
-		return APP_ERR_INTERNAL;
+	// The cursor is left after the last column of the row
+	current_row = row;
+	return APP_OK;
+}
+
+/*
+ * @brief updates the shadow of the screen once a row is written
+ *
+ * @note it can be called from interrupt context
+ *
+ */
+void row_sent_callback(app_err_t result, void* context) {
+	uint8_t row = (uint8_t)(uintptr_t)context;
+
+	if (result == APP_OK) {
+		memcpy(shown_frame[row], sending_frame[row], LCD_COLS);
+	} else {
+		// The row may be partially written, so it is not known what is on the screen
+		memset(shown_frame[row], 0, LCD_COLS);
+	}
+
+	rows_in_flight--;
 
+	// A frame submitted during the flush was left pending, it can be written now
+	if (rows_in_flight == 0 && frame_pending) {
+		notify_update();
 	}
+}
 
-	uint8_t low_nibble_finish = low_nibble | build_lcd_control_byte(RS_IR, WRITE_OP, EN_FINISH);
-	if (lcd_write(&low_nibble_finish, 1) != APP_OK) {
-		return APP_ERR_INTERNAL;
+/*
+ * @brief waits until the rows being flushed are written, so direct writes do not interleave with them
+ *
+ * @return APP_OK, or LCD_ERR_FLUSH_TIMEOUT if rows are still being written after FLUSH_WAIT_TIMEOUT_MS
+ *
+ */
+app_err_t wait_flush_done() {
+	uint32_t start = port_now();
+	while (rows_in_flight > 0) {
+		if (port_now() - start >= FLUSH_WAIT_TIMEOUT_MS) {
+			return LCD_ERR_FLUSH_TIMEOUT;
+		}
 	}
 
 	return APP_OK;
 }
 
+void notify_update() {
+	if (update_callback != NULL) {
+		update_callback();
+	}
+}
+
+/*
+ * @brief sends a byte to the LCD
+ *
+ * @param data: byte to send
+ * @param rs: 0: if its a command, 1: if its data
+ *
+ * @return APP_OK if the byte is sent correctly, otherwise APP_ERR_INTERNAL
+ *
+ */
+app_err_t lcd_send_byte(uint8_t data, uint8_t rs) {
+	uint8_t stream[PORT_BYTES_PER_LCD_BYTE];
+	encode_byte(stream, data, rs);
+
+	return (lcd_write(stream, sizeof(stream)) != APP_OK) ? APP_ERR_INTERNAL : APP_OK;
+}
+
+/*
+ * @brief encodes a byte as the four port writes that clock its nibbles into the LCD
+ *
+ * @param stream: where the PORT_BYTES_PER_LCD_BYTE port bytes are written
+ * @param data: byte to encode
+ * @param rs: 0: if its a command, 1: if its data
+ *
+ * @return pointer to the position of stream after the encoded byte
+ *
+ */
+uint8_t* encode_byte(uint8_t* stream, uint8_t data, uint8_t rs) {
+	uint8_t high_nibble = data & HIGH_NIBBLE_MASK;
+	uint8_t low_nibble = (data << 4) & HIGH_NIBBLE_MASK;
+
+	*stream++ = high_nibble | build_lcd_control_byte(rs, WRITE_OP, EN_START);
+	*stream++ = high_nibble | build_lcd_control_byte(rs, WRITE_OP, EN_FINISH);
+	*stream++ = low_nibble | build_lcd_control_byte(rs, WRITE_OP, EN_START);
+	*stream++ = low_nibble | build_lcd_control_byte(rs, WRITE_OP, EN_FINISH);
+
+	return stream;
+}
+
 /*
  * @brief sends the high nibble of the given byte
  *
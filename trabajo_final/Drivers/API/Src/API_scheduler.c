@@ -0,0 +1,339 @@
+#include "API_scheduler.h"
+#include "API_timers.h"
+#include "cycles.h"
+#include "port.h"
+#include <stddef.h>
+
+typedef struct {
+	uint8_t* name;
+	sched_handler_t handler;
+	sched_priority_t priority;
+	volatile uint32_t pending_events;
+	uint32_t runs;
+	uint64_t run_cycles;
+	uint32_t max_run_cycles;
+} task_t;
+
+// Timer of the wheel that posts the events to the task when it expires
+typedef struct {
+	sched_task_id_t task;
+	uint32_t events;
+	timer_id_t wheel_timer;
+} soft_timer_t;
+
+static task_t tasks[SCHED_MAX_TASKS];
+static uint8_t amount_of_tasks = 0;
+
+static soft_timer_t timers[SCHED_MAX_TIMERS];
+static uint8_t amount_of_timers = 0;
+
+static sched_idle_hook_t idle_hook = NULL;
+
+// Task that ran last, the search for the next one starts after it so equal priorities take turns
+static uint8_t last_task = 0;
+static uint32_t stats_start_tick = 0;
+
+// Prototypes
+static task_t* get_ready_task();
+static void run_task(task_t* task);
+static void post_timer_events(void* context);
+static bool has_pending_events();
+
+/**
+ * @brief adds a task to the scheduler, it runs for the first time when an event is posted to it
+ *
+ * @param name: shown by the TASKS command, it must outlive the scheduler
+ * @param id: where the identifier used to post events to the task is written
+ *
+ * @return
+ * - APP_OK: if the task is added
+ * - APP_ERR_INVALID_ARG: if a pointer is NULL or the priority is invalid
+ * - SCHED_ERR_TABLE_FULL: if there are already SCHED_MAX_TASKS tasks
+ */
+app_err_t sched_task_create(uint8_t* name, sched_handler_t handler, sched_priority_t priority, sched_task_id_t* id) {
+	if (name == NULL || handler == NULL || id == NULL || priority >= SCHED_PRIORITY_COUNT) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (amount_of_tasks >= SCHED_MAX_TASKS) {
+		return SCHED_ERR_TABLE_FULL;
+	}
+
+	tasks[amount_of_tasks] = (task_t){
+			.name = name,
+			.handler = handler,
+			.priority = priority,
+	};
+
+	*id = amount_of_tasks++;
+	return APP_OK;
+}
+
+/**
+ * @brief posts events to a task, they are merged with the ones it has pending
+ *
+ * @note it can be called from interrupt context
+ *
+ * @return APP_OK if the events are posted, otherwise SCHED_ERR_INVALID_TASK
+ */
+app_err_t sched_post(sched_task_id_t id, uint32_t events) {
+	if (id >= amount_of_tasks) {
+		return SCHED_ERR_INVALID_TASK;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	tasks[id].pending_events |= events;
+	__set_PRIMASK(primask);
+
+	return APP_OK;
+}
+
+/**
+ * @brief creates a stopped timer that posts the given events to the task when it expires
+ *
+ * @return
+ * - APP_OK: if the timer is created
+ * - APP_ERR_INVALID_ARG: if id is NULL
+ * - SCHED_ERR_INVALID_TASK: if the task does not exist
+ * - SCHED_ERR_TABLE_FULL: if there are already SCHED_MAX_TIMERS timers
+ * - TIMERS_ERR_TABLE_FULL: if the timer wheel is full
+ */
+app_err_t sched_timer_create(sched_task_id_t task, uint32_t events, sched_timer_id_t* id) {
+	if (id == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (task >= amount_of_tasks) {
+		return SCHED_ERR_INVALID_TASK;
+	}
+
+	if (amount_of_timers >= SCHED_MAX_TIMERS) {
+		return SCHED_ERR_TABLE_FULL;
+	}
+
+	soft_timer_t* timer = &timers[amount_of_timers];
+	timer->task = task;
+	timer->events = events;
+
+	app_err_t err = timers_create(post_timer_events, timer, &timer->wheel_timer);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	*id = amount_of_timers++;
+	return APP_OK;
+}
+
+/**
+ * @brief starts the timer, or restarts it if it is already running
+ *
+ * @param delay_ms: time until it expires for the first time
+ * @param period_ms: time between the following expirations, 0 for a one-shot timer
+ *
+ * @note it can be called from interrupt context
+ *
+ * @return APP_OK if the timer is started, otherwise SCHED_ERR_INVALID_TIMER
+ */
+app_err_t sched_timer_start(sched_timer_id_t id, uint32_t delay_ms, uint32_t period_ms) {
+	if (id >= amount_of_timers) {
+		return SCHED_ERR_INVALID_TIMER;
+	}
+
+	return timers_start(timers[id].wheel_timer, delay_ms, period_ms);
+}
+
+/**
+ * @brief stops the timer, nothing happens if it is not running
+ *
+ * @note it can be called from interrupt context
+ *
+ * @return APP_OK if the timer is stopped, otherwise SCHED_ERR_INVALID_TIMER
+ */
+app_err_t sched_timer_stop(sched_timer_id_t id) {
+	if (id >= amount_of_timers) {
+		return SCHED_ERR_INVALID_TIMER;
+	}
+
+	return timers_stop(timers[id].wheel_timer);
+}
+
+/**
+ * @brief sets the function called when there is nothing to run, NULL to return right away
+ *
+ */
+void sched_set_idle_hook(sched_idle_hook_t hook) {
+	idle_hook = hook;
+}
+
+/**
+ * @brief runs one step of the scheduler: runs the ready task with the highest priority, or calls the idle
+ * hook if there is none
+ *
+ * @note it is meant to be called from the main loop, the timers are advanced by timers_process()
+ */
+void sched_run_once() {
+	task_t* task = get_ready_task();
+	if (task != NULL) {
+		run_task(task);
+		return;
+	}
+
+	if (idle_hook == NULL) {
+		return;
+	}
+
+	// An event posted after the check would be missed until the next deadline, so the check and the hook
+	// run with interrupts disabled. WFI still wakes up on the interrupt, which runs once they are enabled.
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint32_t sleep_time = sched_get_sleep_time();
+	if (sleep_time > 0) {
+		idle_hook(sleep_time);
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief returns the time until the timer wheel has to be processed, on the next expiry at the latest
+ *
+ * @return 0 if a task is ready or a timer already expired, SCHED_NO_DEADLINE if no timer is running
+ */
+uint32_t sched_get_sleep_time() {
+	if (has_pending_events()) {
+		return 0;
+	}
+
+	uint32_t sleep_time = timers_get_sleep_time();
+	return (sleep_time == TIMERS_NO_EXPIRY) ? SCHED_NO_DEADLINE : sleep_time;
+}
+
+uint8_t sched_get_amount_of_tasks() {
+	return amount_of_tasks;
+}
+
+/**
+ * @brief returns the run-time of the task since the last sched_reset_stats()
+ *
+ * @param idx: index of the task, from 0 to sched_get_amount_of_tasks() - 1
+ *
+ * @return
+ * - APP_OK: if the information is written
+ * - APP_ERR_INVALID_ARG: if info is NULL
+ * - SCHED_ERR_INVALID_TASK: if idx is out of range
+ */
+app_err_t sched_get_task_info(uint8_t idx, sched_task_info_t* info) {
+	if (info == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (idx >= amount_of_tasks) {
+		return SCHED_ERR_INVALID_TASK;
+	}
+
+	task_t* task = &tasks[idx];
+	uint32_t cycles_per_us = SystemCoreClock / 1000000;
+	uint64_t run_us = task->run_cycles / cycles_per_us;
+	uint32_t window = sched_get_stats_window();
+
+	info->name = task->name;
+	info->priority = task->priority;
+	info->runs = task->runs;
+	info->run_ms = run_us / 1000;
+	info->max_run_us = task->max_run_cycles / cycles_per_us;
+	// us over ms is already per mille
+	info->load = (window > 0) ? run_us / window : 0;
+
+	return APP_OK;
+}
+
+/**
+ * @brief returns the milliseconds since the last sched_reset_stats()
+ *
+ */
+uint32_t sched_get_stats_window() {
+	return port_now() - stats_start_tick;
+}
+
+/**
+ * @brief clears the run-time of every task and starts a new window
+ *
+ */
+void sched_reset_stats() {
+	for (uint8_t idx = 0; idx < amount_of_tasks; idx++) {
+		tasks[idx].runs = 0;
+		tasks[idx].run_cycles = 0;
+		tasks[idx].max_run_cycles = 0;
+	}
+
+	stats_start_tick = port_now();
+}
+
+/**
+ * @brief finds the task with pending events and the highest priority
+ *
+ * @return the task to run, or NULL if there is none
+ */
+task_t* get_ready_task() {
+	task_t* ready = NULL;
+	uint8_t ready_idx = 0;
+
+	for (uint8_t offset = 1; offset <= amount_of_tasks; offset++) {
+		uint8_t idx = (last_task + offset) % amount_of_tasks;
+		task_t* task = &tasks[idx];
+
+		if (task->pending_events && (ready == NULL || task->priority > ready->priority)) {
+			ready = task;
+			ready_idx = idx;
+		}
+	}
+
+	if (ready != NULL) {
+		last_task = ready_idx;
+	}
+
+	return ready;
+}
+
+/**
+ * @brief takes the pending events of the task and runs it, measuring how long it takes
+ *
+ */
+void run_task(task_t* task) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t events = task->pending_events;
+	task->pending_events = 0;
+	__set_PRIMASK(primask);
+
+	uint32_t start = cycles_now();
+	task->handler(events);
+	uint32_t elapsed = cycles_now() - start;
+
+	task->runs++;
+	task->run_cycles += elapsed;
+	if (elapsed > task->max_run_cycles) {
+		task->max_run_cycles = elapsed;
+	}
+}
+
+/**
+ * @brief callback of the timer wheel, it posts the events of the timer to its task
+ *
+ */
+void post_timer_events(void* context) {
+	soft_timer_t* timer = context;
+	sched_post(timer->task, timer->events);
+}
+
+bool has_pending_events() {
+	for (uint8_t idx = 0; idx < amount_of_tasks; idx++) {
+		if (tasks[idx].pending_events) {
+			return true;
+		}
+	}
+
+	return false;
+}
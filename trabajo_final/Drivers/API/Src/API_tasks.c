@@ -0,0 +1,188 @@
+#include "API_tasks.h"
+#include "API_scheduler.h"
+#include "API_cmdparser.h"
+#include "API_lcd.h"
+#include "API_uart.h"
+#include "API_views.h"
+#include "i2c_core.h"
+#include "watchdog.h"
+
+// The tasks do not tell their events apart, all of them mean there may be work to do
+#define EVENT_WAKE_UP (1 << 0)
+
+static sched_task_id_t cmdparser_task;
+static sched_task_id_t views_task;
+static sched_task_id_t lcd_task;
+static sched_task_id_t i2c_task;
+
+static sched_timer_id_t cmdparser_timer;
+static sched_timer_id_t lcd_timer;
+static sched_timer_id_t i2c_timer;
+
+static watchdog_id_t cmdparser_activity;
+static watchdog_id_t lcd_activity;
+static watchdog_id_t i2c_activity;
+
+// Prototypes
+static void run_cmdparser(uint32_t events);
+static void run_views(uint32_t events);
+static void run_lcd(uint32_t events);
+static void run_i2c(uint32_t events);
+static void wake_cmdparser();
+static void wake_views();
+static void wake_lcd();
+static void wake_i2c();
+
+/**
+ * @brief creates the application tasks and connects the drivers to them
+ *
+ * - I2C (high): fails the transfers that run out of time, it only runs while there are transfers in progress
+ * - CMD (normal): runs the cmdparser when characters arrive or the sensor measurement is done
+ * - VIEWS (normal): switches the page when the button is pressed
+ * - LCD (low): writes the pending frame, no sooner than LCD_MIN_REFRESH_MS after the last one
+ *
+ * CMD, LCD and I2C are supervised by the watchdog: once work is posted to them, they must run within their
+ * deadline until they have nothing left to do.
+ *
+ * @note the cmdparser, the LCD and the views must be initialized before
+ *
+ * @return APP_OK if the tasks are created, otherwise the corresponding error
+ */
+app_err_t tasks_init() {
+	app_err_t err = sched_task_create((uint8_t*)"I2C", run_i2c, SCHED_PRIORITY_HIGH, &i2c_task);
+	if (err == APP_OK) {
+		err = sched_task_create((uint8_t*)"CMD", run_cmdparser, SCHED_PRIORITY_NORMAL, &cmdparser_task);
+	}
+
+	if (err == APP_OK) {
+		err = sched_task_create((uint8_t*)"VIEWS", run_views, SCHED_PRIORITY_NORMAL, &views_task);
+	}
+
+	if (err == APP_OK) {
+		err = sched_task_create((uint8_t*)"LCD", run_lcd, SCHED_PRIORITY_LOW, &lcd_task);
+	}
+
+	if (err == APP_OK) {
+		err = sched_timer_create(cmdparser_task, EVENT_WAKE_UP, &cmdparser_timer);
+	}
+
+	if (err == APP_OK) {
+		err = sched_timer_create(lcd_task, EVENT_WAKE_UP, &lcd_timer);
+	}
+
+	if (err == APP_OK) {
+		err = sched_timer_create(i2c_task, EVENT_WAKE_UP, &i2c_timer);
+	}
+
+	if (err == APP_OK) {
+		err = watchdog_register((uint8_t*)"CMD", TASKS_CMD_DEADLINE_MS, &cmdparser_activity);
+	}
+
+	if (err == APP_OK) {
+		err = watchdog_register((uint8_t*)"LCD", TASKS_LCD_DEADLINE_MS, &lcd_activity);
+	}
+
+	if (err == APP_OK) {
+		err = watchdog_register((uint8_t*)"I2C", TASKS_I2C_DEADLINE_MS, &i2c_activity);
+	}
+
+	if (err != APP_OK) {
+		return err;
+	}
+
+	uartSetRxCallback(wake_cmdparser);
+	views_set_button_callback(wake_views);
+	lcd_set_update_callback(wake_lcd);
+	sched_reset_stats();
+
+	// The first run prints the prompt, and the welcome frame may be pending
+	wake_cmdparser();
+	wake_lcd();
+
+	return APP_OK;
+}
+
+/**
+ * @brief runs one state of the cmdparser and schedules the next one
+ *
+ */
+void run_cmdparser(uint32_t events) {
+	uint32_t wait = cmdparser_read_cmd();
+	watchdog_checkin(cmdparser_activity, wait == CMDPARSER_WAIT_INPUT);
+
+	if (wait == CMDPARSER_WAIT_INPUT) {
+		return;
+	}
+
+	// States run one per event, so the other tasks are not held while a command is handled
+	if (wait == 0) {
+		wake_cmdparser();
+		return;
+	}
+
+	sched_timer_start(cmdparser_timer, wait, 0);
+}
+
+void run_views(uint32_t events) {
+	views_process();
+}
+
+/**
+ * @brief writes the pending frame when the refresh period allows it, or waits for it
+ *
+ */
+void run_lcd(uint32_t events) {
+	lcd_refresh();
+
+	uint32_t delay = lcd_get_refresh_delay();
+	watchdog_checkin(lcd_activity, delay == LCD_NO_REFRESH);
+	if (delay != LCD_NO_REFRESH) {
+		sched_timer_start(lcd_timer, delay, 0);
+	}
+
+	// The rows are written in the background, their timeouts are checked by the I2C task
+	if (!I2C_is_idle()) {
+		wake_i2c();
+	}
+}
+
+void run_i2c(uint32_t events) {
+	I2C_process();
+
+	bool idle = I2C_is_idle();
+	watchdog_checkin(i2c_activity, idle);
+	if (!idle) {
+		sched_timer_start(i2c_timer, TASKS_I2C_CHECK_PERIOD_MS, 0);
+	}
+}
+
+/**
+ * @brief posts an event to the cmdparser, it is called from the UART interrupt too
+ *
+ */
+void wake_cmdparser() {
+	watchdog_expect(cmdparser_activity);
+	sched_post(cmdparser_task, EVENT_WAKE_UP);
+}
+
+/**
+ * @brief posts an event to the views, it is called from the EXTI interrupt
+ *
+ */
+void wake_views() {
+	sched_post(views_task, EVENT_WAKE_UP);
+}
+
+/**
+ * @brief posts an event to the LCD, it can be called from the I2C interrupts
+ *
+ */
+void wake_lcd() {
+	watchdog_expect(lcd_activity);
+	sched_post(lcd_task, EVENT_WAKE_UP);
+}
+
+void wake_i2c() {
+	watchdog_expect(i2c_activity);
+	sched_post(i2c_task, EVENT_WAKE_UP);
+}
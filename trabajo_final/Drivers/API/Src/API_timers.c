@@ -0,0 +1,396 @@
+#include "API_timers.h"
+#include "port.h"
+#include "stm32f4xx.h"
+#include <stddef.h>
+
+// Each level has 64 slots, a slot of a level spans the 64 slots of the level below
+#define WHEEL_LEVELS 4
+#define SLOT_BITS 6
+#define SLOTS_PER_LEVEL (1 << SLOT_BITS)
+#define SLOT_MASK (SLOTS_PER_LEVEL - 1)
+
+// Longest delay the wheel holds, longer ones are placed at its end and placed again when they cascade
+#define MAX_WHEEL_DELAY ((1UL << (SLOT_BITS * WHEEL_LEVELS)) - 1)
+
+// End of the list of timers of a slot
+#define NO_TIMER 0xFF
+
+typedef struct {
+	timer_callback_t callback;
+	void* context;
+	uint32_t expiry;
+	uint32_t period;
+	bool running;
+	// Expired in the slot being fired and its callback not called yet
+	bool expired;
+	uint8_t level;
+	uint8_t slot;
+	uint8_t prev;
+	uint8_t next;
+} wheel_timer_t;
+
+static wheel_timer_t timers[TIMERS_MAX];
+static uint8_t amount_of_timers = 0;
+
+// First timer of every slot, and one bit per slot that has timers
+static uint8_t slots[WHEEL_LEVELS][SLOTS_PER_LEVEL];
+static uint64_t occupied[WHEEL_LEVELS];
+
+// Next tick to process, every timer that expires before it already fired
+static uint32_t wheel_tick = 0;
+static bool initialized = false;
+
+// Prototypes
+static void insert_timer(uint8_t id);
+static void unlink_timer(uint8_t id);
+static uint8_t detach_slot(uint8_t level, uint8_t slot);
+static uint8_t cascade(uint8_t level);
+static void fire_slot(uint8_t slot, uint32_t now);
+static bool get_next_event(uint32_t* next_event);
+static bool is_before(uint32_t tick, uint32_t reference);
+
+/**
+ * @brief empties the wheel and aligns it with the current tick
+ *
+ * @note it must be called after port_init(), the tick interrupt does nothing until then
+ */
+void timers_init() {
+	for (uint8_t level = 0; level < WHEEL_LEVELS; level++) {
+		for (uint8_t slot = 0; slot < SLOTS_PER_LEVEL; slot++) {
+			slots[level][slot] = NO_TIMER;
+		}
+
+		occupied[level] = 0;
+	}
+
+	amount_of_timers = 0;
+	wheel_tick = port_now();
+	initialized = true;
+}
+
+/**
+ * @brief creates a stopped timer
+ *
+ * @param context: given to the callback as is
+ * @param id: where the identifier of the timer is written
+ *
+ * @return
+ * - APP_OK: if the timer is created
+ * - APP_ERR_INVALID_ARG: if callback or id is NULL
+ * - TIMERS_ERR_TABLE_FULL: if there are already TIMERS_MAX timers
+ */
+app_err_t timers_create(timer_callback_t callback, void* context, timer_id_t* id) {
+	if (callback == NULL || id == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (amount_of_timers >= TIMERS_MAX) {
+		return TIMERS_ERR_TABLE_FULL;
+	}
+
+	timers[amount_of_timers] = (wheel_timer_t){
+			.callback = callback,
+			.context = context,
+			.prev = NO_TIMER,
+			.next = NO_TIMER,
+	};
+
+	*id = amount_of_timers++;
+	return APP_OK;
+}
+
+/**
+ * @brief starts the timer, or restarts it if it is already running
+ *
+ * @param delay_ms: time until it expires for the first time, 0 expires on the next tick
+ * @param period_ms: time between the following expirations, 0 for a one-shot timer
+ *
+ * @note it can be called from the callbacks
+ *
+ * @return APP_OK if the timer is started, otherwise TIMERS_ERR_INVALID_TIMER
+ */
+app_err_t timers_start(timer_id_t id, uint32_t delay_ms, uint32_t period_ms) {
+	if (id >= amount_of_timers) {
+		return TIMERS_ERR_INVALID_TIMER;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	wheel_timer_t* timer = &timers[id];
+	if (timer->running) {
+		unlink_timer(id);
+	}
+
+	timer->expired = false;
+	timer->expiry = port_now() + delay_ms;
+	timer->period = period_ms;
+	insert_timer(id);
+
+	__set_PRIMASK(primask);
+	return APP_OK;
+}
+
+/**
+ * @brief stops the timer, nothing happens if it is not running
+ *
+ * @return APP_OK if the timer is stopped, otherwise TIMERS_ERR_INVALID_TIMER
+ */
+app_err_t timers_stop(timer_id_t id) {
+	if (id >= amount_of_timers) {
+		return TIMERS_ERR_INVALID_TIMER;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (timers[id].running) {
+		unlink_timer(id);
+	}
+
+	timers[id].expired = false;
+	__set_PRIMASK(primask);
+	return APP_OK;
+}
+
+/**
+ * @brief advances the wheel up to the current tick and calls the callbacks of the expired timers
+ *
+ * Every tick empties one slot of the first level, and the first tick of each lap of a level moves the timers
+ * of the next slot of the level above down the wheel. Ticks missed while the tick interrupt was suppressed
+ * are caught up, skipping the laps of the first level that have no timers.
+ *
+ * @note on the board it is called from the tick interrupt, elsewhere from the main loop
+ */
+void timers_process() {
+	if (!initialized) {
+		return;
+	}
+
+	uint32_t now = port_now();
+
+	while (!is_before(now, wheel_tick)) {
+		uint8_t slot = wheel_tick & SLOT_MASK;
+
+		// A level only cascades when the one below starts a new lap too
+		if (slot == 0) {
+			for (uint8_t level = 1; level < WHEEL_LEVELS && cascade(level) == 0; level++);
+		}
+
+		if (occupied[0] == 0) {
+			uint32_t next_lap = (wheel_tick | SLOT_MASK) + 1;
+			wheel_tick = is_before(now, next_lap) ? now + 1 : next_lap;
+			continue;
+		}
+
+		fire_slot(slot, now);
+	}
+}
+
+/**
+ * @brief returns the time until the wheel has work to do: a timer expires or timers move down the wheel
+ *
+ * @note timers of the upper levels are not sorted, so the wheel may ask to be processed before the first
+ * expiry to cascade them
+ *
+ * @return 0 if there is work pending already, TIMERS_NO_EXPIRY if no timer is running
+ */
+uint32_t timers_get_sleep_time() {
+	uint32_t next_event = 0;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	bool running = get_next_event(&next_event);
+	__set_PRIMASK(primask);
+
+	if (!running) {
+		return TIMERS_NO_EXPIRY;
+	}
+
+	uint32_t now = port_now();
+	return is_before(now, next_event) ? next_event - now : 0;
+}
+
+/**
+ * @brief adds the timer to the slot that covers its expiry, in the lowest level whose lap reaches it
+ *
+ * Expired timers go to the slot of the next tick, timers beyond the wheel to the last slot it reaches.
+ *
+ */
+void insert_timer(uint8_t id) {
+	wheel_timer_t* timer = &timers[id];
+
+	uint32_t place = timer->expiry;
+	if (is_before(place, wheel_tick)) {
+		place = wheel_tick;
+	} else if (place - wheel_tick > MAX_WHEEL_DELAY) {
+		place = wheel_tick + MAX_WHEEL_DELAY;
+	}
+
+	uint32_t delay = place - wheel_tick;
+	uint8_t level = 0;
+	while (level < WHEEL_LEVELS - 1 && delay >= (1UL << (SLOT_BITS * (level + 1)))) {
+		level++;
+	}
+
+	uint8_t slot = (place >> (SLOT_BITS * level)) & SLOT_MASK;
+	uint8_t head = slots[level][slot];
+
+	timer->level = level;
+	timer->slot = slot;
+	timer->prev = NO_TIMER;
+	timer->next = head;
+	if (head != NO_TIMER) {
+		timers[head].prev = id;
+	}
+
+	slots[level][slot] = id;
+	occupied[level] |= (uint64_t)1 << slot;
+	timer->running = true;
+}
+
+void unlink_timer(uint8_t id) {
+	wheel_timer_t* timer = &timers[id];
+
+	if (timer->prev != NO_TIMER) {
+		timers[timer->prev].next = timer->next;
+	} else {
+		slots[timer->level][timer->slot] = timer->next;
+	}
+
+	if (timer->next != NO_TIMER) {
+		timers[timer->next].prev = timer->prev;
+	}
+
+	if (slots[timer->level][timer->slot] == NO_TIMER) {
+		occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+	}
+
+	timer->prev = NO_TIMER;
+	timer->next = NO_TIMER;
+	timer->running = false;
+}
+
+/**
+ * @brief empties the slot
+ *
+ * @return the first timer of the list that was in it, the others follow through next
+ */
+uint8_t detach_slot(uint8_t level, uint8_t slot) {
+	uint8_t first = slots[level][slot];
+	slots[level][slot] = NO_TIMER;
+	occupied[level] &= ~((uint64_t)1 << slot);
+
+	return first;
+}
+
+/**
+ * @brief moves the timers of the current slot of the level to the levels below
+ *
+ * @return the index of the slot, 0 when the level starts a new lap
+ */
+uint8_t cascade(uint8_t level) {
+	uint8_t slot = (wheel_tick >> (SLOT_BITS * level)) & SLOT_MASK;
+	uint8_t id = detach_slot(level, slot);
+
+	while (id != NO_TIMER) {
+		uint8_t next = timers[id].next;
+		insert_timer(id);
+		id = next;
+	}
+
+	return slot;
+}
+
+/**
+ * @brief calls the callbacks of the timers in the slot of the first level and moves to the next tick
+ *
+ * The expired timers are taken out of the wheel before any callback runs, so the callbacks can start or stop
+ * any timer. One that is started or stopped before its own callback runs is not fired. Periodic timers are
+ * inserted again before their callback runs, and a late one keeps its cadence, the expirations it missed are
+ * not fired twice.
+ *
+ */
+void fire_slot(uint8_t slot, uint32_t now) {
+	uint8_t expired[TIMERS_MAX];
+	uint8_t amount_expired = 0;
+
+	uint8_t id = detach_slot(0, slot);
+	wheel_tick++;
+
+	while (id != NO_TIMER) {
+		wheel_timer_t* timer = &timers[id];
+		expired[amount_expired++] = id;
+		id = timer->next;
+
+		timer->prev = NO_TIMER;
+		timer->next = NO_TIMER;
+		timer->running = false;
+		timer->expired = true;
+	}
+
+	for (uint8_t idx = 0; idx < amount_expired; idx++) {
+		wheel_timer_t* timer = &timers[expired[idx]];
+		if (!timer->expired) {
+			continue;
+		}
+
+		timer->expired = false;
+
+		if (timer->period > 0) {
+			timer->expiry += timer->period;
+			if (!is_before(now, timer->expiry)) {
+				timer->expiry = now + timer->period;
+			}
+
+			insert_timer(expired[idx]);
+		}
+
+		timer->callback(timer->context);
+	}
+}
+
+/**
+ * @brief finds the first tick at which an occupied slot is reached, in any level
+ *
+ * The slots of a level are reached at the start of their lap of the level below, the search starts at the
+ * first of those ticks not processed yet and goes around the level once.
+ *
+ * @return true if a slot is occupied, in which case its tick is written in next_event
+ */
+bool get_next_event(uint32_t* next_event) {
+	bool found = false;
+
+	for (uint8_t level = 0; level < WHEEL_LEVELS; level++) {
+		if (occupied[level] == 0) {
+			continue;
+		}
+
+		uint32_t span = 1UL << (SLOT_BITS * level);
+		uint32_t start = (wheel_tick + span - 1) & ~(span - 1);
+		uint8_t current = (start >> (SLOT_BITS * level)) & SLOT_MASK;
+
+		// The bits are rotated so the current slot comes first
+		uint64_t ahead = occupied[level] >> current;
+		if (current > 0) {
+			ahead |= occupied[level] << (SLOTS_PER_LEVEL - current);
+		}
+
+		uint32_t tick = start + (uint32_t)__builtin_ctzll(ahead) * span;
+		if (!found || is_before(tick, *next_event)) {
+			*next_event = tick;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/**
+ * @brief compares two ticks
+ *
+ * @note the difference is taken as signed, so it is correct when the tick wraps around
+ */
+bool is_before(uint32_t tick, uint32_t reference) {
+	return (int32_t)(tick - reference) < 0;
+}
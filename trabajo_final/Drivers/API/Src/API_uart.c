@@ -1,13 +1,29 @@
 #include "API_uart.h"
 #include "stm32f4xx_hal.h"
+#include "timebase.h"
+#include "evtrace.h"
 
-// Rx/Tx timeout
+// Tx timeout
 static const uint32_t TIMEOUT = 1000;
 
 static UART_HandleTypeDef uart_handler;
 
+// Ring of received characters, written by the UART interrupt and read by uartReceiveStringSize()
+static uint8_t rx_buffer[UART_RX_BUFFER_SIZE];
+// Timebase microseconds when each character of the ring arrived
+static uint32_t rx_times_us[UART_RX_BUFFER_SIZE];
+static uint32_t last_read_us = 0;
+static volatile uint16_t rx_head = 0;
+static volatile uint16_t rx_count = 0;
+// Character being received by the interrupt
+static uint8_t rx_char;
+
+static uart_rx_callback_t rx_callback = NULL;
+static uart_tx_callback_t tx_callback = NULL;
+
 // Prototypes
 static uint16_t get_string_length(const uint8_t* pstring);
+static void start_reception();
 
 /**
  * @brief Initializes the UART peripheral.
@@ -21,6 +37,9 @@ static uint16_t get_string_length(const uint8_t* pstring);
  * - Mode: TX/RX
  * - Oversampling: 16
  *
+ * Reception is interrupt driven and starts right away, characters are kept until they are read with
+ * uartReceiveStringSize()
+ *
  * @return APP_OK if the UART was successfully initialized,
  *         UART_ERR_INIT otherwise.
  */
@@ -42,9 +61,37 @@ app_err_t uartInit() {
 		return UART_ERR_INIT;
 	}
 
+	HAL_NVIC_SetPriority(USART2_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(USART2_IRQn);
+	start_reception();
+
 	return APP_OK;
 }
 
+/**
+ * @brief Recomputes the baud rate divider after the APB1 clock changed.
+ *
+ * The UART is configured again with the same settings, which stops the reception in progress, so it is
+ * started again before any interrupt can find it stopped.
+ *
+ * @note it must not be called while a string is being sent
+ *
+ * @return APP_OK if the UART was successfully configured,
+ *         UART_ERR_INIT otherwise.
+ */
+app_err_t uartUpdateBaudRate() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	HAL_StatusTypeDef status = HAL_UART_Init(&uart_handler);
+	if (status == HAL_OK) {
+		start_reception();
+	}
+
+	__set_PRIMASK(primask);
+	return (status == HAL_OK) ? APP_OK : UART_ERR_INIT;
+}
+
 /**
  * @brief Sends a null-terminated string over UART.
  *
@@ -81,27 +128,111 @@ app_err_t uartSendStringSize(uint8_t* pstring, uint16_t size) {
 		return APP_ERR_INVALID_ARG;
 	}
 
+	if (tx_callback != NULL) {
+		tx_callback();
+	}
 
 	return (HAL_UART_Transmit(&uart_handler, pstring, size, TIMEOUT) != HAL_OK) ? UART_ERR_TX : APP_OK;
 }
 
 /**
- * @brief Receives a fixed-size string over UART.
+ * @brief Reads the characters received over UART, without waiting for more.
  *
- * Reads exactly @p size bytes from UART into the given buffer.
+ * Copies up to @p size characters already received into the given buffer.
  *
  * @param pstring  Pointer to the buffer where received data will be stored.
- * @param size     Number of bytes to receive, must be greater than 0.
+ * @param size     Maximum number of bytes to read, must be greater than 0.
+ * @param received Where the number of bytes read is written, 0 if nothing was received.
  *
- * @return APP_OK if the message is received correctly, otherwise the corresponding error
+ * @return APP_OK if the buffer is read correctly, otherwise the corresponding error
  *
  */
-app_err_t uartReceiveStringSize(uint8_t* pstring, uint16_t size) {
-	if (pstring == NULL || size == 0) {
+app_err_t uartReceiveStringSize(uint8_t* pstring, uint16_t size, uint16_t* received) {
+	if (pstring == NULL || size == 0 || received == NULL) {
 		return APP_ERR_INVALID_ARG;
 	}
 
-	return (HAL_UART_Receive(&uart_handler, pstring, size, TIMEOUT) != HAL_OK) ? UART_ERR_RX : APP_OK;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint16_t amount = (rx_count < size) ? rx_count : size;
+	for (uint16_t idx = 0; idx < amount; idx++) {
+		pstring[idx] = rx_buffer[rx_head];
+		last_read_us = rx_times_us[rx_head];
+		rx_head = (rx_head + 1) % UART_RX_BUFFER_SIZE;
+	}
+
+	rx_count -= amount;
+	__set_PRIMASK(primask);
+
+	*received = amount;
+	return APP_OK;
+}
+
+/**
+ * @brief returns the timebase microseconds when the last character read with uartReceiveStringSize() arrived
+ *
+ */
+uint32_t uartGetRxTimeUs() {
+	return last_read_us;
+}
+
+/**
+ * @brief sets the function called from the interrupt every time a character is received, NULL to remove it
+ *
+ */
+void uartSetRxCallback(uart_rx_callback_t callback) {
+	rx_callback = callback;
+}
+
+/**
+ * @brief sets the function called right before every string is sent, NULL to remove it
+ *
+ */
+void uartSetTxCallback(uart_tx_callback_t callback) {
+	tx_callback = callback;
+}
+
+/**
+ * @brief handles the USART2 interrupt, it must be called from USART2_IRQHandler
+ *
+ */
+void uartIRQHandler() {
+	HAL_UART_IRQHandler(&uart_handler);
+}
+
+/**
+ * @brief stores the received character and waits for the next one
+ *
+ */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart) {
+	if (huart != &uart_handler) {
+		return;
+	}
+
+	if (rx_count < UART_RX_BUFFER_SIZE) {
+		uint16_t tail = (rx_head + rx_count) % UART_RX_BUFFER_SIZE;
+		rx_buffer[tail] = rx_char;
+		rx_times_us[tail] = timebase_now_us();
+		rx_count++;
+	}
+
+	start_reception();
+
+	if (rx_callback != NULL) {
+		rx_callback();
+	}
+}
+
+/**
+ * @brief a framing, parity or overrun error aborts the reception, so it is started again
+ *
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
+	if (huart == &uart_handler) {
+		EVTRACE(EVTRACE_UART_ERROR, huart->ErrorCode);
+		start_reception();
+	}
 }
 
 /**
@@ -125,5 +256,10 @@ uint16_t get_string_length(const uint8_t* pstring) {
 	return counter;
 }
 
-
-
+/**
+ * @brief receives the next character in the background
+ *
+ */
+void start_reception() {
+	HAL_UART_Receive_IT(&uart_handler, &rx_char, 1);
+}
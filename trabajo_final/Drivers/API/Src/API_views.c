@@ -0,0 +1,407 @@
+#include "API_views.h"
+#include "API_lcd.h"
+#include "API_format.h"
+#include "port.h"
+#include <math.h>
+#include <stddef.h>
+
+#define ROW_LENGTH LCD_COLS
+#define ROWS_PER_PAGE 2
+#define MEASUREMENT_PRECISION 2
+#define RANGE_PRECISION 1
+
+// Magnus coefficients of Sonntag (1990), within 0.35°C from -45°C to 60°C over water
+#define MAGNUS_B 17.62
+#define MAGNUS_C 243.12
+
+// Codes to display % and ° correctly in the LCD
+#define PERCENTAGE_SYMBOL_CODE 0x25
+#define DEGREE_SYMBOL_CODE 0xDF
+
+typedef struct {
+	uint8_t text[ROW_LENGTH + 1];
+	uint8_t length;
+} view_row_t;
+
+typedef struct {
+	double min;
+	double max;
+	bool valid;
+} view_range_t;
+
+static uint8_t TEMP_PREFIX[] = "TEMP: ";
+static uint8_t HUM_PREFIX[] = "HUM: ";
+static uint8_t DEW_PREFIX[] = "DEW: ";
+static uint8_t SAMPLES_PREFIX[] = "SAMPLES: ";
+static uint8_t OK_PREFIX[] = "I2C OK:";
+static uint8_t ERR_PREFIX[] = " ERR:";
+static uint8_t NO_DATA_MSG[] = "NO DATA";
+static uint8_t NO_ERRORS_MSG[] = "NO ERRORS";
+static uint8_t NO_VALUE_MSG[] = "--";
+
+static view_page_t current_page;
+static volatile bool page_switch_pending;
+static volatile uint32_t last_press_tick;
+static views_button_callback_t button_callback = NULL;
+
+// Cached data, every page is rendered from here so switching pages never touches the sensor
+static ht_measurement_t last_measurement;
+static bool has_measurement;
+static uint8_t range_unit;
+static view_range_t temp_range;
+static view_range_t hum_range;
+static uint32_t reads_ok;
+static uint32_t reads_failed;
+static app_err_t last_error;
+
+// Prototypes
+static app_err_t render_page();
+static uint8_t build_current_rows(view_row_t* rows);
+static uint8_t build_min_max_rows(view_row_t* rows);
+static uint8_t build_derived_rows(view_row_t* rows);
+static uint8_t build_link_rows(view_row_t* rows);
+static void update_range(view_range_t* range, double value);
+static double get_dew_point(double temp_celsius, double hum);
+static void row_append_text(view_row_t* row, uint8_t* text);
+static void row_append_char(view_row_t* row, uint8_t character);
+static void row_append_value(view_row_t* row, double value, uint8_t precision);
+static void row_append_uint(view_row_t* row, uint32_t value);
+
+/**
+ * @brief inits the view manager
+ *
+ * Clears the cached data and selects the current values page
+ *
+ */
+void views_init() {
+	current_page = VIEW_CURRENT;
+	page_switch_pending = false;
+	last_press_tick = 0;
+	has_measurement = false;
+	temp_range.valid = false;
+	hum_range.valid = false;
+	reads_ok = 0;
+	reads_failed = 0;
+	last_error = APP_OK;
+}
+
+/**
+ * @brief caches a new measurement and shows it on the current values page
+ *
+ * @param measurement: result of the last measurement
+ *
+ * @return
+ *  - APP_OK: if the page is rendered correctly
+ *  - APP_ERR_INVALID_ARG: if measurement is NULL
+ *  - APP_ERR_INTERNAL: in case of an error
+ */
+app_err_t views_show_measurement(ht_measurement_t* measurement) {
+	if (measurement == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	last_measurement = *measurement;
+	has_measurement = true;
+
+	if (!isnan(measurement->temp_data.temp)) {
+		// The range is kept in a single unit, if the user asks for another one it starts again
+		if (*measurement->temp_data.unit != range_unit) {
+			range_unit = *measurement->temp_data.unit;
+			temp_range.valid = false;
+		}
+
+		update_range(&temp_range, measurement->temp_data.temp);
+	}
+
+	if (!isnan(measurement->hum)) {
+		update_range(&hum_range, measurement->hum);
+	}
+
+	current_page = VIEW_CURRENT;
+	return render_page();
+}
+
+/**
+ * @brief records the result of a sensor read for the link status page
+ *
+ * @param err: result of the read
+ */
+void views_record_read(app_err_t err) {
+	if (err == APP_OK) {
+		reads_ok++;
+		return;
+	}
+
+	reads_failed++;
+	last_error = err;
+}
+
+/**
+ * @brief handles a press of the B1 button
+ *
+ * @note it is called from the EXTI interrupt, so it only debounces and flags the page switch
+ */
+void views_button_pressed() {
+	uint32_t now = port_now();
+	if (now - last_press_tick < VIEWS_DEBOUNCE_MS) {
+		return;
+	}
+
+	last_press_tick = now;
+	page_switch_pending = true;
+
+	if (button_callback != NULL) {
+		button_callback();
+	}
+}
+
+/**
+ * @brief sets the function called when a press of the button is accepted, NULL to remove it
+ *
+ */
+void views_set_button_callback(views_button_callback_t callback) {
+	button_callback = callback;
+}
+
+/**
+ * @brief switches to the next page if the button was pressed
+ *
+ * @return APP_OK if there is nothing to do or the page is rendered correctly, otherwise APP_ERR_INTERNAL
+ */
+app_err_t views_process() {
+	if (!page_switch_pending) {
+		return APP_OK;
+	}
+
+	page_switch_pending = false;
+	current_page = (current_page + 1) % VIEW_COUNT;
+
+	return render_page();
+}
+
+/**
+ * @brief renders the current page into the LCD frame
+ *
+ * The frame is written to the screen by lcd_refresh(), so rendering never waits for the display bus
+ *
+ * @return APP_OK if the page is rendered correctly, otherwise APP_ERR_INTERNAL
+ */
+app_err_t render_page() {
+	view_row_t rows[ROWS_PER_PAGE] = {0};
+	uint8_t amount_of_rows;
+
+	switch (current_page) {
+	case VIEW_MIN_MAX:
+		amount_of_rows = build_min_max_rows(rows);
+		break;
+	case VIEW_DERIVED:
+		amount_of_rows = build_derived_rows(rows);
+		break;
+	case VIEW_LINK:
+		amount_of_rows = build_link_rows(rows);
+		break;
+	default:
+		amount_of_rows = build_current_rows(rows);
+	}
+
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {
+		uint8_t* text = (row < amount_of_rows) ? rows[row].text : (uint8_t*)"";
+		if (lcd_update_row(row, text) != APP_OK) {
+			return APP_ERR_INTERNAL;
+		}
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief builds the rows with the last measured values
+ *
+ * @return the amount of rows built
+ */
+uint8_t build_current_rows(view_row_t* rows) {
+	uint8_t amount_of_rows = 0;
+
+	if (has_measurement && !isnan(last_measurement.temp_data.temp)) {
+		view_row_t* row = &rows[amount_of_rows++];
+		row_append_text(row, TEMP_PREFIX);
+		row_append_value(row, last_measurement.temp_data.temp, MEASUREMENT_PRECISION);
+		row_append_char(row, DEGREE_SYMBOL_CODE);
+		row_append_char(row, *last_measurement.temp_data.unit);
+	}
+
+	if (has_measurement && !isnan(last_measurement.hum)) {
+		view_row_t* row = &rows[amount_of_rows++];
+		row_append_text(row, HUM_PREFIX);
+		row_append_value(row, last_measurement.hum, MEASUREMENT_PRECISION);
+		row_append_char(row, PERCENTAGE_SYMBOL_CODE);
+	}
+
+	if (amount_of_rows == 0) {
+		row_append_text(&rows[amount_of_rows++], NO_DATA_MSG);
+	}
+
+	return amount_of_rows;
+}
+
+/**
+ * @brief builds the rows with the minimum and maximum values seen, as "T min/max" and "H min/max"
+ *
+ * @return the amount of rows built
+ */
+uint8_t build_min_max_rows(view_row_t* rows) {
+	view_row_t* temp_row = &rows[0];
+	row_append_text(temp_row, (uint8_t*)"T ");
+	if (temp_range.valid) {
+		row_append_value(temp_row, temp_range.min, RANGE_PRECISION);
+		row_append_char(temp_row, '/');
+		row_append_value(temp_row, temp_range.max, RANGE_PRECISION);
+		row_append_char(temp_row, DEGREE_SYMBOL_CODE);
+		row_append_char(temp_row, range_unit);
+	} else {
+		row_append_text(temp_row, NO_VALUE_MSG);
+	}
+
+	view_row_t* hum_row = &rows[1];
+	row_append_text(hum_row, (uint8_t*)"H ");
+	if (hum_range.valid) {
+		row_append_value(hum_row, hum_range.min, RANGE_PRECISION);
+		row_append_char(hum_row, '/');
+		row_append_value(hum_row, hum_range.max, RANGE_PRECISION);
+		row_append_char(hum_row, PERCENTAGE_SYMBOL_CODE);
+	} else {
+		row_append_text(hum_row, NO_VALUE_MSG);
+	}
+
+	return 2;
+}
+
+/**
+ * @brief builds the rows with the dew point and the amount of samples taken
+ *
+ * The dew point needs temperature and humidity from the same reading (GET TEMP&HUM), it is not shown
+ * for a humidity of 0%.
+ *
+ * @return the amount of rows built
+ */
+uint8_t build_derived_rows(view_row_t* rows) {
+	view_row_t* dew_row = &rows[0];
+	row_append_text(dew_row, DEW_PREFIX);
+
+	double dew_point = NAN;
+	bool has_both = has_measurement && !isnan(last_measurement.temp_data.temp) && !isnan(last_measurement.hum);
+	if (has_both) {
+		double temp_celsius = last_measurement.temp_data.temp;
+		if (*last_measurement.temp_data.unit == 'K') {
+			temp_celsius -= 273.15;
+		} else if (*last_measurement.temp_data.unit == 'F') {
+			temp_celsius = (temp_celsius - 32) * 5 / 9;
+		}
+
+		dew_point = get_dew_point(temp_celsius, last_measurement.hum);
+	}
+
+	if (!isnan(dew_point)) {
+		row_append_value(dew_row, dew_point, MEASUREMENT_PRECISION);
+		row_append_char(dew_row, DEGREE_SYMBOL_CODE);
+		row_append_char(dew_row, 'C');
+	} else {
+		row_append_text(dew_row, NO_VALUE_MSG);
+	}
+
+	view_row_t* samples_row = &rows[1];
+	row_append_text(samples_row, SAMPLES_PREFIX);
+	row_append_uint(samples_row, reads_ok);
+
+	return 2;
+}
+
+/**
+ * @brief computes the dew point with the Magnus formula
+ *
+ * gamma = ln(RH / 100) + b * T / (c + T), Td = c * gamma / (b - gamma)
+ *
+ * @return the dew point in °C, or NAN if the humidity is not above 0%
+ */
+double get_dew_point(double temp_celsius, double hum) {
+	if (!(hum > 0)) {
+		return NAN;
+	}
+
+	double gamma = log(hum / 100) + MAGNUS_B * temp_celsius / (MAGNUS_C + temp_celsius);
+	return MAGNUS_C * gamma / (MAGNUS_B - gamma);
+}
+
+/**
+ * @brief builds the rows with the sensor link counters and the last error
+ *
+ * @return the amount of rows built
+ */
+uint8_t build_link_rows(view_row_t* rows) {
+	view_row_t* counters_row = &rows[0];
+	row_append_text(counters_row, OK_PREFIX);
+	row_append_uint(counters_row, reads_ok);
+	row_append_text(counters_row, ERR_PREFIX);
+	row_append_uint(counters_row, reads_failed);
+
+	row_append_text(&rows[1], (last_error == APP_OK) ? NO_ERRORS_MSG : app_err_to_name(last_error));
+
+	return 2;
+}
+
+/**
+ * @brief extends the range with the given value
+ *
+ */
+void update_range(view_range_t* range, double value) {
+	if (!range->valid) {
+		range->min = value;
+		range->max = value;
+		range->valid = true;
+		return;
+	}
+
+	if (value < range->min) {
+		range->min = value;
+	}
+
+	if (value > range->max) {
+		range->max = value;
+	}
+}
+
+/**
+ * @brief appends the given text to the row, the text is truncated if it does not fit
+ *
+ */
+void row_append_text(view_row_t* row, uint8_t* text) {
+	while (*text && row->length < ROW_LENGTH) {
+		row->text[row->length++] = *text++;
+	}
+}
+
+/**
+ * @brief appends a character to the row if there is room for it
+ *
+ */
+void row_append_char(view_row_t* row, uint8_t character) {
+	if (row->length < ROW_LENGTH) {
+		row->text[row->length++] = character;
+	}
+}
+
+/**
+ * @brief appends the value with the given amount of decimals, nothing is appended if it does not fit
+ *
+ */
+void row_append_value(view_row_t* row, double value, uint8_t precision) {
+	row->length += fmt_double(&row->text[row->length], ROW_LENGTH - row->length, value, precision, 0);
+}
+
+/**
+ * @brief appends an unsigned value, nothing is appended if it does not fit
+ *
+ */
+void row_append_uint(view_row_t* row, uint32_t value) {
+	row->length += fmt_uint(&row->text[row->length], ROW_LENGTH - row->length, value, 0);
+}
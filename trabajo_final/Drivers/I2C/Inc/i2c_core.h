@@ -7,9 +7,144 @@
 
 #define I2C_ERR_TX   (ERR_BASE_I2C + 1)
 #define I2C_ERR_RX   (ERR_BASE_I2C + 2)
+#define I2C_ERR_QUEUE_FULL   (ERR_BASE_I2C + 3)
+#define I2C_ERR_TIMEOUT   (ERR_BASE_I2C + 4)
+#define I2C_ERR_NO_DEVICE   (ERR_BASE_I2C + 5)
+#define I2C_ERR_TABLE_FULL   (ERR_BASE_I2C + 6)
+#define I2C_ERR_BUS_STUCK   (ERR_BASE_I2C + 7)
+#define I2C_ERR_NACK   (ERR_BASE_I2C + 8)
+
+// Maximum amount of transactions of each priority class waiting for the bus, including the one in progress
+#define I2C_QUEUE_LENGTH 8
+
+#define I2C_FLAG_NONE 0x00
+// The transaction goes to the high priority queue even if its device is a low priority one
+#define I2C_FLAG_HIGH_PRIORITY 0x01
+// A write without read that can be split into several transfers, each one with its own START and STOP
+#define I2C_FLAG_CHUNKED 0x02
+
+// Longest time a high priority transaction may wait for a chunk of a low priority one to finish
+#define I2C_MAX_JITTER_US 500
+
+/*
+ * High priority transactions (sensor reads on a sampling deadline) always start before low priority ones
+ * (display updates). The bus is never taken away from a transfer in progress, priorities are applied at
+ * transaction boundaries and between the chunks of I2C_FLAG_CHUNKED writes.
+ */
+typedef enum {
+	I2C_PRIORITY_LOW,
+	I2C_PRIORITY_HIGH,
+	I2C_PRIORITY_COUNT,
+} i2c_priority_t;
+
+// Bus speeds supported by I2C1, Fast-mode Plus (1 MHz) is only available on FMPI2C1
+#define I2C_BUS_SPEED_STANDARD 100000
+#define I2C_BUS_SPEED_FAST 400000
+
+// Maximum amount of devices with their own speed profile
+#define I2C_MAX_DEVICES 4
+
+// Buses managed by the core, each one has its own queues so transfers on different buses run in parallel
+typedef enum {
+	I2C_BUS_1, // I2C1: PB8 SCL, PB9 SDA
+	I2C_BUS_3, // I2C3: PA8 SCL, PC9 SDA
+	I2C_BUS_COUNT,
+} i2c_bus_id_t;
+
+/*
+ * Bus of each device of the board. Both are on I2C1 by default, build with -DI2C_LCD_BUS=I2C_BUS_3 after
+ * wiring the LCD backpack to I2C3 so display refreshes never wait for sensor reads.
+ */
+#ifndef I2C_HT_SENSOR_BUS
+#define I2C_HT_SENSOR_BUS I2C_BUS_1
+#endif
+
+#ifndef I2C_LCD_BUS
+#define I2C_LCD_BUS I2C_BUS_1
+#endif
+
+// Range of 7-bit addresses probed by I2C_scan(), the rest are reserved by the I2C specification
+#define I2C_SCAN_FIRST_ADDRESS 0x08
+#define I2C_SCAN_LAST_ADDRESS 0x77
+
+// Profile and health counters of a registered device, latencies go from I2C_submit() to the callback
+typedef struct {
+	uint16_t address;
+	i2c_bus_id_t bus;
+	uint32_t speed;
+	uint32_t completed;
+	uint32_t nacks;
+	uint32_t errors;
+	uint32_t avg_latency_us;
+	uint32_t max_latency_us;
+} i2c_device_info_t;
+
+// Margin added to the time a transfer needs at the device speed before it is considered stuck
+#define I2C_DEFAULT_TIMEOUT_MS 2
+
+// Called from interrupt context when a transaction finishes, result is APP_OK or the corresponding error
+typedef void (*i2c_callback_t)(app_err_t result, void* context);
+
+// Maximum amount of segments of a vectored write
+#define I2C_MAX_SEGMENTS 4
+
+// Part of a vectored write, the segments are sent back to back as a single write
+typedef struct {
+	uint8_t* buffer;
+	uint16_t size;
+} i2c_segment_t;
+
+/*
+ * A transaction writes tx_size bytes and then reads rx_size bytes, either of them can be 0.
+ * If tx_segments is set the write is made of tx_segment_count segments and tx_buffer is ignored.
+ * A write followed by a read uses a repeated START, so no other master or transaction can get in between.
+ * The buffers must remain valid until the callback is called.
+ */
+typedef struct {
+	uint16_t address;
+	uint8_t* tx_buffer;
+	uint16_t tx_size;
+	const i2c_segment_t* tx_segments;
+	uint8_t tx_segment_count;
+	uint8_t* rx_buffer;
+	uint16_t rx_size;
+	uint8_t flags;
+	i2c_callback_t callback;
+	void* context;
+} i2c_transaction_t;
+
+app_err_t I2C_submit(const i2c_transaction_t* transaction);
+
+bool I2C_is_idle();
+
+void I2C_update_clock();
+
+app_err_t I2C_register_device(uint16_t address, i2c_bus_id_t bus, uint32_t max_speed, i2c_priority_t priority);
+
+app_err_t I2C_set_device_timeout(uint16_t address, uint32_t timeout_ms);
+
+app_err_t I2C_probe_speed(uint16_t address, uint32_t* speed);
+
+uint32_t I2C_get_device_speed(uint16_t address);
+
+uint8_t I2C_get_amount_of_devices();
+
+app_err_t I2C_get_device_info(uint8_t idx, i2c_device_info_t* info);
+
+app_err_t I2C_scan(i2c_bus_id_t bus, uint8_t* amount_found);
+
+bool I2C_is_found(i2c_bus_id_t bus, uint16_t address);
+
+uint8_t* I2C_get_bus_name(i2c_bus_id_t bus);
+
+void I2C_process();
 
 app_err_t I2C_master_transmit(uint16_t device_address, uint8_t* message, uint16_t size);
 
 app_err_t I2C_master_receive(uint16_t device_address, uint8_t* buffer, uint16_t size);
 
+app_err_t I2C_write_read(uint16_t device_address, uint8_t* message, uint16_t message_size, uint8_t* buffer, uint16_t size);
+
+app_err_t I2C_write_vectored(uint16_t device_address, const i2c_segment_t* segments, uint8_t amount_of_segments);
+
 #endif /* I2C_INC_I2C_CORE_H_ */
@@ -0,0 +1,44 @@
+#ifndef I2C_INC_I2C_TRACE_H_
+#define I2C_INC_I2C_TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+// Build with -DI2C_TRACE_ENABLED=0 to remove the trace, the core then has no trace code at all
+#ifndef I2C_TRACE_ENABLED
+#define I2C_TRACE_ENABLED 1
+#endif
+
+// Amount of transfers kept, the oldest ones are overwritten
+#define I2C_TRACE_LENGTH 32
+
+typedef enum {
+	I2C_TRACE_WRITE,
+	I2C_TRACE_READ,
+} i2c_trace_direction_t;
+
+/*
+ * A traced transfer, which is a single START...STOP or START...repeated START frame.
+ * Timestamps are DWT cycles, so they wrap around after 2^32 cycles (about 23 s at 180 MHz).
+ */
+typedef struct {
+	uint32_t timestamp;
+	uint32_t duration;
+	uint16_t address;
+	uint16_t length;
+	i2c_trace_direction_t direction;
+	app_err_t result;
+} i2c_trace_record_t;
+
+#if I2C_TRACE_ENABLED
+
+void i2c_trace_record(uint16_t address, i2c_trace_direction_t direction, uint16_t length, app_err_t result, uint32_t start);
+
+uint8_t i2c_trace_snapshot(i2c_trace_record_t* buffer, uint8_t size);
+
+void i2c_trace_clear();
+
+#endif /* I2C_TRACE_ENABLED */
+
+#endif /* I2C_INC_I2C_TRACE_H_ */
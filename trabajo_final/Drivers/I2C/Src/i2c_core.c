@@ -1,14 +1,1242 @@
 #include "i2c_core.h"
+#include "i2c_trace.h"
 #include "stm32f4xx_hal.h"
+#include "cycles.h"
+#include "evtrace.h"
 
+// Upper bound for a whole synchronous transfer, including the time waiting in the queue
 static const uint32_t TIMEOUT = 1000;
 
+// A slave stuck in the middle of a byte releases SDA after at most 9 clocks, sent at 100 kHz
+static const uint8_t RECOVERY_PULSES = 9;
+static const uint32_t RECOVERY_HALF_PERIOD_NS = 5000;
+
+// BUSY stays set for a few microseconds after a STOP, a bus still busy after this many SCL periods is stuck
+static const uint32_t BUSY_WAIT_SCL_PERIODS = 4;
+
+// A byte is 8 data bits and the ACK, the START and the STOP of a chunk take about one clock each
+static const uint32_t CLOCKS_PER_BYTE = 9;
+static const uint32_t CHUNK_FRAMING_CLOCKS = 2;
+
+// A speed is accepted by the probe only if the device acknowledges every one of these attempts
+static const uint32_t PROBE_TRIALS = 8;
+static const uint32_t PROBE_TIMEOUT = 2;
+
+// Address-only probes of the scan, a present device answers the first one
+static const uint32_t SCAN_TRIALS = 1;
+static const uint32_t SCAN_TIMEOUT = 1;
+
+// Speeds tried by the probe, from the fastest one
+static const uint32_t PROBE_SPEEDS[] = {
+		I2C_BUS_SPEED_FAST,
+		I2C_BUS_SPEED_STANDARD,
+};
+
 extern I2C_HandleTypeDef hi2c1;
+extern I2C_HandleTypeDef hi2c3;
+
+// Phase of the transaction using the bus
+typedef enum {
+	PHASE_IDLE,
+	PHASE_TX,
+	PHASE_RX,
+} i2c_phase_t;
+
+// Profile of a device, devices that are not registered use I2C_BUS_1 at I2C_BUS_SPEED_STANDARD
+typedef struct {
+	uint16_t address;
+	i2c_bus_id_t bus;
+	uint32_t max_speed;
+	uint32_t speed;
+	i2c_priority_t priority;
+	uint32_t timeout_ms;
+
+	// Health counters
+	uint32_t completed;
+	uint32_t nacks;
+	uint32_t errors;
+	uint64_t latency_sum_us;
+	uint32_t latency_max_us;
+} i2c_device_t;
+
+// Entry of a queue, tx_done counts the bytes of a chunked write that are already sent, segment
+// is the write segment in progress and submit_cycles is when the transaction was queued
+typedef struct {
+	i2c_transaction_t transaction;
+	uint16_t tx_done;
+	uint8_t segment;
+	uint32_t submit_cycles;
+} queue_entry_t;
+
+// Circular queue of the transactions of one priority class, the head stays in it until it finishes
+typedef struct {
+	queue_entry_t entries[I2C_QUEUE_LENGTH];
+	volatile uint8_t head;
+	volatile uint8_t count;
+} i2c_queue_t;
+
+// State of a bus, every bus has its own queues so transfers on different buses run at the same time
+typedef struct {
+	I2C_HandleTypeDef* handle;
+	uint8_t* name;
+
+	// Pins driven as GPIO while the bus is recovered
+	GPIO_TypeDef* scl_port;
+	uint16_t scl_pin;
+	GPIO_TypeDef* sda_port;
+	uint16_t sda_pin;
+
+	i2c_queue_t queues[I2C_PRIORITY_COUNT];
+
+	// Queue whose head is using the bus, NULL when the bus is free
+	i2c_queue_t* volatile active_queue;
+	volatile i2c_phase_t phase;
+	volatile uint16_t chunk_size;
+
+	// Set when the bus must be recovered before its next transfer, I2C_process() does it in task context
+	volatile bool recovery_pending;
+
+	// Start tick, allowed duration and size of the transfer using the bus
+	volatile uint32_t transfer_start;
+	volatile uint32_t transfer_timeout;
+	volatile uint16_t transfer_size;
+
+#if I2C_TRACE_ENABLED
+	volatile uint32_t transfer_cycles;
+#endif
+
+	// Addresses that answered the last scan, one bit per address
+	uint8_t found[16];
+} i2c_bus_t;
+
+typedef struct {
+	volatile bool done;
+	volatile app_err_t result;
+} sync_status_t;
+
+static i2c_bus_t buses[I2C_BUS_COUNT] = {
+		[I2C_BUS_1] = {
+				.handle = &hi2c1,
+				.name = (uint8_t*)"I2C1",
+				.scl_port = GPIOB,
+				.scl_pin = GPIO_PIN_8,
+				.sda_port = GPIOB,
+				.sda_pin = GPIO_PIN_9,
+		},
+		[I2C_BUS_3] = {
+				.handle = &hi2c3,
+				.name = (uint8_t*)"I2C3",
+				.scl_port = GPIOA,
+				.scl_pin = GPIO_PIN_8,
+				.sda_port = GPIOC,
+				.sda_pin = GPIO_PIN_9,
+		},
+};
+
+static i2c_device_t devices[I2C_MAX_DEVICES];
+static uint8_t amount_of_devices = 0;
+
+// Prototypes
+static void start_next(i2c_bus_t* bus);
+static i2c_device_t* find_device(uint16_t address);
+static i2c_bus_t* get_device_bus(uint16_t address);
+static i2c_bus_t* find_bus(I2C_HandleTypeDef* handle);
+static bool is_bus_idle(i2c_bus_t* bus);
+static i2c_queue_t* get_next_queue(i2c_bus_t* bus);
+static bool wait_bus_free(i2c_bus_t* bus);
+static void set_bus_speed(i2c_bus_t* bus, uint32_t speed);
+static void configure_bus_clock(i2c_bus_t* bus);
+static bool wait_idle(i2c_bus_t* bus);
+static void start_phase(i2c_bus_t* bus, queue_entry_t* entry);
+static uint16_t max_chunk_size(uint32_t speed);
+static bool is_chunked(const i2c_transaction_t* transaction);
+static uint8_t count_tx_segments(const i2c_transaction_t* transaction);
+static i2c_segment_t get_tx_segment(const i2c_transaction_t* transaction, uint8_t idx);
+static bool is_valid_transaction(const i2c_transaction_t* transaction);
+static void start_timeout(i2c_bus_t* bus, i2c_device_t* device, uint16_t size);
+static bool recover_bus(i2c_bus_t* bus);
+static void recover_pending_bus(i2c_bus_t* bus);
+static void finish_transaction(i2c_bus_t* bus, app_err_t result);
+static void reset_bus(i2c_bus_t* bus, app_err_t result);
+static void update_health(const queue_entry_t* entry, app_err_t result);
+static app_err_t transfer_sync(i2c_transaction_t* transaction);
+static void sync_callback(app_err_t result, void* context);
+
+#if I2C_TRACE_ENABLED
+static void trace_transfer(i2c_bus_t* bus, app_err_t result);
+#define TRACE_TRANSFER(bus, result) trace_transfer((bus), (result))
+#else
+#define TRACE_TRANSFER(bus, result)
+#endif
+
+/**
+ * @brief adds a transaction to the queue of the bus of its device
+ *
+ * If the bus is free the transaction starts right away, otherwise it starts when the previous ones of its
+ * priority class on the same bus finish. In both cases this function returns without waiting for the bus.
+ * The priority class is high if the device was registered as high priority or I2C_FLAG_HIGH_PRIORITY is set.
+ *
+ * @param transaction: transaction to be performed, it is copied so it can live in the stack
+ *
+ * @return
+ * - APP_OK: if the transaction is queued
+ * - APP_ERR_INVALID_ARG: if transaction is NULL or it has nothing to transfer
+ * - I2C_ERR_QUEUE_FULL: if there are I2C_QUEUE_LENGTH transactions of the same priority pending
+ */
+app_err_t I2C_submit(const i2c_transaction_t* transaction) {
+	if (!is_valid_transaction(transaction)) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	i2c_device_t* device = find_device(transaction->address);
+	i2c_bus_t* bus = get_device_bus(transaction->address);
+	bool high_priority = (transaction->flags & I2C_FLAG_HIGH_PRIORITY) || (device != NULL && device->priority == I2C_PRIORITY_HIGH);
+	i2c_queue_t* queue = &bus->queues[high_priority ? I2C_PRIORITY_HIGH : I2C_PRIORITY_LOW];
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (queue->count >= I2C_QUEUE_LENGTH) {
+		__set_PRIMASK(primask);
+		return I2C_ERR_QUEUE_FULL;
+	}
+
+	queue_entry_t* entry = &queue->entries[(queue->head + queue->count) % I2C_QUEUE_LENGTH];
+	entry->transaction = *transaction;
+	entry->tx_done = 0;
+	entry->segment = 0;
+	entry->submit_cycles = cycles_now();
+	queue->count++;
+	start_next(bus);
+
+	__set_PRIMASK(primask);
+	return APP_OK;
+}
+
+/**
+ * @brief checks if there are transactions in progress or queued on any bus
+ *
+ * @return true if every queue is empty
+ */
+bool I2C_is_idle() {
+	for (uint8_t idx = 0; idx < I2C_BUS_COUNT; idx++) {
+		if (!is_bus_idle(&buses[idx])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief programs every bus again for its current speed, it must be called after the APB1 clock changed
+ *
+ * @note it must be called while every bus is idle
+ */
+void I2C_update_clock() {
+	for (uint8_t idx = 0; idx < I2C_BUS_COUNT; idx++) {
+		configure_bus_clock(&buses[idx]);
+	}
+}
+
+/**
+ * @brief registers a device so its transactions use its own bus speed
+ *
+ * The device starts at I2C_BUS_SPEED_STANDARD until I2C_probe_speed() finds a faster speed
+ *
+ * @param address: 7-bit address of the device, it must be unique among all the buses
+ * @param bus: bus the device is wired to
+ * @param max_speed: fastest speed supported by the device according to its datasheet
+ * @param priority: priority class of the transactions of the device
+ *
+ * @return
+ * - APP_OK: if the device is registered, or it was already registered
+ * - APP_ERR_INVALID_ARG: if bus is not a valid bus
+ * - I2C_ERR_TABLE_FULL: if there are already I2C_MAX_DEVICES devices
+ */
+app_err_t I2C_register_device(uint16_t address, i2c_bus_id_t bus, uint32_t max_speed, i2c_priority_t priority) {
+	if (bus >= I2C_BUS_COUNT) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	i2c_device_t* device = find_device(address);
+	if (device == NULL) {
+		if (amount_of_devices >= I2C_MAX_DEVICES) {
+			return I2C_ERR_TABLE_FULL;
+		}
+
+		device = &devices[amount_of_devices++];
+		device->address = address;
+	}
+
+	device->bus = bus;
+	device->max_speed = max_speed;
+	device->speed = I2C_BUS_SPEED_STANDARD;
+	device->priority = priority;
+	device->timeout_ms = I2C_DEFAULT_TIMEOUT_MS;
+	device->completed = 0;
+	device->nacks = 0;
+	device->errors = 0;
+	device->latency_sum_us = 0;
+	device->latency_max_us = 0;
+	return APP_OK;
+}
+
+/**
+ * @brief sets the margin added to the transfer time of the device before a transfer is considered stuck
+ *
+ * Devices that stretch the clock need a larger margin than I2C_DEFAULT_TIMEOUT_MS
+ *
+ * @param address: 7-bit address of a registered device
+ * @param timeout_ms: margin in milliseconds
+ *
+ * @return APP_OK, or APP_ERR_INVALID_ARG if the device is not registered
+ */
+app_err_t I2C_set_device_timeout(uint16_t address, uint32_t timeout_ms) {
+	i2c_device_t* device = find_device(address);
+	if (device == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	device->timeout_ms = timeout_ms;
+	return APP_OK;
+}
+
+/**
+ * @brief finds the fastest speed at which the device acknowledges its address reliably
+ *
+ * Each speed, starting from the device max_speed, is accepted only if PROBE_TRIALS address probes in a row
+ * are acknowledged. The found speed is stored in the device profile.
+ *
+ * @note it waits for the queues of the device bus to be empty and blocks that bus while probing
+ *
+ * @param address: 7-bit address of a registered device
+ * @param speed: where the found speed is stored, can be NULL
+ *
+ * @return
+ * - APP_OK: if the device answered at some speed
+ * - APP_ERR_INVALID_ARG: if the device is not registered
+ * - I2C_ERR_TIMEOUT: if the queue did not empty in time
+ * - I2C_ERR_BUS_STUCK: if a slave holds SDA low even after recovering the bus
+ * - I2C_ERR_NO_DEVICE: if the device did not answer at any speed
+ */
+app_err_t I2C_probe_speed(uint16_t address, uint32_t* speed) {
+	i2c_device_t* device = find_device(address);
+	if (device == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	i2c_bus_t* bus = &buses[device->bus];
+	if (!wait_idle(bus)) {
+		return I2C_ERR_TIMEOUT;
+	}
+
+	if (!wait_bus_free(bus) && !recover_bus(bus)) {
+		return I2C_ERR_BUS_STUCK;
+	}
+
+	uint8_t amount_of_speeds = sizeof(PROBE_SPEEDS) / sizeof(PROBE_SPEEDS[0]);
+	for (uint8_t idx = 0; idx < amount_of_speeds; idx++) {
+		if (PROBE_SPEEDS[idx] > device->max_speed) {
+			continue;
+		}
+
+		set_bus_speed(bus, PROBE_SPEEDS[idx]);
+		if (HAL_I2C_IsDeviceReady(bus->handle, address << 1, PROBE_TRIALS, PROBE_TIMEOUT) == HAL_OK) {
+			device->speed = PROBE_SPEEDS[idx];
+			if (speed != NULL) {
+				*speed = device->speed;
+			}
+
+			return APP_OK;
+		}
+	}
+
+	device->speed = I2C_BUS_SPEED_STANDARD;
+	return I2C_ERR_NO_DEVICE;
+}
+
+/**
+ * @brief returns the speed used for the device
+ *
+ * @return the speed found by the probe, or I2C_BUS_SPEED_STANDARD if the device is not registered
+ */
+uint32_t I2C_get_device_speed(uint16_t address) {
+	i2c_device_t* device = find_device(address);
+	return (device != NULL) ? device->speed : I2C_BUS_SPEED_STANDARD;
+}
+
+/**
+ * @brief returns the amount of registered devices
+ *
+ */
+uint8_t I2C_get_amount_of_devices() {
+	return amount_of_devices;
+}
+
+/**
+ * @brief copies the profile and the health counters of a registered device
+ *
+ * @param idx: index of the device, from 0 to I2C_get_amount_of_devices() - 1
+ * @param info: where the data is copied
+ *
+ * @return APP_OK, or APP_ERR_INVALID_ARG if idx is out of range or info is NULL
+ */
+app_err_t I2C_get_device_info(uint8_t idx, i2c_device_info_t* info) {
+	if (idx >= amount_of_devices || info == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	i2c_device_t* device = &devices[idx];
+	info->address = device->address;
+	info->bus = device->bus;
+	info->speed = device->speed;
+	info->completed = device->completed;
+	info->nacks = device->nacks;
+	info->errors = device->errors;
+	info->max_latency_us = device->latency_max_us;
+
+	uint32_t finished = device->completed + device->nacks + device->errors;
+	info->avg_latency_us = (finished > 0) ? device->latency_sum_us / finished : 0;
+
+	__set_PRIMASK(primask);
+	return APP_OK;
+}
+
+/**
+ * @brief looks for every device on the bus
+ *
+ * Each address from I2C_SCAN_FIRST_ADDRESS to I2C_SCAN_LAST_ADDRESS gets a single address-only probe at
+ * I2C_BUS_SPEED_STANDARD, which every device supports, so the whole bus is scanned in about 15 ms.
+ * The result is kept until the next scan and can be queried with I2C_is_found().
+ *
+ * @note it waits for the queues of the bus to be empty and blocks the bus while scanning
+ *
+ * @param bus: bus to be scanned
+ * @param amount_found: where the amount of devices found is stored, can be NULL
+ *
+ * @return
+ * - APP_OK: if the bus was scanned, even if no device answered
+ * - APP_ERR_INVALID_ARG: if bus is not a valid bus
+ * - I2C_ERR_TIMEOUT: if the queues did not empty in time
+ * - I2C_ERR_BUS_STUCK: if a slave holds SDA low even after recovering the bus
+ */
+app_err_t I2C_scan(i2c_bus_id_t bus_id, uint8_t* amount_found) {
+	if (bus_id >= I2C_BUS_COUNT) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	i2c_bus_t* bus = &buses[bus_id];
+	if (!wait_idle(bus)) {
+		return I2C_ERR_TIMEOUT;
+	}
+
+	if (!wait_bus_free(bus) && !recover_bus(bus)) {
+		return I2C_ERR_BUS_STUCK;
+	}
+
+	set_bus_speed(bus, I2C_BUS_SPEED_STANDARD);
+
+	uint8_t amount = 0;
+	for (uint16_t address = I2C_SCAN_FIRST_ADDRESS; address <= I2C_SCAN_LAST_ADDRESS; address++) {
+		uint8_t mask = 1 << (address % 8);
+		if (HAL_I2C_IsDeviceReady(bus->handle, address << 1, SCAN_TRIALS, SCAN_TIMEOUT) == HAL_OK) {
+			bus->found[address / 8] |= mask;
+			amount++;
+		} else {
+			bus->found[address / 8] &= ~mask;
+		}
+	}
+
+	if (amount_found != NULL) {
+		*amount_found = amount;
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief checks if the device answered the last scan of the bus
+ *
+ * @return true if it answered, false if it did not or the bus was never scanned
+ */
+bool I2C_is_found(i2c_bus_id_t bus_id, uint16_t address) {
+	if (bus_id >= I2C_BUS_COUNT || address > I2C_SCAN_LAST_ADDRESS) {
+		return false;
+	}
+
+	return buses[bus_id].found[address / 8] & (1 << (address % 8));
+}
+
+/**
+ * @brief returns the name of the peripheral of the bus
+ *
+ * @return the name, or NULL if bus is not a valid bus
+ */
+uint8_t* I2C_get_bus_name(i2c_bus_id_t bus_id) {
+	return (bus_id < I2C_BUS_COUNT) ? buses[bus_id].name : NULL;
+}
+
+/**
+ * @brief checks that the transfers using the buses did not run out of time and recovers the stuck buses
+ *
+ * A transfer that exceeds its timeout is failed with I2C_ERR_TIMEOUT, and its bus is recovered before the
+ * queue goes on with the next transaction. Only the check is done with interrupts disabled, the recovery
+ * runs with them enabled. It must be called periodically.
+ *
+ * @note it must not be called from interrupt context
+ */
+void I2C_process() {
+	for (uint8_t idx = 0; idx < I2C_BUS_COUNT; idx++) {
+		i2c_bus_t* bus = &buses[idx];
 
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+
+		if (bus->phase != PHASE_IDLE && HAL_GetTick() - bus->transfer_start > bus->transfer_timeout) {
+			TRACE_TRANSFER(bus, I2C_ERR_TIMEOUT);
+
+			// A late completion finds the bus idle and is ignored
+			bus->recovery_pending = true;
+			finish_transaction(bus, I2C_ERR_TIMEOUT);
+		}
+
+		__set_PRIMASK(primask);
+
+		if (bus->recovery_pending) {
+			recover_pending_bus(bus);
+		}
+	}
+}
+
+/**
+ * @brief writes the message to the device and waits for the transfer to finish
+ *
+ * @note it must not be called from interrupt context
+ *
+ * @return APP_OK if the message is sent correctly, otherwise the corresponding error
+ */
 app_err_t I2C_master_transmit(uint16_t device_address, uint8_t* message, uint16_t size) {
-	return (HAL_I2C_Master_Transmit(&hi2c1, device_address << 1, message, size, TIMEOUT) == HAL_OK) ? APP_OK : I2C_ERR_TX;
+	i2c_transaction_t transaction = {
+			.address = device_address,
+			.tx_buffer = message,
+			.tx_size = size,
+	};
+
+	return transfer_sync(&transaction);
 }
 
+/**
+ * @brief reads size bytes from the device and waits for the transfer to finish
+ *
+ * @note it must not be called from interrupt context
+ *
+ * @return APP_OK if the data is received correctly, otherwise the corresponding error
+ */
 app_err_t I2C_master_receive(uint16_t device_address, uint8_t* buffer, uint16_t size) {
-	return (HAL_I2C_Master_Receive(&hi2c1, device_address << 1, buffer, size, TIMEOUT) == HAL_OK) ? APP_OK : I2C_ERR_RX;
+	i2c_transaction_t transaction = {
+			.address = device_address,
+			.rx_buffer = buffer,
+			.rx_size = size,
+	};
+
+	return transfer_sync(&transaction);
+}
+
+/**
+ * @brief writes the message and reads size bytes from the device in a single transaction
+ *
+ * The read starts with a repeated START right after the write, which is how registers and status bytes are
+ * read atomically
+ *
+ * @note it must not be called from interrupt context
+ *
+ * @return APP_OK if the transaction finishes correctly, otherwise the corresponding error
+ */
+app_err_t I2C_write_read(uint16_t device_address, uint8_t* message, uint16_t message_size, uint8_t* buffer, uint16_t size) {
+	if (message_size == 0 || size == 0) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	i2c_transaction_t transaction = {
+			.address = device_address,
+			.tx_buffer = message,
+			.tx_size = message_size,
+			.rx_buffer = buffer,
+			.rx_size = size,
+	};
+
+	return transfer_sync(&transaction);
+}
+
+/**
+ * @brief writes the segments to the device as a single write and waits for it to finish
+ *
+ * It avoids copying a header and a payload into one buffer, the bus is held between segments
+ *
+ * @note it must not be called from interrupt context
+ *
+ * @param segments: up to I2C_MAX_SEGMENTS segments, none of them can be empty
+ *
+ * @return APP_OK if the message is sent correctly, otherwise the corresponding error
+ */
+app_err_t I2C_write_vectored(uint16_t device_address, const i2c_segment_t* segments, uint8_t amount_of_segments) {
+	i2c_transaction_t transaction = {
+			.address = device_address,
+			.tx_segments = segments,
+			.tx_segment_count = amount_of_segments,
+	};
+
+	return transfer_sync(&transaction);
+}
+
+/**
+ * @brief starts the next transfer if the bus is free
+ *
+ * The high priority queue is always served first, so a high priority transaction waits at most for the
+ * transfer in progress, which is a single chunk if it belongs to a chunked write
+ *
+ * @note it must be called with interrupts disabled or from the I2C interrupts
+ */
+void start_next(i2c_bus_t* bus) {
+	// A bus waiting to be recovered is restarted by recover_pending_bus()
+	if (bus->phase != PHASE_IDLE || bus->recovery_pending) {
+		return;
+	}
+
+	bus->active_queue = get_next_queue(bus);
+	if (bus->active_queue == NULL) {
+		return;
+	}
+
+	start_phase(bus, &bus->active_queue->entries[bus->active_queue->head]);
+}
+
+/**
+ * @brief returns the queue whose head goes next, the high priority one first
+ *
+ * @return the queue, or NULL if both are empty
+ */
+i2c_queue_t* get_next_queue(i2c_bus_t* bus) {
+	if (bus->queues[I2C_PRIORITY_HIGH].count > 0) {
+		return &bus->queues[I2C_PRIORITY_HIGH];
+	}
+
+	if (bus->queues[I2C_PRIORITY_LOW].count > 0) {
+		return &bus->queues[I2C_PRIORITY_LOW];
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief starts the next write chunk of the transaction, or the read phase if everything is written
+ *
+ */
+void start_phase(i2c_bus_t* bus, queue_entry_t* entry) {
+	i2c_transaction_t* transaction = &entry->transaction;
+	i2c_device_t* device = find_device(transaction->address);
+	uint16_t address = transaction->address << 1;
+	uint8_t amount_of_segments = count_tx_segments(transaction);
+
+	// The bus is retimed only between transfers, never between the phases of one
+	if (bus->phase == PHASE_IDLE) {
+		// A slave holding SDA low keeps the bus busy. This may run in interrupt context, so the transaction
+		// stays at the head of its queue and I2C_process() recovers the bus before starting it.
+		if (!wait_bus_free(bus)) {
+			bus->recovery_pending = true;
+			bus->active_queue = NULL;
+			return;
+		}
+
+		set_bus_speed(bus, (device != NULL) ? device->speed : I2C_BUS_SPEED_STANDARD);
+	}
+
+	// Each chunk is an independent transfer with its own START and STOP
+	if (is_chunked(transaction)) {
+		uint16_t remaining = transaction->tx_size - entry->tx_done;
+		uint16_t max_size = max_chunk_size(bus->handle->Init.ClockSpeed);
+		uint16_t size = (remaining > max_size) ? max_size : remaining;
+
+		bus->phase = PHASE_TX;
+		bus->chunk_size = size;
+		start_timeout(bus, device, size);
+		if (HAL_I2C_Master_Transmit_IT(bus->handle, address, transaction->tx_buffer + entry->tx_done, size) != HAL_OK) {
+			TRACE_TRANSFER(bus, I2C_ERR_TX);
+			finish_transaction(bus, I2C_ERR_TX);
+		}
+
+		return;
+	}
+
+	// Only the last frame of the transaction generates a STOP, the read after a write gets a repeated START
+	if (entry->segment < amount_of_segments) {
+		i2c_segment_t segment = get_tx_segment(transaction, entry->segment);
+		bool first = entry->segment == 0;
+		bool last = (entry->segment == amount_of_segments - 1) && transaction->rx_size == 0;
+		uint32_t options = first ? (last ? I2C_FIRST_AND_LAST_FRAME : I2C_FIRST_FRAME) : (last ? I2C_LAST_FRAME : I2C_NEXT_FRAME);
+
+		bus->phase = PHASE_TX;
+		start_timeout(bus, device, segment.size);
+		if (HAL_I2C_Master_Seq_Transmit_IT(bus->handle, address, segment.buffer, segment.size, options) != HAL_OK) {
+			TRACE_TRANSFER(bus, I2C_ERR_TX);
+			finish_transaction(bus, I2C_ERR_TX);
+		}
+
+		return;
+	}
+
+	uint32_t options = (amount_of_segments > 0) ? I2C_LAST_FRAME : I2C_FIRST_AND_LAST_FRAME;
+
+	bus->phase = PHASE_RX;
+	start_timeout(bus, device, transaction->rx_size);
+	if (HAL_I2C_Master_Seq_Receive_IT(bus->handle, address, transaction->rx_buffer, transaction->rx_size, options) != HAL_OK) {
+		TRACE_TRANSFER(bus, I2C_ERR_RX);
+		finish_transaction(bus, I2C_ERR_RX);
+	}
+}
+
+/**
+ * @brief checks that the transaction transfers something and that its segments are usable
+ *
+ */
+bool is_valid_transaction(const i2c_transaction_t* transaction) {
+	if (transaction == NULL) {
+		return false;
+	}
+
+	if (transaction->tx_segments != NULL) {
+		if (transaction->tx_segment_count == 0 || transaction->tx_segment_count > I2C_MAX_SEGMENTS) {
+			return false;
+		}
+
+		for (uint8_t idx = 0; idx < transaction->tx_segment_count; idx++) {
+			if (transaction->tx_segments[idx].buffer == NULL || transaction->tx_segments[idx].size == 0) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	return transaction->tx_size > 0 || transaction->rx_size > 0;
+}
+
+/**
+ * @brief tells if the transaction is a write that can be split into chunks
+ *
+ */
+bool is_chunked(const i2c_transaction_t* transaction) {
+	return (transaction->flags & I2C_FLAG_CHUNKED) && transaction->tx_segments == NULL && transaction->rx_size == 0;
+}
+
+/**
+ * @brief returns the amount of segments of the write phase, a plain write is a single segment
+ *
+ */
+uint8_t count_tx_segments(const i2c_transaction_t* transaction) {
+	if (transaction->tx_segments != NULL) {
+		return transaction->tx_segment_count;
+	}
+
+	return (transaction->tx_size > 0) ? 1 : 0;
+}
+
+/**
+ * @brief returns the given segment of the write phase
+ *
+ */
+i2c_segment_t get_tx_segment(const i2c_transaction_t* transaction, uint8_t idx) {
+	if (transaction->tx_segments != NULL) {
+		return transaction->tx_segments[idx];
+	}
+
+	i2c_segment_t segment = {
+			.buffer = transaction->tx_buffer,
+			.size = transaction->tx_size,
+	};
+
+	return segment;
+}
+
+/**
+ * @brief computes how many bytes can be sent in I2C_MAX_JITTER_US at the given speed
+ *
+ * Every chunk sends the address byte before its data, and its START and STOP on top
+ *
+ * @return the size of a chunk, at least 1
+ */
+uint16_t max_chunk_size(uint32_t speed) {
+	uint32_t clocks = (I2C_MAX_JITTER_US * (speed / 1000)) / 1000;
+	if (clocks < CHUNK_FRAMING_CLOCKS + 2 * CLOCKS_PER_BYTE) {
+		return 1;
+	}
+
+	return (clocks - CHUNK_FRAMING_CLOCKS) / CLOCKS_PER_BYTE - 1;
+}
+
+/**
+ * @brief arms the timeout of a transfer of size bytes at the current bus speed and records its start
+ *
+ * The timeout is the time the bytes and the address need on the bus (9 clocks each), rounded up,
+ * plus the margin of the device and one tick for the granularity of HAL_GetTick
+ *
+ */
+void start_timeout(i2c_bus_t* bus, i2c_device_t* device, uint16_t size) {
+	uint32_t speed = bus->handle->Init.ClockSpeed;
+	uint32_t transfer_ms = ((uint32_t)(size + 1) * 9 * 1000 + speed - 1) / speed;
+
+	bus->transfer_start = HAL_GetTick();
+	bus->transfer_size = size;
+#if I2C_TRACE_ENABLED
+	bus->transfer_cycles = cycles_now();
+#endif
+	bus->transfer_timeout = transfer_ms + ((device != NULL) ? device->timeout_ms : I2C_DEFAULT_TIMEOUT_MS) + 1;
+}
+
+/**
+ * @brief frees a bus held by a slave and re-initializes the peripheral
+ *
+ * SCL is pulsed through GPIO until the slave releases SDA (at most RECOVERY_PULSES times), then a STOP
+ * condition is generated so every slave goes back to idle. HAL_I2C_Init restores the pins and resets the
+ * peripheral, which also clears a BUSY flag left by a glitch.
+ *
+ * @return true if SDA is released, false if it is still held low
+ */
+bool recover_bus(i2c_bus_t* bus) {
+	uint32_t half_period = cycles_from_ns(RECOVERY_HALF_PERIOD_NS);
+
+	HAL_I2C_DeInit(bus->handle);
+
+	GPIO_InitTypeDef gpio_init = {
+			.Mode = GPIO_MODE_OUTPUT_OD,
+			.Pull = GPIO_NOPULL,
+			.Speed = GPIO_SPEED_FREQ_LOW,
+	};
+
+	// SCL and SDA may be on different ports
+	HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_SET);
+	HAL_GPIO_WritePin(bus->sda_port, bus->sda_pin, GPIO_PIN_SET);
+	gpio_init.Pin = bus->scl_pin;
+	HAL_GPIO_Init(bus->scl_port, &gpio_init);
+	gpio_init.Pin = bus->sda_pin;
+	HAL_GPIO_Init(bus->sda_port, &gpio_init);
+	cycles_delay(half_period);
+
+	for (uint8_t pulse = 0; pulse < RECOVERY_PULSES; pulse++) {
+		if (HAL_GPIO_ReadPin(bus->sda_port, bus->sda_pin) == GPIO_PIN_SET) {
+			break;
+		}
+
+		HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_RESET);
+		cycles_delay(half_period);
+		HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_SET);
+		cycles_delay(half_period);
+	}
+
+	// STOP: SDA rises while SCL is high
+	HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_RESET);
+	cycles_delay(half_period);
+	HAL_GPIO_WritePin(bus->sda_port, bus->sda_pin, GPIO_PIN_RESET);
+	cycles_delay(half_period);
+	HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_SET);
+	cycles_delay(half_period);
+	HAL_GPIO_WritePin(bus->sda_port, bus->sda_pin, GPIO_PIN_SET);
+	cycles_delay(half_period);
+
+	bool released = HAL_GPIO_ReadPin(bus->sda_port, bus->sda_pin) == GPIO_PIN_SET;
+
+	HAL_I2C_Init(bus->handle);
+	return released;
+}
+
+/**
+ * @brief recovers a bus marked with recovery_pending and starts its next transaction
+ *
+ * Nothing uses the bus while recovery_pending is set, so the recovery runs with interrupts enabled.
+ * If a slave still holds SDA low, the next transaction fails with I2C_ERR_BUS_STUCK and the recovery is
+ * tried again before the one after it.
+ *
+ * @note it must not be called from interrupt context
+ */
+void recover_pending_bus(i2c_bus_t* bus) {
+	bool released = recover_bus(bus);
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	bus->recovery_pending = false;
+	if (!released) {
+		bus->active_queue = get_next_queue(bus);
+		if (bus->active_queue != NULL) {
+			bus->recovery_pending = true;
+			finish_transaction(bus, I2C_ERR_BUS_STUCK);
+			bus->recovery_pending = get_next_queue(bus) != NULL;
+		}
+	}
+
+	start_next(bus);
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief looks for the profile of the device
+ *
+ * @return the profile, or NULL if the device is not registered
+ */
+i2c_device_t* find_device(uint16_t address) {
+	for (uint8_t idx = 0; idx < amount_of_devices; idx++) {
+		if (devices[idx].address == address) {
+			return &devices[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief returns the bus of the device
+ *
+ * @return the bus the device was registered on, or I2C_BUS_1 if the device is not registered
+ */
+i2c_bus_t* get_device_bus(uint16_t address) {
+	i2c_device_t* device = find_device(address);
+	return &buses[(device != NULL) ? device->bus : I2C_BUS_1];
+}
+
+/**
+ * @brief looks for the bus that uses the given HAL handle
+ *
+ * @return the bus, or NULL if the handle is not managed by the core
+ */
+i2c_bus_t* find_bus(I2C_HandleTypeDef* handle) {
+	for (uint8_t idx = 0; idx < I2C_BUS_COUNT; idx++) {
+		if (buses[idx].handle == handle) {
+			return &buses[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief checks if the bus has transactions in progress or queued, or is waiting to be recovered
+ *
+ * @return true if both queues of the bus are empty and it needs no recovery
+ */
+bool is_bus_idle(i2c_bus_t* bus) {
+	return bus->queues[I2C_PRIORITY_HIGH].count == 0 && bus->queues[I2C_PRIORITY_LOW].count == 0
+			&& !bus->recovery_pending;
+}
+
+/**
+ * @brief waits for the STOP of the previous transfer to release the bus
+ *
+ * BUSY is cleared a few microseconds after the STOP, so a transfer started right after another one can find
+ * it still set. The wait lasts BUSY_WAIT_SCL_PERIODS periods of SCL at the current speed, short enough for
+ * interrupt context.
+ *
+ * @return true if the bus is free, false if it is still busy and has to be recovered
+ */
+bool wait_bus_free(i2c_bus_t* bus) {
+	uint32_t timeout = cycles_from_ns(BUSY_WAIT_SCL_PERIODS * (1000000000 / bus->handle->Init.ClockSpeed));
+	uint32_t start = cycles_now();
+
+	while (__HAL_I2C_GET_FLAG(bus->handle, I2C_FLAG_BUSY)) {
+		if (cycles_now() - start > timeout) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief reprograms the clock registers of the bus for the given speed
+ *
+ * Only the clock registers change, so the peripheral is not re-initialized and the pins are not touched
+ *
+ * @note it must be called while the bus is idle
+ */
+void set_bus_speed(i2c_bus_t* bus, uint32_t speed) {
+	if (bus->handle->Init.ClockSpeed == speed) {
+		return;
+	}
+
+	bus->handle->Init.ClockSpeed = speed;
+	configure_bus_clock(bus);
+}
+
+/**
+ * @brief reprograms the clock registers of the bus for its speed from the current APB1 clock
+ *
+ * The frequency field of CR2 follows APB1, CCR and TRISE follow both APB1 and the speed
+ *
+ */
+void configure_bus_clock(i2c_bus_t* bus) {
+	uint32_t speed = bus->handle->Init.ClockSpeed;
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	uint32_t freq_range = I2C_FREQRANGE(pclk1);
+
+	__HAL_I2C_DISABLE(bus->handle);
+	MODIFY_REG(bus->handle->Instance->CR2, I2C_CR2_FREQ, freq_range);
+	MODIFY_REG(bus->handle->Instance->TRISE, I2C_TRISE_TRISE, I2C_RISE_TIME(freq_range, speed));
+	MODIFY_REG(bus->handle->Instance->CCR, (I2C_CCR_FS | I2C_CCR_DUTY | I2C_CCR_CCR), I2C_SPEED(pclk1, speed, bus->handle->Init.DutyCycle));
+	__HAL_I2C_ENABLE(bus->handle);
+}
+
+/**
+ * @brief waits for the queues of the bus to be empty
+ *
+ * @return true if the queues are empty, false if they did not empty in TIMEOUT ms
+ */
+bool wait_idle(i2c_bus_t* bus) {
+	uint32_t start = HAL_GetTick();
+	while (!is_bus_idle(bus)) {
+		I2C_process();
+		if (HAL_GetTick() - start > TIMEOUT) {
+			return false;
+		}
+
+		// The end of the transfer or the next tick wakes the core up
+		__WFI();
+	}
+
+	return true;
+}
+
+/**
+ * @brief removes the transaction using the bus from its queue, notifies the result and starts the next one
+ *
+ */
+void finish_transaction(i2c_bus_t* bus, app_err_t result) {
+	i2c_queue_t* queue = bus->active_queue;
+	i2c_transaction_t finished = queue->entries[queue->head].transaction;
+
+	update_health(&queue->entries[queue->head], result);
+	if (result != APP_OK) {
+		EVTRACE(EVTRACE_I2C_ERROR, result);
+	}
+
+	queue->head = (queue->head + 1) % I2C_QUEUE_LENGTH;
+	queue->count--;
+	bus->active_queue = NULL;
+	bus->phase = PHASE_IDLE;
+
+	if (finished.callback != NULL) {
+		finished.callback(result, finished.context);
+	}
+
+	start_next(bus);
+}
+
+/**
+ * @brief updates the health counters of the device of the finished transaction
+ *
+ */
+void update_health(const queue_entry_t* entry, app_err_t result) {
+	i2c_device_t* device = find_device(entry->transaction.address);
+	if (device == NULL) {
+		return;
+	}
+
+	if (result == APP_OK) {
+		device->completed++;
+	} else if (result == I2C_ERR_NACK) {
+		device->nacks++;
+	} else {
+		device->errors++;
+	}
+
+	uint32_t latency_us = cycles_to_us(cycles_now() - entry->submit_cycles);
+	device->latency_sum_us += latency_us;
+	if (latency_us > device->latency_max_us) {
+		device->latency_max_us = latency_us;
+	}
+}
+
+/**
+ * @brief fails every pending transaction of the bus with the given result and recovers it
+ *
+ * @note it must not be called from interrupt context
+ */
+void reset_bus(i2c_bus_t* bus, app_err_t result) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	EVTRACE(EVTRACE_I2C_BUS_RESET, result);
+
+	// The transfer in progress is abandoned, nothing else starts until the bus is recovered
+	bus->recovery_pending = true;
+
+	for (uint8_t priority = 0; priority < I2C_PRIORITY_COUNT; priority++) {
+		i2c_queue_t* queue = &bus->queues[priority];
+		while (queue->count > 0) {
+			i2c_transaction_t failed = queue->entries[queue->head].transaction;
+			update_health(&queue->entries[queue->head], result);
+			queue->head = (queue->head + 1) % I2C_QUEUE_LENGTH;
+			queue->count--;
+
+			if (failed.callback != NULL) {
+				failed.callback(result, failed.context);
+			}
+		}
+	}
+
+	bus->active_queue = NULL;
+	bus->phase = PHASE_IDLE;
+	__set_PRIMASK(primask);
+
+	recover_pending_bus(bus);
+}
+
+/**
+ * @brief queues the transaction and waits until it finishes
+ *
+ * A transfer that gets stuck is failed by I2C_process within its own timeout. As a last resort, if the
+ * transaction does not finish after TIMEOUT ms the bus is reset, so no callback can refer to this
+ * stack frame once the function returns.
+ *
+ * @return the result of the transaction, or I2C_ERR_TIMEOUT
+ */
+app_err_t transfer_sync(i2c_transaction_t* transaction) {
+	sync_status_t status = {
+			.done = false,
+			.result = APP_OK,
+	};
+
+	transaction->callback = sync_callback;
+	transaction->context = &status;
+
+	uint32_t start = HAL_GetTick();
+	app_err_t err;
+	while ((err = I2C_submit(transaction)) == I2C_ERR_QUEUE_FULL) {
+		if (HAL_GetTick() - start > TIMEOUT) {
+			return I2C_ERR_TIMEOUT;
+		}
+	}
+
+	if (err != APP_OK) {
+		return err;
+	}
+
+	while (!status.done) {
+		I2C_process();
+		if (HAL_GetTick() - start > TIMEOUT) {
+			reset_bus(get_device_bus(transaction->address), I2C_ERR_TIMEOUT);
+			return I2C_ERR_TIMEOUT;
+		}
+
+		// The end of the transfer or the next tick wakes the core up
+		__WFI();
+	}
+
+	return status.result;
+}
+
+/**
+ * @brief marks the synchronous transfer as done
+ *
+ */
+void sync_callback(app_err_t result, void* context) {
+	sync_status_t* status = (sync_status_t*)context;
+	status->result = result;
+	status->done = true;
+}
+
+/**
+ * @brief HAL callback, a write chunk or a write segment finished
+ *
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c) {
+	i2c_bus_t* bus = find_bus(hi2c);
+	if (bus == NULL || bus->phase != PHASE_TX) {
+		return;
+	}
+
+	TRACE_TRANSFER(bus, APP_OK);
+
+	queue_entry_t* entry = &bus->active_queue->entries[bus->active_queue->head];
+	if (is_chunked(&entry->transaction)) {
+		entry->tx_done += bus->chunk_size;
+
+		// Between chunks the bus is released, so a high priority transaction can go first
+		if (entry->tx_done < entry->transaction.tx_size) {
+			bus->phase = PHASE_IDLE;
+			bus->active_queue = NULL;
+			start_next(bus);
+			return;
+		}
+
+		finish_transaction(bus, APP_OK);
+		return;
+	}
+
+	// The bus is kept (no STOP) while there are more segments or a read to do
+	entry->segment++;
+	if (entry->segment < count_tx_segments(&entry->transaction) || entry->transaction.rx_size > 0) {
+		start_phase(bus, entry);
+		return;
+	}
+
+	finish_transaction(bus, APP_OK);
+}
+
+/**
+ * @brief HAL callback, the read phase finished
+ *
+ */
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+	i2c_bus_t* bus = find_bus(hi2c);
+	if (bus == NULL || bus->phase != PHASE_RX) {
+		return;
+	}
+
+	TRACE_TRANSFER(bus, APP_OK);
+
+	finish_transaction(bus, APP_OK);
+}
+
+/**
+ * @brief HAL callback, the transfer failed (NACK, arbitration lost or bus error)
+ *
+ * A NACK is reported as I2C_ERR_NACK, so it can be told apart from bus failures. After a bus error or a lost
+ * arbitration the bus is recovered by I2C_process() before its next transfer.
+ *
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+	i2c_bus_t* bus = find_bus(hi2c);
+	if (bus == NULL || bus->phase == PHASE_IDLE) {
+		return;
+	}
+
+	app_err_t result = (bus->phase == PHASE_TX) ? I2C_ERR_TX : I2C_ERR_RX;
+	if (hi2c->ErrorCode & HAL_I2C_ERROR_AF) {
+		result = I2C_ERR_NACK;
+	}
+
+	TRACE_TRANSFER(bus, result);
+
+	// A bus error or a lost arbitration with a single master means a slave is out of sync with the bus
+	if (hi2c->ErrorCode & (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO)) {
+		bus->recovery_pending = true;
+	}
+
+	finish_transaction(bus, result);
+}
+
+#if I2C_TRACE_ENABLED
+/**
+ * @brief records the transfer using the bus in the trace
+ *
+ */
+void trace_transfer(i2c_bus_t* bus, app_err_t result) {
+	i2c_transaction_t* transaction = &bus->active_queue->entries[bus->active_queue->head].transaction;
+	i2c_trace_direction_t direction = (bus->phase == PHASE_RX) ? I2C_TRACE_READ : I2C_TRACE_WRITE;
+
+	i2c_trace_record(transaction->address, direction, bus->transfer_size, result, bus->transfer_cycles);
 }
+#endif
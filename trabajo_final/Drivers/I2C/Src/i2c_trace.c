@@ -0,0 +1,81 @@
+#include "i2c_trace.h"
+
+#if I2C_TRACE_ENABLED
+
+#include "cycles.h"
+#include <stddef.h>
+
+// Circular buffer of transfers, next is where the next record is written
+static i2c_trace_record_t records[I2C_TRACE_LENGTH];
+static uint8_t next = 0;
+static uint8_t amount_of_records = 0;
+
+/**
+ * @brief stores a finished transfer in the trace
+ *
+ * @note it is called from the I2C interrupts or with interrupts disabled
+ *
+ * @param address: 7-bit address of the device
+ * @param direction: direction of the transfer
+ * @param length: amount of bytes of the transfer
+ * @param result: APP_OK or the error of the transfer
+ * @param start: cycle counter when the transfer started
+ */
+void i2c_trace_record(uint16_t address, i2c_trace_direction_t direction, uint16_t length, app_err_t result, uint32_t start) {
+	i2c_trace_record_t* record = &records[next];
+	record->timestamp = start;
+	record->duration = cycles_now() - start;
+	record->address = address;
+	record->length = length;
+	record->direction = direction;
+	record->result = result;
+
+	next = (next + 1) % I2C_TRACE_LENGTH;
+	if (amount_of_records < I2C_TRACE_LENGTH) {
+		amount_of_records++;
+	}
+}
+
+/**
+ * @brief copies the latest traced transfers, from the oldest one
+ *
+ * The copy is made with interrupts disabled, so it is consistent even if transfers finish meanwhile
+ *
+ * @param buffer: where the transfers are copied
+ * @param size: amount of records that fit in buffer
+ *
+ * @return the amount of transfers copied
+ */
+uint8_t i2c_trace_snapshot(i2c_trace_record_t* buffer, uint8_t size) {
+	if (buffer == NULL) {
+		return 0;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint8_t amount = (amount_of_records < size) ? amount_of_records : size;
+	uint8_t first = (next + I2C_TRACE_LENGTH - amount) % I2C_TRACE_LENGTH;
+	for (uint8_t idx = 0; idx < amount; idx++) {
+		buffer[idx] = records[(first + idx) % I2C_TRACE_LENGTH];
+	}
+
+	__set_PRIMASK(primask);
+	return amount;
+}
+
+/**
+ * @brief discards every traced transfer
+ *
+ */
+void i2c_trace_clear() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	next = 0;
+	amount_of_records = 0;
+
+	__set_PRIMASK(primask);
+}
+
+#endif /* I2C_TRACE_ENABLED */
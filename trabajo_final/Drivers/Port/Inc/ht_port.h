@@ -5,9 +5,12 @@
 #include <stdint.h>
 #include "error.h"
 
+app_err_t ht_port_init();
 
 app_err_t write_command(uint8_t* cmd, uint16_t size);
 
 app_err_t read_data(uint8_t* sensor_data, uint16_t size);
 
+app_err_t write_read(uint8_t* cmd, uint16_t cmd_size, uint8_t* sensor_data, uint16_t size);
+
 #endif /* PORT_INC_HT_PORT_H_ */
@@ -5,8 +5,30 @@
 #include <stdint.h>
 #include "error.h"
 
+// Available backends, select one at build time with -DLCD_PORT_BACKEND=LCD_PORT_GPIO
+#define LCD_PORT_PCF8574 0 // I2C backpack, on the bus given by I2C_LCD_BUS
+#define LCD_PORT_GPIO 1    // HD44780 wired directly to GPIOC in 4-bit mode
+
+#ifndef LCD_PORT_BACKEND
+#define LCD_PORT_BACKEND LCD_PORT_PCF8574
+#endif
+
+/*
+ * Every byte given to lcd_write() uses the PCF8574 layout, whatever the backend is:
+ * bits 7-4: D7-D4, bit 3: backlight, bit 2: EN, bit 1: RW, bit 0: RS
+ */
+
+// Called when an asynchronous write finishes, possibly from interrupt context
+typedef void (*lcd_write_callback_t)(app_err_t result, void* context);
+
+app_err_t lcd_port_init();
+
+void lcd_port_update_clock();
+
 app_err_t lcd_write(uint8_t* data, uint16_t size);
 
+app_err_t lcd_write_async(uint8_t* data, uint16_t size, lcd_write_callback_t callback, void* context);
+
 app_err_t lcd_read_data(uint8_t* buffer, uint16_t size);
 
 #endif /* PORT_INC_LCD_PORT_H_ */
@@ -0,0 +1,58 @@
+#ifndef PORT_INC_PORT_H_
+#define PORT_INC_PORT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+#include "i2c_core.h"
+
+// Called when an asynchronous write finishes, possibly from interrupt context
+typedef void (*port_callback_t)(app_err_t result, void* context);
+
+/*
+ * Operations the drivers need from the platform. Every device is identified by its 7-bit address, the bus
+ * and priority given to attach() are only used by implementations with several buses or queues.
+ * Times are in milliseconds, except for the _us operations, which wait the exact timings of the datasheets.
+ */
+typedef struct {
+	app_err_t (*attach)(uint16_t address, i2c_bus_id_t bus, i2c_priority_t priority);
+	app_err_t (*scan)(i2c_bus_id_t bus);
+	bool (*is_found)(i2c_bus_id_t bus, uint16_t address);
+	app_err_t (*write)(uint16_t address, uint8_t* data, uint16_t size);
+	app_err_t (*write_async)(uint16_t address, uint8_t* data, uint16_t size, port_callback_t callback, void* context);
+	app_err_t (*read)(uint16_t address, uint8_t* buffer, uint16_t size);
+	app_err_t (*write_read)(uint16_t address, uint8_t* cmd, uint16_t cmd_size, uint8_t* buffer, uint16_t size);
+	void (*delay)(uint32_t ms);
+	uint32_t (*now)();
+	void (*delay_us)(uint32_t us);
+	uint32_t (*now_us)();
+} port_ops_t;
+
+// Implementation on top of the HAL and the I2C core, used by the firmware
+extern const port_ops_t PORT_HAL_OPS;
+
+app_err_t port_init(const port_ops_t* ops);
+
+app_err_t port_attach(uint16_t address, i2c_bus_id_t bus, i2c_priority_t priority);
+
+app_err_t port_scan(i2c_bus_id_t bus);
+
+bool port_is_found(i2c_bus_id_t bus, uint16_t address);
+
+app_err_t port_write(uint16_t address, uint8_t* data, uint16_t size);
+
+app_err_t port_write_async(uint16_t address, uint8_t* data, uint16_t size, port_callback_t callback, void* context);
+
+app_err_t port_read(uint16_t address, uint8_t* buffer, uint16_t size);
+
+app_err_t port_write_read(uint16_t address, uint8_t* cmd, uint16_t cmd_size, uint8_t* buffer, uint16_t size);
+
+void port_delay(uint32_t ms);
+
+uint32_t port_now();
+
+void port_delay_us(uint32_t us);
+
+uint32_t port_now_us();
+
+#endif /* PORT_INC_PORT_H_ */
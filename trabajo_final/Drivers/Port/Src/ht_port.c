@@ -1,13 +1,25 @@
 #include "ht_port.h"
-#include "stm32f4xx_hal.h"
-#include "i2c_core.h"
+#include "port.h"
 
 static const uint16_t HT_SENSOR_ADDRESS = 0x38;
 
+/**
+ * @brief attaches the sensor to the port, on its bus and with high priority
+ *
+ * @return APP_OK if the sensor answers, otherwise the corresponding error
+ */
+app_err_t ht_port_init() {
+	return port_attach(HT_SENSOR_ADDRESS, I2C_HT_SENSOR_BUS, I2C_PRIORITY_HIGH);
+}
+
 app_err_t write_command(uint8_t* cmd, uint16_t size) {
-	return I2C_master_transmit(HT_SENSOR_ADDRESS, cmd, size);
+	return port_write(HT_SENSOR_ADDRESS, cmd, size);
 }
 
 app_err_t read_data(uint8_t* sensor_data, uint16_t size) {
-	return I2C_master_receive(HT_SENSOR_ADDRESS, sensor_data, size);
+	return port_read(HT_SENSOR_ADDRESS, sensor_data, size);
+}
+
+app_err_t write_read(uint8_t* cmd, uint16_t cmd_size, uint8_t* sensor_data, uint16_t size) {
+	return port_write_read(HT_SENSOR_ADDRESS, cmd, cmd_size, sensor_data, size);
 }
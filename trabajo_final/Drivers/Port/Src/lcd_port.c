@@ -1,14 +1,57 @@
 #include "lcd_port.h"
-#include "i2c_core.h"
 
-static const uint16_t LCD_ADDRESS = 0x27;
+#if LCD_PORT_BACKEND == LCD_PORT_PCF8574
+
+#include "port.h"
+
+// The PCF8574 backpack answers at 0x27 and the PCF8574A one at 0x3F, both with the address pins open
+static const uint16_t LCD_ADDRESSES[] = {0x27, 0x3F};
+
+static uint16_t lcd_address;
+
+/**
+ * @brief scans the bus for the backpack and attaches it to the port with low priority
+ *
+ * @return APP_OK if the backpack answers, I2C_ERR_NO_DEVICE if it is not on the bus, otherwise the corresponding error
+ */
+app_err_t lcd_port_init() {
+	app_err_t err = port_scan(I2C_LCD_BUS);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	lcd_address = 0;
+	uint8_t amount_of_addresses = sizeof(LCD_ADDRESSES) / sizeof(LCD_ADDRESSES[0]);
+	for (uint8_t idx = 0; idx < amount_of_addresses && lcd_address == 0; idx++) {
+		if (port_is_found(I2C_LCD_BUS, LCD_ADDRESSES[idx])) {
+			lcd_address = LCD_ADDRESSES[idx];
+		}
+	}
+
+	if (lcd_address == 0) {
+		return I2C_ERR_NO_DEVICE;
+	}
+
+	return port_attach(lcd_address, I2C_LCD_BUS, I2C_PRIORITY_LOW);
+}
+
+/**
+ * @brief nothing to recompute, the I2C core retimes the bus of the backpack
+ *
+ */
+void lcd_port_update_clock() {
+}
 
 app_err_t lcd_write(uint8_t* data, uint16_t size) {
-	return I2C_master_transmit(LCD_ADDRESS, data, size);
+	return port_write(lcd_address, data, size);
 }
 
-app_err_t lcd_read_data(uint8_t* buffer, uint16_t size) {
-	return I2C_master_receive(LCD_ADDRESS, buffer, size);
+app_err_t lcd_write_async(uint8_t* data, uint16_t size, lcd_write_callback_t callback, void* context) {
+	return port_write_async(lcd_address, data, size, callback, context);
 }
 
+app_err_t lcd_read_data(uint8_t* buffer, uint16_t size) {
+	return port_read(lcd_address, buffer, size);
+}
 
+#endif /* LCD_PORT_BACKEND == LCD_PORT_PCF8574 */
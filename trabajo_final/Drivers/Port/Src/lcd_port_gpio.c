@@ -0,0 +1,161 @@
+#include "lcd_port.h"
+
+#if LCD_PORT_BACKEND == LCD_PORT_GPIO
+
+#include "stm32f4xx_hal.h"
+#include "cycles.h"
+
+/*
+ * Wiring (RW is tied to GND, so the LCD can only be written):
+ * PC0-PC3: D4-D7, PC4: RS, PC5: EN
+ * Data and RS share the port so both are set with a single BSRR write.
+ */
+#define LCD_GPIO_PORT GPIOC
+#define LCD_DATA_SHIFT 0
+#define LCD_DATA_PINS (GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3)
+#define LCD_RS_PIN GPIO_PIN_4
+#define LCD_EN_PIN GPIO_PIN_5
+
+// Bits of the PCF8574 layout used by the driver
+#define PCF_DATA_MASK 0xF0
+#define PCF_EN_BIT 0x04
+#define PCF_RS_BIT 0x01
+
+// HD44780 timings: address setup, enable pulse width, enable cycle time and command execution time
+#define T_ADDRESS_SETUP_NS 60
+#define T_ENABLE_PULSE_NS 450
+#define T_ENABLE_CYCLE_NS 1000
+#define T_EXECUTION_NS 40000
+
+static uint32_t address_setup_cycles;
+static uint32_t enable_pulse_cycles;
+static uint32_t nibble_gap_cycles;
+static uint32_t execution_cycles;
+static bool enable_high = false;
+
+// The high nibble of a byte is latched and its low nibble comes next in the same write
+static bool high_nibble_latched = false;
+
+// Prototypes
+static void write_bus_byte(uint8_t data, bool last);
+
+/**
+ * @brief configures the LCD pins as outputs and computes the timings for the current core clock
+ *
+ * @return APP_OK
+ */
+app_err_t lcd_port_init() {
+	__HAL_RCC_GPIOC_CLK_ENABLE();
+
+	GPIO_InitTypeDef gpio_init = {
+			.Pin = LCD_DATA_PINS | LCD_RS_PIN | LCD_EN_PIN,
+			.Mode = GPIO_MODE_OUTPUT_PP,
+			.Pull = GPIO_NOPULL,
+			.Speed = GPIO_SPEED_FREQ_MEDIUM,
+	};
+
+	HAL_GPIO_WritePin(LCD_GPIO_PORT, gpio_init.Pin, GPIO_PIN_RESET);
+	HAL_GPIO_Init(LCD_GPIO_PORT, &gpio_init);
+
+	lcd_port_update_clock();
+	enable_high = false;
+
+	return APP_OK;
+}
+
+/**
+ * @brief recomputes the timings in cycles of the core clock, it must be called after the clock changes
+ *
+ */
+void lcd_port_update_clock() {
+	address_setup_cycles = cycles_from_ns(T_ADDRESS_SETUP_NS);
+	enable_pulse_cycles = cycles_from_ns(T_ENABLE_PULSE_NS);
+	nibble_gap_cycles = cycles_from_ns(T_ENABLE_CYCLE_NS - T_ENABLE_PULSE_NS);
+	execution_cycles = cycles_from_ns(T_EXECUTION_NS);
+}
+
+/**
+ * @brief drives the LCD pins with each of the given bytes
+ *
+ * The falling edges of EN in a write alternate between the high and the low nibble of each LCD byte. A write
+ * that ends after a single nibble, as the function sets of the initialization, gets the execution time too.
+ *
+ * @param data: bytes in the PCF8574 layout
+ * @param size: amount of bytes
+ *
+ * @return APP_OK, or APP_ERR_INVALID_ARG if data is NULL
+ */
+app_err_t lcd_write(uint8_t* data, uint16_t size) {
+	if (data == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	high_nibble_latched = false;
+	for (uint16_t idx = 0; idx < size; idx++) {
+		write_bus_byte(data[idx], idx == size - 1);
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief drives the LCD pins with each of the given bytes and then calls the callback
+ *
+ * @note the GPIO backend is fast enough to write the bytes right away
+ *
+ * @return the result of the write
+ */
+app_err_t lcd_write_async(uint8_t* data, uint16_t size, lcd_write_callback_t callback, void* context) {
+	app_err_t err = lcd_write(data, size);
+	if (err == APP_OK && callback != NULL) {
+		callback(err, context);
+	}
+
+	return err;
+}
+
+/**
+ * @brief reading is not supported because RW is tied to GND
+ *
+ * @return APP_ERR_INTERNAL
+ */
+app_err_t lcd_read_data(uint8_t* buffer, uint16_t size) {
+	return APP_ERR_INTERNAL;
+}
+
+/**
+ * @brief translates a PCF8574 byte into pin changes
+ *
+ * A rising EN latches nothing, the HD44780 reads the data on the falling edge, so the pulse width is waited
+ * before lowering EN. After it, the high nibble of a byte only needs the rest of the enable cycle, the
+ * instruction runs once the low nibble is latched and that one waits the execution time.
+ *
+ * @param last: it is the last byte of the write, so no low nibble follows
+ */
+void write_bus_byte(uint8_t data, bool last) {
+	bool new_enable = data & PCF_EN_BIT;
+
+	if (enable_high && !new_enable) {
+		cycles_delay(enable_pulse_cycles);
+		LCD_GPIO_PORT->BSRR = (uint32_t)LCD_EN_PIN << 16;
+		enable_high = false;
+
+		bool byte_done = high_nibble_latched || last;
+		high_nibble_latched = !byte_done;
+		cycles_delay(byte_done ? execution_cycles : nibble_gap_cycles);
+		return;
+	}
+
+	uint32_t data_bits = ((uint32_t)(data & PCF_DATA_MASK) >> 4) << LCD_DATA_SHIFT;
+	uint32_t set_bits = data_bits | ((data & PCF_RS_BIT) ? LCD_RS_PIN : 0);
+	uint32_t reset_bits = (LCD_DATA_PINS | LCD_RS_PIN) & ~set_bits;
+	LCD_GPIO_PORT->BSRR = set_bits | (reset_bits << 16);
+
+	if (new_enable && !enable_high) {
+		cycles_delay(address_setup_cycles);
+		LCD_GPIO_PORT->BSRR = LCD_EN_PIN;
+		enable_high = true;
+	}
+}
+
+#endif /* LCD_PORT_BACKEND == LCD_PORT_GPIO */
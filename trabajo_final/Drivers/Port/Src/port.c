@@ -0,0 +1,126 @@
+#include "port.h"
+#include <stddef.h>
+
+static const port_ops_t* port_ops = NULL;
+
+/**
+ * @brief selects the implementation used by the port layer
+ *
+ * It must be called before initializing any driver, the firmware uses PORT_HAL_OPS
+ *
+ * @param ops: implementation, every operation must be set
+ *
+ * @return APP_OK, or APP_ERR_INVALID_ARG if ops is NULL or an operation is missing
+ */
+app_err_t port_init(const port_ops_t* ops) {
+	if (ops == NULL || ops->attach == NULL || ops->scan == NULL || ops->is_found == NULL || ops->write == NULL
+			|| ops->write_async == NULL || ops->read == NULL || ops->write_read == NULL || ops->delay == NULL
+			|| ops->now == NULL || ops->delay_us == NULL || ops->now_us == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	port_ops = ops;
+	return APP_OK;
+}
+
+/**
+ * @brief makes the device known to the implementation, before any transfer with it
+ *
+ * @return APP_OK, APP_ERR_INTERNAL if port_init() was not called, otherwise the error of the implementation
+ */
+app_err_t port_attach(uint16_t address, i2c_bus_id_t bus, i2c_priority_t priority) {
+	return (port_ops != NULL) ? port_ops->attach(address, bus, priority) : APP_ERR_INTERNAL;
+}
+
+/**
+ * @brief looks for every device on the bus, the result is queried with port_is_found()
+ *
+ * @return APP_OK, APP_ERR_INTERNAL if port_init() was not called, otherwise the error of the implementation
+ */
+app_err_t port_scan(i2c_bus_id_t bus) {
+	return (port_ops != NULL) ? port_ops->scan(bus) : APP_ERR_INTERNAL;
+}
+
+/**
+ * @brief checks if the device answered the last scan of the bus
+ *
+ */
+bool port_is_found(i2c_bus_id_t bus, uint16_t address) {
+	return (port_ops != NULL) ? port_ops->is_found(bus, address) : false;
+}
+
+/**
+ * @brief writes the data to the device and waits until it is sent
+ *
+ * @return APP_OK, APP_ERR_INTERNAL if port_init() was not called, otherwise the error of the implementation
+ */
+app_err_t port_write(uint16_t address, uint8_t* data, uint16_t size) {
+	return (port_ops != NULL) ? port_ops->write(address, data, size) : APP_ERR_INTERNAL;
+}
+
+/**
+ * @brief starts writing the data to the device, callback is called with the result
+ *
+ * @note data must stay valid until callback is called, which may happen before this function returns
+ *
+ * @return APP_OK if the write started, APP_ERR_INTERNAL if port_init() was not called, otherwise the error of the
+ * implementation, in which case callback is not called
+ */
+app_err_t port_write_async(uint16_t address, uint8_t* data, uint16_t size, port_callback_t callback, void* context) {
+	return (port_ops != NULL) ? port_ops->write_async(address, data, size, callback, context) : APP_ERR_INTERNAL;
+}
+
+/**
+ * @brief reads from the device and waits until the data is received
+ *
+ * @return APP_OK, APP_ERR_INTERNAL if port_init() was not called, otherwise the error of the implementation
+ */
+app_err_t port_read(uint16_t address, uint8_t* buffer, uint16_t size) {
+	return (port_ops != NULL) ? port_ops->read(address, buffer, size) : APP_ERR_INTERNAL;
+}
+
+/**
+ * @brief writes cmd to the device and reads its answer without releasing the bus in between
+ *
+ * @return APP_OK, APP_ERR_INTERNAL if port_init() was not called, otherwise the error of the implementation
+ */
+app_err_t port_write_read(uint16_t address, uint8_t* cmd, uint16_t cmd_size, uint8_t* buffer, uint16_t size) {
+	return (port_ops != NULL) ? port_ops->write_read(address, cmd, cmd_size, buffer, size) : APP_ERR_INTERNAL;
+}
+
+/**
+ * @brief waits the given amount of milliseconds
+ *
+ */
+void port_delay(uint32_t ms) {
+	if (port_ops != NULL) {
+		port_ops->delay(ms);
+	}
+}
+
+/**
+ * @brief returns the milliseconds elapsed since start-up, 0 if port_init() was not called
+ *
+ */
+uint32_t port_now() {
+	return (port_ops != NULL) ? port_ops->now() : 0;
+}
+
+/**
+ * @brief waits the given amount of microseconds, never less
+ *
+ */
+void port_delay_us(uint32_t us) {
+	if (port_ops != NULL) {
+		port_ops->delay_us(us);
+	}
+}
+
+/**
+ * @brief returns the microseconds of a free-running counter, 0 if port_init() was not called
+ *
+ * @note it wraps around every 71 minutes, differences between two readings are correct across the wrap
+ */
+uint32_t port_now_us() {
+	return (port_ops != NULL) ? port_ops->now_us() : 0;
+}
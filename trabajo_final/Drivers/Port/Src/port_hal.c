@@ -0,0 +1,75 @@
+#include "port.h"
+#include "stm32f4xx_hal.h"
+#include "i2c_core.h"
+#include "timebase.h"
+#include <stddef.h>
+
+// Prototypes
+static app_err_t hal_attach(uint16_t address, i2c_bus_id_t bus, i2c_priority_t priority);
+static app_err_t hal_scan(i2c_bus_id_t bus);
+static app_err_t hal_write_async(uint16_t address, uint8_t* data, uint16_t size, port_callback_t callback, void* context);
+static void hal_delay(uint32_t ms);
+static uint32_t hal_now();
+static uint32_t hal_now_us();
+
+const port_ops_t PORT_HAL_OPS = {
+		.attach = hal_attach,
+		.scan = hal_scan,
+		.is_found = I2C_is_found,
+		.write = I2C_master_transmit,
+		.write_async = hal_write_async,
+		.read = I2C_master_receive,
+		.write_read = I2C_write_read,
+		.delay = hal_delay,
+		.now = hal_now,
+		.delay_us = timebase_delay_us,
+		.now_us = hal_now_us,
+};
+
+/**
+ * @brief registers the device in the I2C core and looks for the fastest speed it supports
+ *
+ * @return APP_OK if the device answers, otherwise the corresponding error
+ */
+app_err_t hal_attach(uint16_t address, i2c_bus_id_t bus, i2c_priority_t priority) {
+	app_err_t err = I2C_register_device(address, bus, I2C_BUS_SPEED_FAST, priority);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	return I2C_probe_speed(address, NULL);
+}
+
+app_err_t hal_scan(i2c_bus_id_t bus) {
+	return I2C_scan(bus, NULL);
+}
+
+/**
+ * @brief queues the write as a chunked transaction, so it never delays high priority devices by more
+ * than I2C_MAX_JITTER_US
+ *
+ */
+app_err_t hal_write_async(uint16_t address, uint8_t* data, uint16_t size, port_callback_t callback, void* context) {
+	i2c_transaction_t transaction = {
+			.address = address,
+			.tx_buffer = data,
+			.tx_size = size,
+			.flags = I2C_FLAG_CHUNKED,
+			.callback = callback,
+			.context = context,
+	};
+
+	return I2C_submit(&transaction);
+}
+
+void hal_delay(uint32_t ms) {
+	HAL_Delay(ms);
+}
+
+uint32_t hal_now() {
+	return HAL_GetTick();
+}
+
+uint32_t hal_now_us() {
+	return timebase_now_us();
+}
@@ -0,0 +1,143 @@
+#ifndef HOST_HAL_INC_STM32F4XX_H_
+#define HOST_HAL_INC_STM32F4XX_H_
+
+/*
+ * Stand-in of the CMSIS device header for the host build. It only has what the application layer uses:
+ * the DWT cycle counter, which follows the monotonic clock of the process at SystemCoreClock, the counter of
+ * the TIM2 timebase, which follows it in microseconds, and the PRIMASK intrinsics. PRIMASK only keeps the
+ * completions of the simulated I2C buses from being delivered, which is all the host build has of interrupts.
+ * The IWDG takes writes and never resets, and the reset flags of RCC tell a power-on reset.
+ * The I2C registers only hold the clock settings and the BUSY flag, and a GPIO pin reads back what was written
+ * unless it is in held_low, which stands for a slave holding the line.
+ */
+
+#include <stdint.h>
+
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+	volatile uint32_t SR;
+	volatile uint32_t DR;
+} USART_TypeDef;
+
+typedef struct {
+	volatile uint32_t CNT;
+} TIM_TypeDef;
+
+typedef struct {
+	volatile uint32_t KR;
+	volatile uint32_t PR;
+	volatile uint32_t RLR;
+	volatile uint32_t SR;
+} IWDG_TypeDef;
+
+typedef struct {
+	volatile uint32_t CSR;
+} RCC_TypeDef;
+
+typedef struct {
+	volatile uint32_t APB1FZ;
+} DBGMCU_TypeDef;
+
+typedef struct {
+	volatile uint32_t CR1;
+	volatile uint32_t CR2;
+	volatile uint32_t SR2;
+	volatile uint32_t CCR;
+	volatile uint32_t TRISE;
+} I2C_TypeDef;
+
+typedef struct {
+	volatile uint32_t IDR;
+	volatile uint32_t ODR;
+	// Only in the host build
+	volatile uint32_t held_low;
+} GPIO_TypeDef;
+
+typedef enum {
+	USART2_IRQn = 38,
+} IRQn_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define IWDG_SR_PVU (1UL << 0)
+#define IWDG_SR_RVU (1UL << 1)
+#define RCC_CSR_RMVF (1UL << 24)
+#define RCC_CSR_BORRSTF (1UL << 25)
+#define RCC_CSR_PINRSTF (1UL << 26)
+#define RCC_CSR_PORRSTF (1UL << 27)
+#define RCC_CSR_SFTRSTF (1UL << 28)
+#define RCC_CSR_IWDGRSTF (1UL << 29)
+#define RCC_CSR_WWDGRSTF (1UL << 30)
+#define RCC_CSR_LPWRRSTF (1UL << 31)
+#define DBGMCU_APB1_FZ_DBG_IWDG_STOP (1UL << 12)
+#define I2C_CR1_PE (1UL << 0)
+#define I2C_CR2_FREQ (0x3FUL << 0)
+#define I2C_SR2_BUSY (1UL << 1)
+#define I2C_CCR_CCR (0xFFFUL << 0)
+#define I2C_CCR_DUTY (1UL << 14)
+#define I2C_CCR_FS (1UL << 15)
+#define I2C_TRISE_TRISE (0x3FUL << 0)
+
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) ((REG) = (((REG) & (~(CLEARMASK))) | (SETMASK)))
+
+extern uint32_t SystemCoreClock;
+extern CoreDebug_Type host_core_debug;
+extern USART_TypeDef host_usart2;
+extern IWDG_TypeDef host_iwdg;
+extern RCC_TypeDef host_rcc;
+extern DBGMCU_TypeDef host_dbgmcu;
+extern I2C_TypeDef host_i2c1;
+extern I2C_TypeDef host_i2c3;
+extern GPIO_TypeDef host_gpioa;
+extern GPIO_TypeDef host_gpiob;
+extern GPIO_TypeDef host_gpioc;
+extern uint32_t host_primask;
+
+DWT_Type* host_dwt();
+
+TIM_TypeDef* host_tim2();
+
+// Only in the host build
+void host_set_core_clock(uint32_t hz);
+
+#define DWT (host_dwt())
+#define CoreDebug (&host_core_debug)
+#define USART2 (&host_usart2)
+#define TIM2 (host_tim2())
+#define IWDG (&host_iwdg)
+#define RCC (&host_rcc)
+#define DBGMCU (&host_dbgmcu)
+#define I2C1 (&host_i2c1)
+#define I2C3 (&host_i2c3)
+#define GPIOA (&host_gpioa)
+#define GPIOB (&host_gpiob)
+#define GPIOC (&host_gpioc)
+
+static inline uint32_t __get_PRIMASK() {
+	return host_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask) {
+	host_primask = primask;
+}
+
+static inline void __disable_irq() {
+	host_primask = 1;
+}
+
+static inline void __enable_irq() {
+	host_primask = 0;
+}
+
+// Delivers the completions of the simulated I2C buses, they are the interrupts that wake the core
+void __WFI();
+
+#endif /* HOST_HAL_INC_STM32F4XX_H_ */
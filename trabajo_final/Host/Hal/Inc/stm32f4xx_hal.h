@@ -0,0 +1,163 @@
+#ifndef HOST_HAL_INC_STM32F4XX_HAL_H_
+#define HOST_HAL_INC_STM32F4XX_HAL_H_
+
+/*
+ * Stand-in of the HAL for the host build. The tick follows the monotonic clock of the process and USART2
+ * is the pseudo-terminal opened by host_serial_open(), with the same blocking semantics as the HAL: a
+ * receive returns HAL_TIMEOUT if fewer bytes than requested arrive in time, keeping the ones that did.
+ * There are no interrupts, a reception started with HAL_UART_Receive_IT() is completed by
+ * host_uart_poll(), which calls HAL_UART_RxCpltCallback() as the USART2 interrupt would.
+ * I2C1 and I2C3 are the simulated buses of host_bus.h. A transfer started with one of the _IT() functions
+ * reaches the models right away, and its completion callback is called by host_i2c_poll() once PRIMASK is
+ * clear. The models take whole writes, so the frames of a write are joined and handed over when it ends.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+typedef enum {
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03,
+} HAL_StatusTypeDef;
+
+#define UART_WORDLENGTH_8B 0x00000000U
+#define UART_WORDLENGTH_9B 0x00001000U
+#define UART_STOPBITS_1 0x00000000U
+#define UART_PARITY_NONE 0x00000000U
+#define UART_PARITY_EVEN 0x00000400U
+#define UART_PARITY_ODD 0x00000600U
+#define UART_HWCONTROL_NONE 0x00000000U
+#define UART_MODE_TX_RX 0x0000000CU
+#define UART_OVERSAMPLING_16 0x00000000U
+
+typedef struct {
+	uint32_t BaudRate;
+	uint32_t WordLength;
+	uint32_t StopBits;
+	uint32_t Parity;
+	uint32_t Mode;
+	uint32_t HwFlowCtl;
+	uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef struct {
+	USART_TypeDef* Instance;
+	UART_InitTypeDef Init;
+	uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+#define HAL_I2C_ERROR_NONE 0x00000000U
+#define HAL_I2C_ERROR_BERR 0x00000001U
+#define HAL_I2C_ERROR_ARLO 0x00000002U
+#define HAL_I2C_ERROR_AF 0x00000004U
+
+#define I2C_DUTYCYCLE_2 0x00000000U
+#define I2C_DUTYCYCLE_16_9 I2C_CCR_DUTY
+
+#define I2C_FIRST_FRAME 0x00000001U
+#define I2C_NEXT_FRAME 0x00000004U
+#define I2C_FIRST_AND_LAST_FRAME 0x00000008U
+#define I2C_LAST_FRAME 0x00000020U
+
+// Only the flags of SR2 are kept
+#define I2C_FLAG_BUSY I2C_SR2_BUSY
+
+#define I2C_FREQRANGE(pclk) ((pclk) / 1000000U)
+#define I2C_RISE_TIME(freq_range, speed) (((speed) <= 100000U) ? ((freq_range) + 1U) : ((((freq_range) * 300U) / 1000U) + 1U))
+#define I2C_SPEED(pclk, speed, duty) (((speed) <= 100000U) ? ((pclk) / ((speed) * 2U)) : (I2C_CCR_FS | ((pclk) / ((speed) * 3U))))
+
+#define __HAL_I2C_GET_FLAG(handle, flag) ((((handle)->Instance->SR2) & (flag)) == (flag))
+#define __HAL_I2C_ENABLE(handle) ((handle)->Instance->CR1 |= I2C_CR1_PE)
+#define __HAL_I2C_DISABLE(handle) ((handle)->Instance->CR1 &= ~I2C_CR1_PE)
+
+typedef struct {
+	uint32_t ClockSpeed;
+	uint32_t DutyCycle;
+} I2C_InitTypeDef;
+
+typedef struct {
+	I2C_TypeDef* Instance;
+	I2C_InitTypeDef Init;
+	volatile uint32_t ErrorCode;
+} I2C_HandleTypeDef;
+
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_MODE_OUTPUT_OD 0x00000011U
+#define GPIO_NOPULL 0x00000000U
+#define GPIO_SPEED_FREQ_LOW 0x00000000U
+
+typedef enum {
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET,
+} GPIO_PinState;
+
+typedef struct {
+	uint32_t Pin;
+	uint32_t Mode;
+	uint32_t Pull;
+	uint32_t Speed;
+} GPIO_InitTypeDef;
+
+HAL_StatusTypeDef HAL_Init();
+
+uint32_t HAL_GetTick();
+
+void HAL_Delay(uint32_t delay);
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart);
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size, uint32_t timeout);
+
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size, uint32_t timeout);
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size);
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef* huart);
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart);
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart);
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority);
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+
+uint32_t HAL_RCC_GetPCLK1Freq();
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c);
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c);
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* hi2c, uint16_t address, uint32_t trials, uint32_t timeout);
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size);
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size,
+		uint32_t options);
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size,
+		uint32_t options);
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c);
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c);
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+
+void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init);
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+
+// Only in the host build
+bool host_uart_poll(uint32_t timeout_ms);
+
+bool host_i2c_poll();
+
+#endif /* HOST_HAL_INC_STM32F4XX_HAL_H_ */
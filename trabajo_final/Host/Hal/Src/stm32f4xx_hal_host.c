@@ -0,0 +1,403 @@
+#include "stm32f4xx_hal.h"
+#include "host_bus.h"
+#include "host_serial.h"
+#include <string.h>
+#include <time.h>
+
+// Longest write whose frames can be joined before handing it to the model
+#define I2C_MAX_WRITE 128
+
+// Core clock of the board after SystemClock_Config(), the DWT counter of the host build counts at this rate
+uint32_t SystemCoreClock = 84000000;
+
+CoreDebug_Type host_core_debug;
+USART_TypeDef host_usart2;
+IWDG_TypeDef host_iwdg;
+RCC_TypeDef host_rcc = {.CSR = RCC_CSR_PORRSTF | RCC_CSR_PINRSTF};
+DBGMCU_TypeDef host_dbgmcu;
+I2C_TypeDef host_i2c1;
+I2C_TypeDef host_i2c3;
+GPIO_TypeDef host_gpioa;
+GPIO_TypeDef host_gpiob;
+GPIO_TypeDef host_gpioc;
+uint32_t host_primask = 0;
+
+static DWT_Type dwt;
+// The cycle counter goes on from this count, taken at this time, when the core clock changes
+static uint32_t dwt_base_cycles = 0;
+static uint64_t dwt_base_ns = 0;
+static TIM_TypeDef tim2;
+static struct timespec start_time;
+
+// Reception started with HAL_UART_Receive_IT(), completed by host_uart_poll()
+static UART_HandleTypeDef* rx_handle = NULL;
+static uint8_t* rx_data;
+static uint16_t rx_size;
+
+// Transfer of a simulated bus, its callback is called by host_i2c_poll(). pending is NULL when there is none
+typedef struct {
+	I2C_HandleTypeDef* pending;
+	bool pending_read;
+
+	// Bytes of the write in progress, handed to the model when the write ends
+	uint8_t write[I2C_MAX_WRITE];
+	uint16_t write_size;
+} i2c_state_t;
+
+static i2c_state_t i2c_states[I2C_BUS_COUNT];
+// Set while a callback runs, interrupts of the same priority do not nest
+static bool in_i2c_callback = false;
+
+// Prototypes
+static uint64_t elapsed_ns();
+static i2c_bus_id_t get_i2c_bus(const I2C_HandleTypeDef* hi2c);
+static HAL_StatusTypeDef start_i2c_transfer(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size,
+		uint32_t options, bool read);
+static app_err_t end_i2c_write(I2C_HandleTypeDef* hi2c, uint16_t address);
+
+HAL_StatusTypeDef HAL_Init() {
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+	return HAL_OK;
+}
+
+/**
+ * @brief returns the DWT registers with the cycle counter updated to the current time
+ *
+ * @note the counter only runs while DWT_CTRL_CYCCNTENA is set, as on the board
+ */
+DWT_Type* host_dwt() {
+	if (dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+		dwt.CYCCNT = dwt_base_cycles + (uint32_t)((elapsed_ns() - dwt_base_ns) * (SystemCoreClock / 1000000) / 1000);
+	}
+
+	return &dwt;
+}
+
+/**
+ * @brief changes SystemCoreClock, the cycle counter goes on counting at the new rate as on the board
+ *
+ */
+void host_set_core_clock(uint32_t hz) {
+	dwt_base_cycles = host_dwt()->CYCCNT;
+	dwt_base_ns = elapsed_ns();
+	SystemCoreClock = hz;
+}
+
+/**
+ * @brief returns the TIM2 registers with the counter updated to the microseconds since HAL_Init()
+ *
+ */
+TIM_TypeDef* host_tim2() {
+	tim2.CNT = (uint32_t)(elapsed_ns() / 1000);
+	return &tim2;
+}
+
+uint32_t HAL_GetTick() {
+	return elapsed_ns() / 1000000;
+}
+
+void HAL_Delay(uint32_t delay) {
+	struct timespec request = {
+			.tv_sec = delay / 1000,
+			.tv_nsec = (delay % 1000) * 1000000L,
+	};
+	nanosleep(&request, NULL);
+}
+
+/**
+ * @brief checks the handle, the pseudo-terminal must be already open with host_serial_open()
+ *
+ */
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart) {
+	if (huart == NULL || huart->Instance != USART2) {
+		return HAL_ERROR;
+	}
+
+	return (host_serial_get_path() != NULL) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size, uint32_t timeout) {
+	if (huart == NULL || data == NULL || size == 0) {
+		return HAL_ERROR;
+	}
+
+	return host_serial_write(data, size) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size, uint32_t timeout) {
+	if (huart == NULL || data == NULL || size == 0) {
+		return HAL_ERROR;
+	}
+
+	return (host_serial_read(data, size, timeout) == size) ? HAL_OK : HAL_TIMEOUT;
+}
+
+/**
+ * @brief starts a reception, its bytes are received by host_uart_poll()
+ *
+ */
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size) {
+	if (huart == NULL || data == NULL || size == 0) {
+		return HAL_ERROR;
+	}
+
+	if (rx_handle != NULL) {
+		return HAL_BUSY;
+	}
+
+	rx_handle = huart;
+	rx_data = data;
+	rx_size = size;
+
+	return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef* huart) {
+}
+
+__attribute__((weak)) void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart) {
+}
+
+__attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart) {
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority) {
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq) {
+}
+
+/**
+ * @brief waits up to timeout_ms for the reception in progress and completes it, as the USART2 interrupt
+ *
+ * @return true if a reception was completed, false if there is none or its bytes did not arrive in time
+ */
+bool host_uart_poll(uint32_t timeout_ms) {
+	if (rx_handle == NULL) {
+		HAL_Delay(timeout_ms);
+		return false;
+	}
+
+	if (host_serial_read(rx_data, rx_size, timeout_ms) != rx_size) {
+		return false;
+	}
+
+	// The callback usually starts the next reception, so this one is finished before calling it
+	UART_HandleTypeDef* huart = rx_handle;
+	rx_handle = NULL;
+	HAL_UART_RxCpltCallback(huart);
+
+	return true;
+}
+
+/**
+ * @brief resets the peripheral, which clears BUSY and drops the transfer in progress
+ *
+ */
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c) {
+	if (hi2c == NULL) {
+		return HAL_ERROR;
+	}
+
+	i2c_state_t* state = &i2c_states[get_i2c_bus(hi2c)];
+	state->pending = NULL;
+	state->write_size = 0;
+
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+	hi2c->Instance->SR2 &= ~I2C_SR2_BUSY;
+	__HAL_I2C_ENABLE(hi2c);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c) {
+	if (hi2c == NULL) {
+		return HAL_ERROR;
+	}
+
+	i2c_states[get_i2c_bus(hi2c)].pending = NULL;
+	__HAL_I2C_DISABLE(hi2c);
+	return HAL_OK;
+}
+
+/**
+ * @brief probes the address up to trials times, each probe is charged as an empty transfer
+ *
+ */
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef* hi2c, uint16_t address, uint32_t trials, uint32_t timeout) {
+	if (hi2c == NULL) {
+		return HAL_ERROR;
+	}
+
+	if (i2c_states[get_i2c_bus(hi2c)].pending != NULL) {
+		return HAL_BUSY;
+	}
+
+	for (uint32_t trial = 0; trial < trials; trial++) {
+		if (host_bus_probe(get_i2c_bus(hi2c), address >> 1, hi2c->Init.ClockSpeed) == APP_OK) {
+			return HAL_OK;
+		}
+	}
+
+	return HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size) {
+	return start_i2c_transfer(hi2c, address, data, size, I2C_FIRST_AND_LAST_FRAME, false);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size,
+		uint32_t options) {
+	return start_i2c_transfer(hi2c, address, data, size, options, false);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size,
+		uint32_t options) {
+	return start_i2c_transfer(hi2c, address, data, size, options, true);
+}
+
+__attribute__((weak)) void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c) {
+}
+
+__attribute__((weak)) void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+}
+
+__attribute__((weak)) void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init) {
+}
+
+/**
+ * @brief reads back the level written to the pin, unless a slave holds it low
+ *
+ */
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin) {
+	port->IDR = port->ODR & ~port->held_low;
+	return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state) {
+	if (state == GPIO_PIN_SET) {
+		port->ODR |= pin;
+	} else {
+		port->ODR &= ~pin;
+	}
+}
+
+/**
+ * @brief calls the callback of every finished I2C transfer, as the I2C interrupts would
+ *
+ * Nothing is delivered while PRIMASK is set or from a callback
+ *
+ * @return true if some callback was called
+ */
+bool host_i2c_poll() {
+	if (host_primask || in_i2c_callback) {
+		return false;
+	}
+
+	bool delivered = false;
+	for (uint8_t idx = 0; idx < I2C_BUS_COUNT; idx++) {
+		I2C_HandleTypeDef* hi2c = i2c_states[idx].pending;
+		if (hi2c == NULL) {
+			continue;
+		}
+
+		// The callback usually starts the next transfer, so this one is finished before calling it
+		i2c_states[idx].pending = NULL;
+		in_i2c_callback = true;
+		if (hi2c->ErrorCode != HAL_I2C_ERROR_NONE) {
+			HAL_I2C_ErrorCallback(hi2c);
+		} else if (i2c_states[idx].pending_read) {
+			HAL_I2C_MasterRxCpltCallback(hi2c);
+		} else {
+			HAL_I2C_MasterTxCpltCallback(hi2c);
+		}
+
+		in_i2c_callback = false;
+		delivered = true;
+	}
+
+	return delivered;
+}
+
+void __WFI() {
+	host_i2c_poll();
+}
+
+uint64_t elapsed_ns() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - start_time.tv_sec) * 1000000000 + (now.tv_nsec - start_time.tv_nsec);
+}
+
+i2c_bus_id_t get_i2c_bus(const I2C_HandleTypeDef* hi2c) {
+	return (hi2c->Instance == I2C3) ? I2C_BUS_3 : I2C_BUS_1;
+}
+
+/**
+ * @brief hands a frame to the models and leaves its callback pending
+ *
+ * The frames of a write are joined until one of them ends it with a STOP, or a read follows it with a
+ * repeated START. A NACK is reported at the end of the write.
+ *
+ */
+HAL_StatusTypeDef start_i2c_transfer(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size,
+		uint32_t options, bool read) {
+	if (hi2c == NULL || data == NULL || size == 0) {
+		return HAL_ERROR;
+	}
+
+	i2c_state_t* state = &i2c_states[get_i2c_bus(hi2c)];
+	if (state->pending != NULL) {
+		return HAL_BUSY;
+	}
+
+	if (options == I2C_FIRST_FRAME || options == I2C_FIRST_AND_LAST_FRAME) {
+		state->write_size = 0;
+	}
+
+	app_err_t result;
+	if (read) {
+		result = end_i2c_write(hi2c, address);
+		if (result == APP_OK) {
+			result = host_bus_transfer(get_i2c_bus(hi2c), address >> 1, true, data, size, hi2c->Init.ClockSpeed);
+		}
+	} else {
+		if (state->write_size + size > I2C_MAX_WRITE) {
+			return HAL_ERROR;
+		}
+
+		memcpy(&state->write[state->write_size], data, size);
+		state->write_size += size;
+		bool stop = options == I2C_LAST_FRAME || options == I2C_FIRST_AND_LAST_FRAME;
+		result = stop ? end_i2c_write(hi2c, address) : APP_OK;
+	}
+
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+	if (result == I2C_ERR_NACK) {
+		hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+	} else if (result != APP_OK) {
+		hi2c->ErrorCode = HAL_I2C_ERROR_BERR;
+	}
+
+	state->pending = hi2c;
+	state->pending_read = read;
+	return HAL_OK;
+}
+
+/**
+ * @brief hands the joined frames of the write in progress to the model
+ *
+ * @return APP_OK if there is no write in progress, otherwise the result of the model
+ */
+app_err_t end_i2c_write(I2C_HandleTypeDef* hi2c, uint16_t address) {
+	i2c_state_t* state = &i2c_states[get_i2c_bus(hi2c)];
+	uint16_t size = state->write_size;
+	if (size == 0) {
+		return APP_OK;
+	}
+
+	state->write_size = 0;
+	return host_bus_transfer(get_i2c_bus(hi2c), address >> 1, false, state->write, size, hi2c->Init.ClockSpeed);
+}
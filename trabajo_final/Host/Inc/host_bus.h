@@ -0,0 +1,57 @@
+#ifndef HOST_INC_HOST_BUS_H_
+#define HOST_INC_HOST_BUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+#include "port.h"
+
+// Maximum amount of device models on the simulated buses
+#define HOST_BUS_MAX_MODELS 8
+
+/*
+ * Model of a device on a simulated bus. write() gets the bytes of each write transfer and read() fills each
+ * read transfer, both return APP_OK or I2C_ERR_NACK if the device would not acknowledge. state is given
+ * back to both callbacks.
+ */
+typedef struct {
+	uint16_t address;
+	i2c_bus_id_t bus;
+	app_err_t (*write)(void* state, const uint8_t* data, uint16_t size);
+	app_err_t (*read)(void* state, uint8_t* buffer, uint16_t size);
+	void* state;
+} host_model_t;
+
+// Traffic seen by the models, bus_time_us is the time it would take on a real bus at the speed of each transfer
+typedef struct {
+	uint32_t transfers;
+	uint32_t bytes;
+	uint32_t nacks;
+	uint64_t bus_time_us;
+} host_bus_stats_t;
+
+/*
+ * Clock seen by the drivers. The real clock is the monotonic clock of the process and delays sleep. The
+ * virtual clock only advances with delays and bus time, so benchmarks give the same result on any machine.
+ */
+typedef enum {
+	HOST_CLOCK_REAL,
+	HOST_CLOCK_VIRTUAL,
+} host_clock_t;
+
+// Implementation of the port used by the host builds, the I2C core drives the models through the HAL stand-in
+extern const port_ops_t PORT_HOST_OPS;
+
+void host_bus_reset(host_clock_t clock);
+
+app_err_t host_bus_add_model(const host_model_t* model);
+
+void host_bus_get_stats(host_bus_stats_t* stats);
+
+uint64_t host_bus_now_us();
+
+app_err_t host_bus_transfer(i2c_bus_id_t bus, uint16_t address, bool read, uint8_t* data, uint16_t size, uint32_t speed);
+
+app_err_t host_bus_probe(i2c_bus_id_t bus, uint16_t address, uint32_t speed);
+
+#endif /* HOST_INC_HOST_BUS_H_ */
@@ -0,0 +1,46 @@
+#ifndef HOST_INC_HOST_SCRIPT_H_
+#define HOST_INC_HOST_SCRIPT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+typedef enum {
+	HOST_STEP_WRITE,
+	HOST_STEP_READ,
+} host_step_kind_t;
+
+/*
+ * Transfer a scripted device expects next. For a write, data is compared with what the driver sends (NULL
+ * accepts any bytes). For a read, data is what the device answers, padded with zeros. If nack is set the
+ * device does not acknowledge the transfer.
+ */
+typedef struct {
+	host_step_kind_t kind;
+	const uint8_t* data;
+	uint16_t size;
+	bool nack;
+} host_step_t;
+
+/*
+ * Device model that plays a fixed sequence of transfers, to be given as state of a host_model_t with
+ * host_script_write() and host_script_read() as callbacks. A transfer out of the script is not
+ * acknowledged and counted as a mismatch. With loop set the script starts again after the last step.
+ */
+typedef struct {
+	const host_step_t* steps;
+	uint16_t amount_of_steps;
+	uint16_t next;
+	bool loop;
+	uint32_t mismatches;
+} host_script_t;
+
+void host_script_init(host_script_t* script, const host_step_t* steps, uint16_t amount_of_steps, bool loop);
+
+app_err_t host_script_write(void* state, const uint8_t* data, uint16_t size);
+
+app_err_t host_script_read(void* state, uint8_t* buffer, uint16_t size);
+
+bool host_script_done(const host_script_t* script);
+
+#endif /* HOST_INC_HOST_SCRIPT_H_ */
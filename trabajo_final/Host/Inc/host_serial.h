@@ -0,0 +1,18 @@
+#ifndef HOST_INC_HOST_SERIAL_H_
+#define HOST_INC_HOST_SERIAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+
+app_err_t host_serial_open(const char* link_path);
+
+const char* host_serial_get_path();
+
+uint16_t host_serial_read(uint8_t* buffer, uint16_t size, uint32_t timeout_ms);
+
+bool host_serial_write(const uint8_t* data, uint16_t size);
+
+void host_serial_close();
+
+#endif /* HOST_INC_HOST_SERIAL_H_ */
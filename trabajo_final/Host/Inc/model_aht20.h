@@ -0,0 +1,34 @@
+#ifndef HOST_INC_MODEL_AHT20_H_
+#define HOST_INC_MODEL_AHT20_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+#include "host_bus.h"
+
+#define MODEL_AHT20_ADDRESS 0x38
+
+// Time the sensor stays busy after a measurement is triggered, as in the datasheet
+#define MODEL_AHT20_MEASUREMENT_US 80000
+
+/*
+ * AHT20 model: status (0x71), initialization (0xBE), trigger (0xAC) and soft reset (0xBA) commands. Reads
+ * return the status byte, 20 bits of humidity, 20 bits of temperature and the CRC, truncated to the size
+ * asked. The measured values are the ones given to model_aht20_set().
+ */
+typedef struct {
+	bool calibrated;
+	uint64_t busy_until_us;
+	double temp;
+	double hum;
+	uint8_t frame[7];
+	uint32_t measurements;
+} model_aht20_t;
+
+void model_aht20_init(model_aht20_t* model, double temp, double hum);
+
+void model_aht20_set(model_aht20_t* model, double temp, double hum);
+
+host_model_t model_aht20_as_device(model_aht20_t* model, i2c_bus_id_t bus);
+
+#endif /* HOST_INC_MODEL_AHT20_H_ */
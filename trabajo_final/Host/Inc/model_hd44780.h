@@ -0,0 +1,38 @@
+#ifndef HOST_INC_MODEL_HD44780_H_
+#define HOST_INC_MODEL_HD44780_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "error.h"
+#include "host_bus.h"
+
+#define MODEL_HD44780_ADDRESS 0x27
+
+// DDRAM of a 2-line panel: 40 characters from 0x00 and 40 from 0x40
+#define MODEL_HD44780_DDRAM_SIZE 0x68
+
+/*
+ * HD44780 behind a PCF8574 backpack. Every byte written is the port of the expander (bits 7-4: D7-D4,
+ * bit 2: EN, bit 0: RS) and a nibble is latched on each falling edge of EN. It starts in 8-bit mode and
+ * switches to 4-bit mode with a function set, as the real controller. Only the commands the driver
+ * uses are modelled: clear, return home, set DDRAM address and data writes with increment.
+ */
+typedef struct {
+	uint8_t ddram[MODEL_HD44780_DDRAM_SIZE];
+	uint8_t address;
+	uint8_t port;
+	bool four_bit;
+	bool high_nibble_latched;
+	uint8_t high_nibble;
+	uint32_t commands;
+	uint32_t characters;
+	uint32_t changes;
+} model_hd44780_t;
+
+void model_hd44780_init(model_hd44780_t* model);
+
+host_model_t model_hd44780_as_device(model_hd44780_t* model, uint16_t address, i2c_bus_id_t bus);
+
+void model_hd44780_get_text(const model_hd44780_t* model, uint8_t address, uint8_t* text, uint8_t size);
+
+#endif /* HOST_INC_MODEL_HD44780_H_ */
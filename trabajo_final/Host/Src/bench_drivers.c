@@ -0,0 +1,156 @@
+#include "stm32f4xx_hal.h"
+#include "API_ht_sensor.h"
+#include "API_lcd.h"
+#include "cycles.h"
+#include "i2c_core.h"
+#include "port.h"
+#include "host_bus.h"
+#include "model_aht20.h"
+#include "model_hd44780.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 1000
+
+#define BENCH_TEMP 21.25
+#define BENCH_HUM 55.5
+
+// Largest difference accepted between the value of the model and the one read by the driver
+#define TOLERANCE 0.01
+
+static model_aht20_t sensor;
+static model_hd44780_t display;
+
+// Prototypes
+static bool bench_sensor(uint32_t iterations);
+static bool bench_display(uint32_t iterations);
+static void print_result(const char* name, uint32_t iterations, const host_bus_stats_t* start,
+		uint64_t start_us, clock_t start_cpu);
+
+/**
+ * @brief measures the throughput of the sensor and display drivers against the device models
+ *
+ * The bus runs on the virtual clock, so the bus time and the time seen by the drivers only depend on the
+ * driver code and the results can be compared between commits. The CPU time is the one of the host.
+ * It fails if a driver returns an error or the values read do not match the models.
+ *
+ * Usage: driver_bench [iterations]
+ *
+ */
+int main(int argc, char** argv) {
+	uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+
+	HAL_Init();
+	cycles_init();
+
+	host_bus_reset(HOST_CLOCK_VIRTUAL);
+	model_aht20_init(&sensor, BENCH_TEMP, BENCH_HUM);
+	model_hd44780_init(&display);
+
+	host_model_t sensor_device = model_aht20_as_device(&sensor, I2C_HT_SENSOR_BUS);
+	host_model_t display_device = model_hd44780_as_device(&display, MODEL_HD44780_ADDRESS, I2C_LCD_BUS);
+	if (host_bus_add_model(&sensor_device) != APP_OK || host_bus_add_model(&display_device) != APP_OK
+			|| port_init(&PORT_HOST_OPS) != APP_OK || lcd_init() != APP_OK || ht_init() != APP_OK) {
+		fprintf(stderr, "Could not initialize the drivers\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("%-10s %10s %12s %12s %12s %12s\n", "driver", "operations", "bytes/op", "bus us/op", "driver us/op",
+			"cpu ns/op");
+
+	bool ok = bench_sensor(iterations) && bench_display(iterations);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief triggers and reads a temperature and humidity measurement per iteration
+ *
+ */
+bool bench_sensor(uint32_t iterations) {
+	ht_query_t query = {0};
+	if (ht_query_init(&query, (uint8_t*)"TEMP&HUM", (uint8_t*)"C") != APP_OK) {
+		return false;
+	}
+
+	host_bus_stats_t start;
+	host_bus_get_stats(&start);
+	uint64_t start_us = host_bus_now_us();
+	clock_t start_cpu = clock();
+
+	for (uint32_t idx = 0; idx < iterations; idx++) {
+		ht_measurement_t measurement;
+		if (ht_trigger_measurement(query) != APP_OK || ht_read_measurement(&measurement) != APP_OK) {
+			fprintf(stderr, "Sensor: measurement %u failed\n", idx);
+			return false;
+		}
+
+		if (fabs(measurement.temp_data.temp - BENCH_TEMP) > TOLERANCE || fabs(measurement.hum - BENCH_HUM) > TOLERANCE) {
+			fprintf(stderr, "Sensor: read %.3f C %.3f %% instead of %.3f C %.3f %%\n", measurement.temp_data.temp,
+					measurement.hum, BENCH_TEMP, BENCH_HUM);
+			return false;
+		}
+	}
+
+	print_result("sensor", iterations, &start, start_us, start_cpu);
+	return true;
+}
+
+/**
+ * @brief writes a whole new frame per iteration, every row changes so nothing is coalesced
+ *
+ */
+bool bench_display(uint32_t iterations) {
+	host_bus_stats_t start;
+	host_bus_get_stats(&start);
+	uint64_t start_us = host_bus_now_us();
+	clock_t start_cpu = clock();
+
+	uint8_t text[LCD_COLS + 1];
+	uint8_t shown[LCD_COLS + 1];
+	for (uint32_t idx = 0; idx < iterations; idx++) {
+		for (uint8_t row = 0; row < LCD_ROWS; row++) {
+			memset(text, 'A' + (idx + row) % 26, LCD_COLS);
+			text[LCD_COLS] = '\0';
+
+			if (lcd_update_row(row, text) != APP_OK) {
+				fprintf(stderr, "Display: frame %u failed\n", idx);
+				return false;
+			}
+		}
+
+		if (lcd_flush() != APP_OK) {
+			fprintf(stderr, "Display: frame %u failed\n", idx);
+			return false;
+		}
+
+		// The rows are written by the interrupts of the I2C core
+		while (!I2C_is_idle()) {
+			__WFI();
+		}
+
+		model_hd44780_get_text(&display, LCD_ROW_ADDRESS(LCD_ROWS - 1), shown, LCD_COLS);
+		if (memcmp(shown, text, LCD_COLS)) {
+			fprintf(stderr, "Display: frame %u shows \"%s\" instead of \"%s\"\n", idx, shown, text);
+			return false;
+		}
+	}
+
+	print_result("display", iterations, &start, start_us, start_cpu);
+	return true;
+}
+
+void print_result(const char* name, uint32_t iterations, const host_bus_stats_t* start, uint64_t start_us,
+		clock_t start_cpu) {
+	host_bus_stats_t end;
+	host_bus_get_stats(&end);
+
+	double cpu_ns = (double)(clock() - start_cpu) * 1e9 / CLOCKS_PER_SEC;
+	printf("%-10s %10u %12.1f %12.1f %12.1f %12.1f\n", name, iterations,
+			(double)(end.bytes - start->bytes) / iterations,
+			(double)(end.bus_time_us - start->bus_time_us) / iterations,
+			(double)(host_bus_now_us() - start_us) / iterations,
+			cpu_ns / iterations);
+}
@@ -0,0 +1,87 @@
+#include "API_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 1000000
+
+// Text of a row of the display, as the views build it
+#define TEXT_SIZE 17
+#define LABEL "TEMP: "
+#define PRECISION 2
+
+// Same spread of values as the sensor gives, from -50 C to 150 C
+#define FIRST_VALUE -50.0
+#define VALUE_STEP 0.0002
+
+// Prototypes
+static uint8_t format_printf(uint8_t* text, double value);
+static uint8_t format_fmt(uint8_t* text, double value);
+static double bench(const char* name, uint8_t (*format)(uint8_t*, double), uint32_t iterations, uint32_t* checksum);
+
+/**
+ * @brief measures the text of a measurement row built with fmt_double() against the snprintf() of before
+ *
+ * Both build the same "TEMP: <value>" text, it fails if they ever differ. The times are the CPU time of the
+ * host, so they only compare the two, the ratio is what matters on the board.
+ *
+ * Usage: format_bench [iterations]
+ *
+ */
+int main(int argc, char** argv) {
+	uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+
+	for (uint32_t idx = 0; idx < iterations; idx++) {
+		uint8_t expected[TEXT_SIZE];
+		uint8_t text[TEXT_SIZE];
+		double value = FIRST_VALUE + idx * VALUE_STEP;
+		uint8_t length = format_printf(expected, value);
+		if (format_fmt(text, value) != length || memcmp(text, expected, length)) {
+			fprintf(stderr, "%.17g: \"%.*s\" instead of \"%.*s\"\n", value, length, text, length, expected);
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("%-10s %10s %12s\n", "formatter", "values", "cpu ns/op");
+
+	uint32_t checksum = 0;
+	double printf_ns = bench("snprintf", format_printf, iterations, &checksum);
+	double fmt_ns = bench("fmt", format_fmt, iterations, &checksum);
+	printf("fmt takes %.2f times the time of snprintf (checksum %u)\n", fmt_ns / printf_ns, checksum);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief the text of a row as it was built before the formatter
+ *
+ */
+uint8_t format_printf(uint8_t* text, double value) {
+	int length = snprintf((char*)text, TEXT_SIZE, LABEL "%.*f", PRECISION, value);
+	return (length < TEXT_SIZE) ? length : TEXT_SIZE - 1;
+}
+
+uint8_t format_fmt(uint8_t* text, double value) {
+	memcpy(text, LABEL, strlen(LABEL));
+	return strlen(LABEL) + fmt_double(&text[strlen(LABEL)], TEXT_SIZE - strlen(LABEL), value, PRECISION, 0);
+}
+
+/**
+ * @brief formats iterations values, the checksum keeps the compiler from dropping the text
+ *
+ * @return the CPU time per value in nanoseconds
+ */
+double bench(const char* name, uint8_t (*format)(uint8_t*, double), uint32_t iterations, uint32_t* checksum) {
+	uint8_t text[TEXT_SIZE];
+	clock_t start_cpu = clock();
+
+	for (uint32_t idx = 0; idx < iterations; idx++) {
+		uint8_t length = format(text, FIRST_VALUE + idx * VALUE_STEP);
+		*checksum += length + text[length - 1];
+	}
+
+	double cpu_ns = (double)(clock() - start_cpu) * 1e9 / CLOCKS_PER_SEC / iterations;
+	printf("%-10s %10u %12.1f\n", name, iterations, cpu_ns);
+	return cpu_ns;
+}
@@ -0,0 +1,82 @@
+#include "clock.h"
+#include "stm32f4xx_hal.h"
+#include "API_scheduler.h"
+#include "i2c_core.h"
+#include "i2c_trace.h"
+#include "lcd_port.h"
+#include "perf.h"
+#include <stddef.h>
+
+/*
+ * Clock profiles of the host build. SystemCoreClock sets the rate of the DWT counter and the APB1 clock the
+ * clock registers of the I2C buses, the timebase and the UART do not depend on them here.
+ */
+
+typedef struct {
+	uint32_t sysclk_hz;
+	uint32_t pclk1_hz;
+	uint32_t pclk2_hz;
+	uint8_t flash_latency;
+} profile_clocks_t;
+
+// Same clock trees as the board
+static const profile_clocks_t PROFILES[CLOCK_PROFILE_COUNT] = {
+		[CLOCK_PROFILE_PERFORMANCE] = {180000000, 45000000, 90000000, 5},
+		[CLOCK_PROFILE_BALANCED] = {84000000, 42000000, 84000000, 2},
+		[CLOCK_PROFILE_LOW] = {16000000, 16000000, 16000000, 0},
+};
+
+static clock_profile_t current_profile = CLOCK_PROFILE_BALANCED;
+
+app_err_t clock_set_profile(clock_profile_t profile) {
+	if (profile >= CLOCK_PROFILE_COUNT) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (profile == current_profile) {
+		return APP_OK;
+	}
+
+	if (!I2C_is_idle()) {
+		return CLOCK_ERR_BUSY;
+	}
+
+	current_profile = profile;
+	host_set_core_clock(PROFILES[profile].sysclk_hz);
+	I2C_update_clock();
+	lcd_port_update_clock();
+
+	// Same as the board, the statistics in cycles of the previous clock are cleared
+	sched_reset_stats();
+#if PERF_ENABLED
+	perf_reset();
+#endif
+#if I2C_TRACE_ENABLED
+	i2c_trace_clear();
+#endif
+	return APP_OK;
+}
+
+clock_profile_t clock_get_profile() {
+	return current_profile;
+}
+
+void clock_get_info(clock_info_t* info) {
+	if (info == NULL) {
+		return;
+	}
+
+	info->profile = current_profile;
+	info->sysclk_hz = PROFILES[current_profile].sysclk_hz;
+	info->pclk1_hz = PROFILES[current_profile].pclk1_hz;
+	info->pclk2_hz = PROFILES[current_profile].pclk2_hz;
+	info->flash_latency = PROFILES[current_profile].flash_latency;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq() {
+	return PROFILES[current_profile].pclk1_hz;
+}
+
+app_err_t clock_restore() {
+	return APP_OK;
+}
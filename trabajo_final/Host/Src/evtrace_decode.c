@@ -0,0 +1,163 @@
+#include "evtrace.h"
+#include "error.h"
+#include "API_cmdparser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE_LENGTH 256
+#define MAX_ARG_LENGTH 32
+
+// Header and end of the dump printed by TRACE EVENTS
+#define DUMP_HEADER "EVTRACE "
+#define DUMP_END "EVTRACE END"
+
+typedef struct {
+	const char* name;
+	evtrace_arg_t arg;
+} event_info_t;
+
+#define EVTRACE_INFO(id, event_name, event_arg) [id] = {.name = event_name, .arg = event_arg},
+static const event_info_t EVENTS[EVTRACE_EVENT_COUNT] = {
+		EVTRACE_EVENTS(EVTRACE_INFO)
+};
+#undef EVTRACE_INFO
+
+// Prototypes
+static bool find_header(FILE* input, unsigned long* rate, unsigned long* records, unsigned long* written);
+static unsigned long print_timeline(FILE* input, unsigned long rate);
+static void format_arg(char* buffer, size_t size, uint16_t id, uint16_t arg);
+static uint64_t ticks_to_us(uint64_t ticks, unsigned long rate);
+
+/**
+ * @brief prints the event trace dumped by the TRACE EVENTS command as a timeline
+ *
+ * The input is the text received from the board, read from the given file or from stdin. Everything before
+ * the dump is skipped, so a capture of the whole session can be given as is. Each event is printed with its
+ * time since the first event and since the previous one, which is negative when an interrupt traced while
+ * the interrupted code was writing its event.
+ *
+ * Usage: evtrace_decode [capture]
+ *
+ */
+int main(int argc, char** argv) {
+	FILE* input = stdin;
+	if (argc > 1 && (input = fopen(argv[1], "r")) == NULL) {
+		perror(argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	unsigned long rate;
+	unsigned long records;
+	unsigned long written;
+	if (!find_header(input, &rate, &records, &written)) {
+		fprintf(stderr, "No event trace found in the input\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("%lu events traced, the last %lu are kept\n", written, records);
+	printf("%12s %12s  %-14s %s\n", "time (us)", "delta (us)", "event", "argument");
+
+	unsigned long decoded = print_timeline(input, rate);
+	if (decoded != records) {
+		fprintf(stderr, "The dump is truncated, %lu of %lu records decoded\n", decoded, records);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief skips the input up to the header of the dump and reads it
+ *
+ * @return true if the header is found
+ */
+bool find_header(FILE* input, unsigned long* rate, unsigned long* records, unsigned long* written) {
+	char line[MAX_LINE_LENGTH];
+
+	while (fgets(line, sizeof(line), input) != NULL) {
+		char* header = strstr(line, DUMP_HEADER);
+		if (header != NULL && sscanf(header, DUMP_HEADER "%lu %lu %lu", rate, records, written) == 3 && *rate > 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief prints one line per record up to the end of the dump
+ *
+ * @return the amount of records decoded
+ */
+unsigned long print_timeline(FILE* input, unsigned long rate) {
+	char line[MAX_LINE_LENGTH];
+	unsigned long decoded = 0;
+	uint32_t first = 0;
+	uint32_t previous = 0;
+
+	while (fgets(line, sizeof(line), input) != NULL && strstr(line, DUMP_END) == NULL) {
+		unsigned int timestamp;
+		unsigned int id;
+		unsigned int arg;
+		if (sscanf(line, " %x %x %x", &timestamp, &id, &arg) != 3) {
+			continue;
+		}
+
+		if (decoded == 0) {
+			first = timestamp;
+			previous = timestamp;
+		}
+
+		// Differences wrap around with the timestamps, the trace spans much less than a lap
+		int32_t delta = (int32_t)(timestamp - previous);
+		int64_t delta_us = (delta < 0) ? -(int64_t)ticks_to_us(-(int64_t)delta, rate) : (int64_t)ticks_to_us(delta, rate);
+		char arg_text[MAX_ARG_LENGTH];
+		format_arg(arg_text, sizeof(arg_text), id, arg);
+
+		printf("%12llu %+12lld  %-14s %s\n", (unsigned long long)ticks_to_us((uint32_t)(timestamp - first), rate),
+				(long long)delta_us,
+				(id < EVTRACE_EVENT_COUNT) ? EVENTS[id].name : "UNKNOWN", arg_text);
+
+		previous = timestamp;
+		decoded++;
+	}
+
+	return decoded;
+}
+
+/**
+ * @brief writes the argument of the event as its description in evtrace.h says
+ *
+ */
+void format_arg(char* buffer, size_t size, uint16_t id, uint16_t arg) {
+	evtrace_arg_t kind = (id < EVTRACE_EVENT_COUNT) ? EVENTS[id].arg : EVTRACE_ARG_HEX;
+	uint8_t* name;
+
+	switch (kind) {
+	case EVTRACE_ARG_NONE:
+		buffer[0] = '\0';
+		break;
+	case EVTRACE_ARG_DEC:
+		snprintf(buffer, size, "%u", arg);
+		break;
+	case EVTRACE_ARG_ERROR:
+		name = app_err_to_name((arg >= 0xFF00) ? (app_err_t)(int16_t)arg : (app_err_t)arg);
+		snprintf(buffer, size, "%s", (char*)name);
+		break;
+	case EVTRACE_ARG_STATE:
+		name = cmdparser_get_state_name(arg);
+		if (name != NULL) {
+			snprintf(buffer, size, "%s", (char*)name);
+		} else {
+			snprintf(buffer, size, "%u", arg);
+		}
+		break;
+	default:
+		snprintf(buffer, size, "0x%04X", arg);
+	}
+}
+
+uint64_t ticks_to_us(uint64_t ticks, unsigned long rate) {
+	return ticks * 1000000 / rate;
+}
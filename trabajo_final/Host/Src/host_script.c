@@ -0,0 +1,88 @@
+#include "host_script.h"
+#include "i2c_core.h"
+#include <stddef.h>
+#include <string.h>
+
+// Prototypes
+static const host_step_t* take_step(host_script_t* script, host_step_kind_t kind);
+
+/**
+ * @brief prepares the script to play from its first step
+ *
+ */
+void host_script_init(host_script_t* script, const host_step_t* steps, uint16_t amount_of_steps, bool loop) {
+	script->steps = steps;
+	script->amount_of_steps = amount_of_steps;
+	script->next = 0;
+	script->loop = loop;
+	script->mismatches = 0;
+}
+
+/**
+ * @brief checks the write against the next step of the script
+ *
+ * @return APP_OK, or I2C_ERR_NACK if the step says so or the write does not match it
+ */
+app_err_t host_script_write(void* state, const uint8_t* data, uint16_t size) {
+	host_script_t* script = state;
+	const host_step_t* step = take_step(script, HOST_STEP_WRITE);
+	if (step == NULL) {
+		return I2C_ERR_NACK;
+	}
+
+	if (step->data != NULL && (step->size != size || memcmp(step->data, data, size))) {
+		script->mismatches++;
+		return I2C_ERR_NACK;
+	}
+
+	return step->nack ? I2C_ERR_NACK : APP_OK;
+}
+
+/**
+ * @brief answers the read with the data of the next step of the script
+ *
+ * @return APP_OK, or I2C_ERR_NACK if the step says so or the next step is not a read
+ */
+app_err_t host_script_read(void* state, uint8_t* buffer, uint16_t size) {
+	host_script_t* script = state;
+	const host_step_t* step = take_step(script, HOST_STEP_READ);
+	if (step == NULL) {
+		return I2C_ERR_NACK;
+	}
+
+	if (step->nack) {
+		return I2C_ERR_NACK;
+	}
+
+	uint16_t copied = (step->size < size) ? step->size : size;
+	memcpy(buffer, step->data, copied);
+	memset(&buffer[copied], 0, size - copied);
+
+	return APP_OK;
+}
+
+/**
+ * @brief checks if every step was played without mismatches
+ *
+ */
+bool host_script_done(const host_script_t* script) {
+	return script->next >= script->amount_of_steps && script->mismatches == 0;
+}
+
+/**
+ * @brief moves to the next step if it is of the given kind
+ *
+ * @return the step, or NULL if the script ended or the step is of the other kind, which is a mismatch
+ */
+const host_step_t* take_step(host_script_t* script, host_step_kind_t kind) {
+	if (script->next >= script->amount_of_steps && script->loop) {
+		script->next = 0;
+	}
+
+	if (script->next >= script->amount_of_steps || script->steps[script->next].kind != kind) {
+		script->mismatches++;
+		return NULL;
+	}
+
+	return &script->steps[script->next++];
+}
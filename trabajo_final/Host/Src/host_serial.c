@@ -0,0 +1,148 @@
+#include "host_serial.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static int master_fd = -1;
+static int slave_fd = -1;
+static const char* slave_path = NULL;
+static const char* serial_link = NULL;
+
+// Prototypes
+static uint64_t now_ms();
+
+/**
+ * @brief opens a pseudo-terminal that plays the role of the USART2 link of the board
+ *
+ * The terminal is raw, so the application echoes the characters as the board does. Any tool that talks to
+ * a serial port (screen, picocom, pyserial...) can open the path returned by host_serial_get_path().
+ *
+ * @param link_path: if not NULL, a symbolic link to the terminal is created there, so scripts get a fixed path
+ *
+ * @return APP_OK, or APP_FAIL if the terminal or the link could not be created
+ */
+app_err_t host_serial_open(const char* link_path) {
+	master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0) {
+		return APP_FAIL;
+	}
+
+	slave_path = ptsname(master_fd);
+	if (slave_path == NULL) {
+		return APP_FAIL;
+	}
+
+	// Keeping the slave side open avoids hang-ups on the master when the last client closes the port
+	slave_fd = open(slave_path, O_RDWR | O_NOCTTY);
+	if (slave_fd < 0) {
+		return APP_FAIL;
+	}
+
+	struct termios settings;
+	if (tcgetattr(slave_fd, &settings) != 0) {
+		return APP_FAIL;
+	}
+
+	cfmakeraw(&settings);
+	if (tcsetattr(slave_fd, TCSANOW, &settings) != 0) {
+		return APP_FAIL;
+	}
+
+	if (link_path != NULL) {
+		unlink(link_path);
+		if (symlink(slave_path, link_path) != 0) {
+			return APP_FAIL;
+		}
+
+		serial_link = link_path;
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief returns the path of the terminal the clients must open, or NULL if it is not open
+ *
+ */
+const char* host_serial_get_path() {
+	return (serial_link != NULL) ? serial_link : slave_path;
+}
+
+/**
+ * @brief reads from the terminal until size bytes arrive or the timeout expires
+ *
+ * @return the amount of bytes read
+ */
+uint16_t host_serial_read(uint8_t* buffer, uint16_t size, uint32_t timeout_ms) {
+	uint16_t received = 0;
+	uint64_t deadline = now_ms() + timeout_ms;
+
+	while (received < size && master_fd >= 0) {
+		uint64_t now = now_ms();
+		if (now >= deadline) {
+			break;
+		}
+
+		struct pollfd request = {.fd = master_fd, .events = POLLIN};
+		if (poll(&request, 1, deadline - now) <= 0) {
+			continue;
+		}
+
+		ssize_t amount = read(master_fd, &buffer[received], size - received);
+		if (amount > 0) {
+			received += amount;
+		}
+	}
+
+	return received;
+}
+
+/**
+ * @brief writes the data to the terminal
+ *
+ * @return true if every byte was written
+ */
+bool host_serial_write(const uint8_t* data, uint16_t size) {
+	uint16_t written = 0;
+	while (written < size && master_fd >= 0) {
+		ssize_t amount = write(master_fd, &data[written], size - written);
+		if (amount <= 0) {
+			return false;
+		}
+
+		written += amount;
+	}
+
+	return written == size;
+}
+
+/**
+ * @brief closes the terminal and removes the link
+ *
+ */
+void host_serial_close() {
+	if (serial_link != NULL) {
+		unlink(serial_link);
+		serial_link = NULL;
+	}
+
+	if (slave_fd >= 0) {
+		close(slave_fd);
+		slave_fd = -1;
+	}
+
+	if (master_fd >= 0) {
+		close(master_fd);
+		master_fd = -1;
+	}
+}
+
+uint64_t now_ms() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
@@ -0,0 +1,159 @@
+#include "stm32f4xx_hal.h"
+#include "API_cmdparser.h"
+#include "API_ht_sensor.h"
+#include "API_lcd.h"
+#include "API_scheduler.h"
+#include "API_tasks.h"
+#include "API_timers.h"
+#include "API_views.h"
+#include "boot.h"
+#include "cycles.h"
+#include "port.h"
+#include "watchdog.h"
+#include "host_bus.h"
+#include "host_serial.h"
+#include "model_aht20.h"
+#include "model_hd44780.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Values measured by the simulated sensor unless given in the command line
+#define DEFAULT_TEMP 23.5
+#define DEFAULT_HUM 45.0
+
+// Longest wait for the pseudo-terminal, so a stop request or a display change is noticed in time
+#define MAX_IDLE_MS 50
+
+static model_aht20_t sensor;
+static model_hd44780_t display;
+static volatile sig_atomic_t running = 1;
+
+// Prototypes
+static app_err_t init_cmdparser_step(uint32_t* wait_us);
+static void stop(int signal);
+static void print_display();
+static void idle(uint32_t max_sleep_ms);
+
+// Same phases as the firmware
+static const boot_phase_t BOOT_PHASES[] = {
+		{(uint8_t*)"UART", init_cmdparser_step, 0},
+		{(uint8_t*)"LCD", lcd_init_step, 0},
+		{(uint8_t*)"AHT20", ht_init_step, 0},
+};
+
+/**
+ * @brief runs the application layer of the board in a Linux process
+ *
+ * The command interface is a pseudo-terminal, the AHT20 and the LCD are models on the simulated I2C buses,
+ * with the same bus map as the firmware. The tasks run on the scheduler as on the board, the idle hook waits
+ * for the pseudo-terminal instead of sleeping. Every change of the display is printed on stdout.
+ *
+ * Usage: trabajo_final_host [link path] [temperature] [humidity]
+ *
+ */
+int main(int argc, char** argv) {
+	const char* link_path = (argc > 1) ? argv[1] : NULL;
+	double temp = (argc > 2) ? atof(argv[2]) : DEFAULT_TEMP;
+	double hum = (argc > 3) ? atof(argv[3]) : DEFAULT_HUM;
+
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+
+	HAL_Init();
+	cycles_init();
+	watchdog_init();
+
+	if (host_serial_open(link_path) != APP_OK) {
+		fprintf(stderr, "Could not open the pseudo-terminal\n");
+		return EXIT_FAILURE;
+	}
+
+	host_bus_reset(HOST_CLOCK_REAL);
+	model_aht20_init(&sensor, temp, hum);
+	model_hd44780_init(&display);
+
+	host_model_t sensor_device = model_aht20_as_device(&sensor, I2C_HT_SENSOR_BUS);
+	host_model_t display_device = model_hd44780_as_device(&display, MODEL_HD44780_ADDRESS, I2C_LCD_BUS);
+	if (host_bus_add_model(&sensor_device) != APP_OK || host_bus_add_model(&display_device) != APP_OK) {
+		fprintf(stderr, "Could not add the device models\n");
+		return EXIT_FAILURE;
+	}
+
+	if (port_init(&PORT_HOST_OPS) != APP_OK
+			|| boot_run(BOOT_PHASES, sizeof(BOOT_PHASES) / sizeof(BOOT_PHASES[0])) != APP_OK) {
+		fprintf(stderr, "Could not initialize the application\n");
+		host_serial_close();
+		return EXIT_FAILURE;
+	}
+
+	timers_init();
+	views_init();
+
+	if (tasks_init() != APP_OK) {
+		fprintf(stderr, "Could not create the tasks\n");
+		host_serial_close();
+		return EXIT_FAILURE;
+	}
+
+	sched_set_idle_hook(idle);
+
+	printf("Serial port: %s\n", host_serial_get_path());
+	fflush(stdout);
+
+	uint32_t shown_changes = 0;
+	while (running) {
+		// The host has no tick interrupt, the wheel is advanced before each step
+		timers_process();
+		sched_run_once();
+
+		if (display.changes != shown_changes) {
+			shown_changes = display.changes;
+			print_display();
+		}
+	}
+
+	host_serial_close();
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief boot phase of the command interface, it is initialized in a single step
+ *
+ */
+app_err_t init_cmdparser_step(uint32_t* wait_us) {
+	*wait_us = BOOT_STEP_DONE;
+	return cmdparser_init();
+}
+
+void stop(int signal) {
+	running = 0;
+}
+
+/**
+ * @brief waits for a character from the pseudo-terminal, it stands for the UART interrupt waking the core
+ *
+ * The completion of an I2C transfer wakes the core too, so it does not wait if one was delivered
+ */
+void idle(uint32_t max_sleep_ms) {
+	if (host_i2c_poll()) {
+		return;
+	}
+
+	host_uart_poll((max_sleep_ms < MAX_IDLE_MS) ? max_sleep_ms : MAX_IDLE_MS);
+}
+
+/**
+ * @brief prints the rows of the panel as they look on the simulated display
+ *
+ */
+void print_display() {
+	uint8_t text[LCD_COLS + 1];
+	for (uint8_t row = 0; row < LCD_ROWS; row++) {
+		model_hd44780_get_text(&display, LCD_ROW_ADDRESS(row), text, LCD_COLS);
+		printf("|%s|\n", text);
+	}
+
+	printf("\n");
+	fflush(stdout);
+}
@@ -0,0 +1,161 @@
+#include "model_aht20.h"
+#include <string.h>
+
+#define STATUS_CMD 0x71
+#define INIT_CMD 0xBE
+#define TRIGGER_MEASURE_CMD 0xAC
+#define RESET_CMD 0xBA
+
+#define STATUS_BUSY_BIT 0x80
+#define STATUS_CALIBRATED_BIT 0x08
+
+// CRC-8 of the frame: polynomial x^8 + x^5 + x^4 + 1, initial value 0xFF
+#define CRC_POLYNOMIAL 0x31
+#define CRC_INIT 0xFF
+
+#define RAW_FULL_SCALE (1UL << 20)
+
+// Prototypes
+static app_err_t aht20_write(void* state, const uint8_t* data, uint16_t size);
+static app_err_t aht20_read(void* state, uint8_t* buffer, uint16_t size);
+static uint8_t get_status(model_aht20_t* model);
+static void measure(model_aht20_t* model);
+static uint32_t to_raw(double value, double offset, double range);
+static uint8_t crc8(const uint8_t* data, uint8_t size);
+
+/**
+ * @brief prepares an uncalibrated sensor that measures the given values
+ *
+ * @param temp: temperature in Celsius
+ * @param hum: relative humidity in %
+ */
+void model_aht20_init(model_aht20_t* model, double temp, double hum) {
+	memset(model, 0, sizeof(*model));
+	model_aht20_set(model, temp, hum);
+	measure(model);
+	model->measurements = 0;
+}
+
+/**
+ * @brief changes the values measured from the next trigger on
+ *
+ */
+void model_aht20_set(model_aht20_t* model, double temp, double hum) {
+	model->temp = temp;
+	model->hum = hum;
+}
+
+/**
+ * @brief returns the device to be added to the bus with host_bus_add_model()
+ *
+ */
+host_model_t model_aht20_as_device(model_aht20_t* model, i2c_bus_id_t bus) {
+	host_model_t device = {
+			.address = MODEL_AHT20_ADDRESS,
+			.bus = bus,
+			.write = aht20_write,
+			.read = aht20_read,
+			.state = model,
+	};
+
+	return device;
+}
+
+/**
+ * @brief runs the command in the first byte, the status command only selects what the next read returns,
+ * which is always the frame here
+ *
+ */
+app_err_t aht20_write(void* state, const uint8_t* data, uint16_t size) {
+	model_aht20_t* model = state;
+	if (size == 0) {
+		return APP_OK;
+	}
+
+	switch (data[0]) {
+	case INIT_CMD:
+		model->calibrated = true;
+		break;
+	case TRIGGER_MEASURE_CMD:
+		measure(model);
+		model->busy_until_us = host_bus_now_us() + MODEL_AHT20_MEASUREMENT_US;
+		break;
+	case RESET_CMD:
+		model->calibrated = false;
+		model->busy_until_us = 0;
+		break;
+	case STATUS_CMD:
+		break;
+	default:
+		return I2C_ERR_NACK;
+	}
+
+	return APP_OK;
+}
+
+app_err_t aht20_read(void* state, uint8_t* buffer, uint16_t size) {
+	model_aht20_t* model = state;
+
+	model->frame[0] = get_status(model);
+	model->frame[6] = crc8(model->frame, 6);
+
+	for (uint16_t idx = 0; idx < size; idx++) {
+		buffer[idx] = (idx < sizeof(model->frame)) ? model->frame[idx] : 0xFF;
+	}
+
+	return APP_OK;
+}
+
+uint8_t get_status(model_aht20_t* model) {
+	uint8_t status = model->calibrated ? STATUS_CALIBRATED_BIT : 0;
+	if (host_bus_now_us() < model->busy_until_us) {
+		status |= STATUS_BUSY_BIT;
+	}
+
+	return status;
+}
+
+/**
+ * @brief stores the current values in the frame, with the layout of the sensor
+ *
+ */
+void measure(model_aht20_t* model) {
+	uint32_t raw_hum = to_raw(model->hum, 0, 100);
+	uint32_t raw_temp = to_raw(model->temp, -50, 200);
+
+	model->frame[1] = raw_hum >> 12;
+	model->frame[2] = raw_hum >> 4;
+	model->frame[3] = ((raw_hum & 0x0F) << 4) | ((raw_temp >> 16) & 0x0F);
+	model->frame[4] = raw_temp >> 8;
+	model->frame[5] = raw_temp;
+	model->measurements++;
+}
+
+/**
+ * @brief converts a value into the 20-bit raw value of the sensor, saturated to its range
+ *
+ */
+uint32_t to_raw(double value, double offset, double range) {
+	double scaled = (value - offset) / range * RAW_FULL_SCALE;
+	if (scaled <= 0) {
+		return 0;
+	}
+
+	if (scaled >= RAW_FULL_SCALE - 1) {
+		return RAW_FULL_SCALE - 1;
+	}
+
+	return (uint32_t)(scaled + 0.5);
+}
+
+uint8_t crc8(const uint8_t* data, uint8_t size) {
+	uint8_t crc = CRC_INIT;
+	for (uint8_t idx = 0; idx < size; idx++) {
+		crc ^= data[idx];
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x80) ? (crc << 1) ^ CRC_POLYNOMIAL : crc << 1;
+		}
+	}
+
+	return crc;
+}
@@ -0,0 +1,162 @@
+#include "model_hd44780.h"
+#include <string.h>
+
+// Bits of the PCF8574 port
+#define PORT_DATA_MASK 0xF0
+#define PORT_EN_BIT 0x04
+#define PORT_RS_BIT 0x01
+
+#define CLEAR_DISPLAY_CMD 0x01
+#define RETURN_HOME_CMD 0x02
+#define ENTRY_MODE_CMD 0x04
+#define FUNCTION_SET_CMD 0x20
+#define FUNCTION_SET_8_BIT 0x10
+#define SET_CGRAM_ADDRESS_CMD 0x40
+#define SET_DDRAM_ADDRESS_CMD 0x80
+
+// Each line has 40 characters, the address jumps from the end of one to the start of the other
+#define LINE_LENGTH 40
+#define SECOND_LINE_ADDRESS 0x40
+
+// Prototypes
+static app_err_t hd44780_write(void* state, const uint8_t* data, uint16_t size);
+static app_err_t hd44780_read(void* state, uint8_t* buffer, uint16_t size);
+static void latch_nibble(model_hd44780_t* model, uint8_t nibble, bool rs);
+static void execute(model_hd44780_t* model, uint8_t value, bool rs);
+static void clear_ddram(model_hd44780_t* model);
+static uint8_t next_address(uint8_t address);
+
+/**
+ * @brief prepares a controller just powered on: 8-bit mode and a blank DDRAM
+ *
+ */
+void model_hd44780_init(model_hd44780_t* model) {
+	memset(model, 0, sizeof(*model));
+	clear_ddram(model);
+}
+
+/**
+ * @brief returns the device to be added to the bus with host_bus_add_model()
+ *
+ * @param address: 0x27 for the PCF8574 backpack or 0x3F for the PCF8574A one
+ */
+host_model_t model_hd44780_as_device(model_hd44780_t* model, uint16_t address, i2c_bus_id_t bus) {
+	host_model_t device = {
+			.address = address,
+			.bus = bus,
+			.write = hd44780_write,
+			.read = hd44780_read,
+			.state = model,
+	};
+
+	return device;
+}
+
+/**
+ * @brief copies the characters of the DDRAM from the given address, as they would be shown
+ *
+ * @param text: where the characters are copied, it is null terminated so it needs size + 1 bytes
+ */
+void model_hd44780_get_text(const model_hd44780_t* model, uint8_t address, uint8_t* text, uint8_t size) {
+	for (uint8_t idx = 0; idx < size; idx++) {
+		text[idx] = (address < MODEL_HD44780_DDRAM_SIZE) ? model->ddram[address] : ' ';
+		address = next_address(address);
+	}
+
+	text[size] = '\0';
+}
+
+app_err_t hd44780_write(void* state, const uint8_t* data, uint16_t size) {
+	model_hd44780_t* model = state;
+
+	for (uint16_t idx = 0; idx < size; idx++) {
+		bool enable_falling = (model->port & PORT_EN_BIT) && !(data[idx] & PORT_EN_BIT);
+		if (enable_falling) {
+			latch_nibble(model, model->port & PORT_DATA_MASK, model->port & PORT_RS_BIT);
+		}
+
+		model->port = data[idx];
+	}
+
+	return APP_OK;
+}
+
+/**
+ * @brief a read of the expander returns its port, the data lines are never driven by the controller here
+ *
+ */
+app_err_t hd44780_read(void* state, uint8_t* buffer, uint16_t size) {
+	model_hd44780_t* model = state;
+	memset(buffer, model->port, size);
+
+	return APP_OK;
+}
+
+/**
+ * @brief takes the nibble on D7-D4, in 4-bit mode two nibbles make a byte
+ *
+ */
+void latch_nibble(model_hd44780_t* model, uint8_t nibble, bool rs) {
+	if (!model->four_bit) {
+		execute(model, nibble, rs);
+		return;
+	}
+
+	if (!model->high_nibble_latched) {
+		model->high_nibble = nibble;
+		model->high_nibble_latched = true;
+		return;
+	}
+
+	model->high_nibble_latched = false;
+	execute(model, model->high_nibble | (nibble >> 4), rs);
+}
+
+void execute(model_hd44780_t* model, uint8_t value, bool rs) {
+	if (rs) {
+		if (model->address < MODEL_HD44780_DDRAM_SIZE && model->ddram[model->address] != value) {
+			model->ddram[model->address] = value;
+			model->changes++;
+		}
+
+		model->address = next_address(model->address);
+		model->characters++;
+		return;
+	}
+
+	model->commands++;
+
+	// The command is given by the highest bit set, the ones below it are its arguments
+	if (value & SET_DDRAM_ADDRESS_CMD) {
+		model->address = value & ~SET_DDRAM_ADDRESS_CMD;
+	} else if (value >= SET_CGRAM_ADDRESS_CMD) {
+		return;
+	} else if (value >= FUNCTION_SET_CMD) {
+		model->four_bit = !(value & FUNCTION_SET_8_BIT);
+	} else if (value >= ENTRY_MODE_CMD) {
+		return;
+	} else if (value >= RETURN_HOME_CMD) {
+		model->address = 0;
+	} else if (value == CLEAR_DISPLAY_CMD) {
+		clear_ddram(model);
+		model->address = 0;
+		model->changes++;
+	}
+}
+
+void clear_ddram(model_hd44780_t* model) {
+	memset(model->ddram, ' ', sizeof(model->ddram));
+}
+
+uint8_t next_address(uint8_t address) {
+	address++;
+	if (address == LINE_LENGTH) {
+		return SECOND_LINE_ADDRESS;
+	}
+
+	if (address == SECOND_LINE_ADDRESS + LINE_LENGTH) {
+		return 0;
+	}
+
+	return address;
+}
@@ -0,0 +1,268 @@
+#include "host_bus.h"
+#include "stm32f4xx_hal.h"
+#include "i2c_core.h"
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+// Bits on the wire per byte (8 data bits and the ACK) and per transfer (START, STOP and the address byte)
+#define BITS_PER_BYTE 9
+#define BITS_PER_TRANSFER (2 + BITS_PER_BYTE)
+
+// Handles of the buses used by the I2C core, with the settings of MX_I2C1_Init() and MX_I2C3_Init()
+I2C_HandleTypeDef hi2c1 = {
+		.Instance = I2C1,
+		.Init = {
+				.ClockSpeed = I2C_BUS_SPEED_STANDARD,
+				.DutyCycle = I2C_DUTYCYCLE_2,
+		},
+};
+
+I2C_HandleTypeDef hi2c3 = {
+		.Instance = I2C3,
+		.Init = {
+				.ClockSpeed = I2C_BUS_SPEED_STANDARD,
+				.DutyCycle = I2C_DUTYCYCLE_2,
+		},
+};
+
+static host_model_t models[HOST_BUS_MAX_MODELS];
+static uint8_t amount_of_models;
+static host_bus_stats_t stats;
+static host_clock_t clock_kind;
+static uint64_t virtual_us;
+static struct timespec start_time;
+
+// Prototypes
+static app_err_t host_attach(uint16_t address, i2c_bus_id_t bus, i2c_priority_t priority);
+static app_err_t host_scan(i2c_bus_id_t bus);
+static app_err_t host_write_async(uint16_t address, uint8_t* data, uint16_t size, port_callback_t callback, void* context);
+static void host_delay(uint32_t ms);
+static uint32_t host_now();
+static void host_delay_us(uint32_t us);
+static uint32_t host_now_us();
+static host_model_t* find_model(i2c_bus_id_t bus, uint16_t address);
+static void charge_bus_time(uint16_t size, uint32_t speed);
+
+// The transfers go through the I2C core as on the board, the clock is the one of the models
+const port_ops_t PORT_HOST_OPS = {
+		.attach = host_attach,
+		.scan = host_scan,
+		.is_found = I2C_is_found,
+		.write = I2C_master_transmit,
+		.write_async = host_write_async,
+		.read = I2C_master_receive,
+		.write_read = I2C_write_read,
+		.delay = host_delay,
+		.now = host_now,
+		.delay_us = host_delay_us,
+		.now_us = host_now_us,
+};
+
+/**
+ * @brief removes every model, clears the counters and restarts the clock from 0
+ *
+ * @param clock: clock seen by the drivers from now on
+ */
+void host_bus_reset(host_clock_t clock) {
+	amount_of_models = 0;
+	memset(&stats, 0, sizeof(stats));
+	clock_kind = clock;
+	virtual_us = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+/**
+ * @brief puts a device model on its bus
+ *
+ * @param model: model to be added, it is copied but its state must outlive the bus
+ *
+ * @return
+ *  - APP_OK: if the model is added
+ *  - APP_ERR_INVALID_ARG: if model or one of its callbacks is NULL, or the bus is not valid
+ *  - I2C_ERR_TABLE_FULL: if there are already HOST_BUS_MAX_MODELS models
+ */
+app_err_t host_bus_add_model(const host_model_t* model) {
+	if (model == NULL || model->write == NULL || model->read == NULL || model->bus >= I2C_BUS_COUNT) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	if (amount_of_models >= HOST_BUS_MAX_MODELS) {
+		return I2C_ERR_TABLE_FULL;
+	}
+
+	models[amount_of_models++] = *model;
+	return APP_OK;
+}
+
+/**
+ * @brief copies the traffic counters since the last reset
+ *
+ */
+void host_bus_get_stats(host_bus_stats_t* stats_copy) {
+	if (stats_copy != NULL) {
+		*stats_copy = stats;
+	}
+}
+
+/**
+ * @brief returns the microseconds elapsed since the last reset, on the selected clock
+ *
+ */
+uint64_t host_bus_now_us() {
+	if (clock_kind == HOST_CLOCK_VIRTUAL) {
+		return virtual_us;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - start_time.tv_sec) * 1000000 + (now.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+/**
+ * @brief hands a transfer to the model at the address and accounts for it, a missing model does not acknowledge
+ *
+ * @param speed: speed of the bus in Hz, the transfer is charged the time its bits take on the wire
+ *
+ * @return APP_OK, I2C_ERR_NACK or APP_ERR_INVALID_ARG if data is NULL
+ */
+app_err_t host_bus_transfer(i2c_bus_id_t bus, uint16_t address, bool read, uint8_t* data, uint16_t size, uint32_t speed) {
+	if (data == NULL) {
+		return APP_ERR_INVALID_ARG;
+	}
+
+	stats.transfers++;
+
+	host_model_t* model = find_model(bus, address);
+	app_err_t result = I2C_ERR_NACK;
+	if (model != NULL) {
+		result = read ? model->read(model->state, data, size) : model->write(model->state, data, size);
+	}
+
+	if (result == APP_OK) {
+		stats.bytes += size;
+		charge_bus_time(size, speed);
+	} else {
+		stats.nacks++;
+		charge_bus_time(0, speed);
+	}
+
+	return result;
+}
+
+/**
+ * @brief sends the address alone, as the probes of a scan, and charges it as an empty transfer
+ *
+ * @return APP_OK if there is a model at the address, otherwise I2C_ERR_NACK
+ */
+app_err_t host_bus_probe(i2c_bus_id_t bus, uint16_t address, uint32_t speed) {
+	charge_bus_time(0, speed);
+	return (find_model(bus, address) != NULL) ? APP_OK : I2C_ERR_NACK;
+}
+
+/**
+ * @brief registers the device in the I2C core and looks for the fastest speed it supports, as on the board
+ *
+ * @return APP_OK if the device answers, otherwise the corresponding error
+ */
+app_err_t host_attach(uint16_t address, i2c_bus_id_t bus, i2c_priority_t priority) {
+	app_err_t err = I2C_register_device(address, bus, I2C_BUS_SPEED_FAST, priority);
+	if (err != APP_OK) {
+		return err;
+	}
+
+	return I2C_probe_speed(address, NULL);
+}
+
+app_err_t host_scan(i2c_bus_id_t bus) {
+	return I2C_scan(bus, NULL);
+}
+
+/**
+ * @brief queues the write as a chunked transaction, callback is called once every chunk is delivered
+ *
+ */
+app_err_t host_write_async(uint16_t address, uint8_t* data, uint16_t size, port_callback_t callback, void* context) {
+	i2c_transaction_t transaction = {
+			.address = address,
+			.tx_buffer = data,
+			.tx_size = size,
+			.flags = I2C_FLAG_CHUNKED,
+			.callback = callback,
+			.context = context,
+	};
+
+	return I2C_submit(&transaction);
+}
+
+/*
+ * The board takes interrupts at any time, so every call into the clock of the port delivers the I2C
+ * completions that are due, busy waits included
+ */
+
+void host_delay(uint32_t ms) {
+	host_i2c_poll();
+	if (clock_kind == HOST_CLOCK_VIRTUAL) {
+		virtual_us += (uint64_t)ms * 1000;
+		return;
+	}
+
+	struct timespec delay = {
+			.tv_sec = ms / 1000,
+			.tv_nsec = (ms % 1000) * 1000000L,
+	};
+	nanosleep(&delay, NULL);
+}
+
+uint32_t host_now() {
+	host_i2c_poll();
+	return host_bus_now_us() / 1000;
+}
+
+void host_delay_us(uint32_t us) {
+	host_i2c_poll();
+	if (clock_kind == HOST_CLOCK_VIRTUAL) {
+		virtual_us += us;
+		return;
+	}
+
+	struct timespec delay = {
+			.tv_sec = us / 1000000,
+			.tv_nsec = (us % 1000000) * 1000L,
+	};
+	nanosleep(&delay, NULL);
+}
+
+uint32_t host_now_us() {
+	host_i2c_poll();
+	return (uint32_t)host_bus_now_us();
+}
+
+/**
+ * @brief looks for the model at the given address of the bus
+ *
+ * @return the model, or NULL if there is none
+ */
+host_model_t* find_model(i2c_bus_id_t bus, uint16_t address) {
+	for (uint8_t idx = 0; idx < amount_of_models; idx++) {
+		if (models[idx].bus == bus && models[idx].address == address) {
+			return &models[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief adds the wire time of a transfer of the given size, which also advances the virtual clock
+ *
+ */
+void charge_bus_time(uint16_t size, uint32_t speed) {
+	uint64_t bits = BITS_PER_TRANSFER + (uint64_t)size * BITS_PER_BYTE;
+	uint64_t time_us = (bits * 1000000 + speed - 1) / speed;
+
+	stats.bus_time_us += time_us;
+	if (clock_kind == HOST_CLOCK_VIRTUAL) {
+		virtual_us += time_us;
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef HOST_TESTS_TEST_CHECK_H_
+#define HOST_TESTS_TEST_CHECK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Checks of the host tests. A failed check is printed with its location and the test goes on, so one run
+ * shows every failure. main() returns TEST_RESULT(), which ctest reads from the exit status.
+ */
+
+static uint32_t test_failures = 0;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			test_failures++; \
+		} \
+	} while (0)
+
+#define TEST_RESULT() ((test_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE)
+
+#endif /* HOST_TESTS_TEST_CHECK_H_ */
@@ -0,0 +1,217 @@
+#include "test_check.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Values given to the sensor model, the display must show the temperature after GET TEMP
+#define TEMP "21.25"
+#define HUM "40"
+
+// Longest wait for the link of the pseudo-terminal and for each reply
+#define START_TIMEOUT_MS 2000
+#define REPLY_TIMEOUT_MS 2000
+
+// The boot of the models takes about 60 ms
+#define BOOT_WAIT_MS 300
+
+#define REPLY_SIZE 4096
+#define DISPLAY_SIZE 65536
+
+// Every reply ends with the prompt
+static const char PROMPT[] = "> ";
+
+// Command sent and a text its reply must contain
+typedef struct {
+	const char* command;
+	const char* expected;
+} exchange_t;
+
+static const exchange_t EXCHANGES[] = {
+		{"HELP", "COMMANDS:"},
+		{"FOO", "CMDPARSER_ERR_UNKNOWN_CMD"},
+		{"GET TEMP", PROMPT},
+		{"SCAN", "I2C1: 2 FOUND"},
+		{"DEVICES", "0x38 I2C1 400"},
+		// The rows of the display are written through the I2C core
+		{"TRACE I2C", "0x27 W"},
+		{"LATENCY", "SCAN"},
+		{"CLOCK LOW", "PROFILE: LOW"},
+		{"DEVICES", "0x27 I2C1 400"},
+		{"CLOCK BALANCED", "PROFILE: BALANCED"},
+};
+
+// Prototypes
+static uint64_t now_ms();
+static void sleep_ms(uint32_t ms);
+static int open_link(const char* link_path);
+static bool exchange(int fd, const char* command, char* reply, size_t size);
+static size_t read_all(int fd, char* buffer, size_t size);
+
+/**
+ * @brief drives the command interface of trabajo_final_host through its pseudo-terminal
+ *
+ * Each command of EXCHANGES is sent as a terminal would and its reply is checked, then the display printed
+ * on the standard output of the program must show the temperature of the sensor model.
+ *
+ * Usage: test_commands <path of trabajo_final_host>
+ *
+ */
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <path of trabajo_final_host>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	char dir[] = "/tmp/test_commands_XXXXXX";
+	if (mkdtemp(dir) == NULL) {
+		perror("mkdtemp");
+		return EXIT_FAILURE;
+	}
+
+	char link_path[sizeof(dir) + 8];
+	snprintf(link_path, sizeof(link_path), "%s/tty", dir);
+
+	int display_pipe[2];
+	if (pipe(display_pipe) != 0) {
+		perror("pipe");
+		return EXIT_FAILURE;
+	}
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		dup2(display_pipe[1], STDOUT_FILENO);
+		close(display_pipe[0]);
+		execl(argv[1], argv[1], link_path, TEMP, HUM, (char*)NULL);
+		perror("execl");
+		_exit(EXIT_FAILURE);
+	}
+
+	close(display_pipe[1]);
+
+	int fd = open_link(link_path);
+	CHECK(fd >= 0);
+	if (fd >= 0) {
+		// The prompt printed at boot is discarded
+		sleep_ms(BOOT_WAIT_MS);
+		tcflush(fd, TCIFLUSH);
+
+		char reply[REPLY_SIZE];
+		for (size_t idx = 0; idx < sizeof(EXCHANGES) / sizeof(EXCHANGES[0]); idx++) {
+			bool answered = exchange(fd, EXCHANGES[idx].command, reply, sizeof(reply));
+			if (!answered || strstr(reply, EXCHANGES[idx].expected) == NULL) {
+				fprintf(stderr, "%s: expected \"%s\" in \"%s\"\n", EXCHANGES[idx].command, EXCHANGES[idx].expected,
+						reply);
+				test_failures++;
+			}
+		}
+
+		close(fd);
+	}
+
+	kill(pid, SIGINT);
+	waitpid(pid, NULL, 0);
+
+	static char display[DISPLAY_SIZE];
+	read_all(display_pipe[0], display, sizeof(display));
+	CHECK(strstr(display, "|TEMP: " TEMP) != NULL);
+
+	unlink(link_path);
+	rmdir(dir);
+	return TEST_RESULT();
+}
+
+uint64_t now_ms() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void sleep_ms(uint32_t ms) {
+	struct timespec delay = {
+			.tv_sec = ms / 1000,
+			.tv_nsec = (ms % 1000) * 1000000L,
+	};
+	nanosleep(&delay, NULL);
+}
+
+/**
+ * @brief waits for the program to create the link and opens the terminal in raw mode
+ *
+ * @return the descriptor, or -1 if the link did not appear in time
+ */
+int open_link(const char* link_path) {
+	uint64_t start = now_ms();
+	int fd;
+	while ((fd = open(link_path, O_RDWR | O_NOCTTY)) < 0) {
+		if (now_ms() - start > START_TIMEOUT_MS) {
+			return -1;
+		}
+
+		sleep_ms(10);
+	}
+
+	struct termios settings;
+	tcgetattr(fd, &settings);
+	cfmakeraw(&settings);
+	tcsetattr(fd, TCSANOW, &settings);
+
+	return fd;
+}
+
+/**
+ * @brief sends the command as a terminal does, ended by a carriage return, and reads its reply up to the prompt
+ *
+ * @return true if the prompt arrived within REPLY_TIMEOUT_MS
+ */
+bool exchange(int fd, const char* command, char* reply, size_t size) {
+	dprintf(fd, "%s\r", command);
+
+	size_t length = 0;
+	reply[0] = '\0';
+	uint64_t start = now_ms();
+	while (now_ms() - start < REPLY_TIMEOUT_MS) {
+		fd_set fds;
+		FD_ZERO(&fds);
+		FD_SET(fd, &fds);
+		struct timeval timeout = {.tv_sec = 0, .tv_usec = 10000};
+		if (select(fd + 1, &fds, NULL, NULL, &timeout) <= 0) {
+			continue;
+		}
+
+		ssize_t amount = read(fd, &reply[length], size - length - 1);
+		if (amount <= 0) {
+			break;
+		}
+
+		length += amount;
+		reply[length] = '\0';
+		if (length >= strlen(PROMPT) && !strcmp(&reply[length - strlen(PROMPT)], PROMPT)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief reads until the end of the file, the text is terminated
+ *
+ * @return the amount of bytes read
+ */
+size_t read_all(int fd, char* buffer, size_t size) {
+	size_t length = 0;
+	ssize_t amount;
+	while (length < size - 1 && (amount = read(fd, &buffer[length], size - length - 1)) > 0) {
+		length += amount;
+	}
+
+	buffer[length] = '\0';
+	return length;
+}
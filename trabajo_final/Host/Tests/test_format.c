@@ -0,0 +1,110 @@
+#include "test_check.h"
+#include "API_format.h"
+#include <stdbool.h>
+#include <string.h>
+
+// The AHT20 gives 20-bit raw values, the driver divides them by 2^20
+#define RAW_VALUES (1UL << 20)
+
+#define TEXT_SIZE 16
+
+// Mismatches printed before only counting them
+#define MAX_REPORTED 10
+
+// Prototypes
+static void test_fixed();
+static void test_limits();
+static void test_measurements();
+static bool matches_printf(double value, uint8_t precision);
+
+/**
+ * @brief checks the formatter against snprintf, for every value the AHT20 driver can produce
+ *
+ */
+int main() {
+	test_fixed();
+	test_limits();
+	test_measurements();
+
+	return TEST_RESULT();
+}
+
+/**
+ * @brief fixed-point values, widths and hexadecimal
+ *
+ */
+void test_fixed() {
+	uint8_t text[TEXT_SIZE];
+
+	CHECK(fmt_fixed(text, sizeof(text), -1234, 2, 0) == 6 && !memcmp(text, "-12.34", 6));
+	CHECK(fmt_fixed(text, sizeof(text), 5, 3, 0) == 5 && !memcmp(text, "0.005", 5));
+	CHECK(fmt_fixed(text, sizeof(text), 0, 0, 0) == 1 && !memcmp(text, "0", 1));
+	CHECK(fmt_uint(text, sizeof(text), 42, 5) == 5 && !memcmp(text, "   42", 5));
+	CHECK(fmt_uint(text, sizeof(text), UINT32_MAX, 0) == 10 && !memcmp(text, "4294967295", 10));
+	CHECK(fmt_hex(text, sizeof(text), 0x2A, 4) == 6 && !memcmp(text, "0x002A", 6));
+}
+
+/**
+ * @brief text that does not fit, invalid precisions and the sign of values that round to zero
+ *
+ */
+void test_limits() {
+	uint8_t text[TEXT_SIZE];
+
+	CHECK(fmt_fixed(text, 3, -1234, 2, 0) == 0);
+	CHECK(fmt_uint(text, 4, 1, 5) == 0);
+	CHECK(fmt_hex(text, 5, 0, 4) == 0);
+	CHECK(fmt_fixed(text, sizeof(text), 1, FMT_MAX_PRECISION + 1, 0) == 0);
+	CHECK(fmt_double(text, sizeof(text), 1.0, FMT_MAX_PRECISION + 1, 0) == 0);
+
+	CHECK(fmt_double(text, sizeof(text), -0.001, 2, 0) == 5 && !memcmp(text, "-0.00", 5));
+	CHECK(fmt_double(text, sizeof(text), -0.0, 1, 0) == 4 && !memcmp(text, "-0.0", 4));
+	CHECK(fmt_double(text, sizeof(text), 0.004, 2, 0) == 4 && !memcmp(text, "0.00", 4));
+
+	CHECK(matches_printf(2.5, 0) && matches_printf(3.5, 0) && matches_printf(0.125, 2) && matches_printf(-0.125, 2));
+}
+
+/**
+ * @brief every raw value as Celsius, Fahrenheit, Kelvin and humidity, with the precisions of the views
+ *
+ * The conversions are the ones of the AHT20 driver, so these are all the values the display can show
+ */
+void test_measurements() {
+	static const uint8_t PRECISIONS[] = {1, 2};
+
+	uint32_t mismatches = 0;
+	for (uint32_t raw = 0; raw < RAW_VALUES; raw++) {
+		double temp = (raw / (double)RAW_VALUES) * 200 - 50;
+		double values[] = {
+				temp,
+				(temp * 9 / 5) + 32,
+				temp + 273.15,
+				(raw / (double)RAW_VALUES) * 100,
+		};
+
+		for (uint8_t idx = 0; idx < sizeof(values) / sizeof(values[0]); idx++) {
+			for (uint8_t precision_idx = 0; precision_idx < sizeof(PRECISIONS); precision_idx++) {
+				if (!matches_printf(values[idx], PRECISIONS[precision_idx]) && mismatches++ < MAX_REPORTED) {
+					fprintf(stderr, "raw %u: %.17g differs from printf with precision %u\n", raw, values[idx],
+							PRECISIONS[precision_idx]);
+				}
+			}
+		}
+	}
+
+	CHECK(mismatches == 0);
+}
+
+/**
+ * @brief compares fmt_double() with snprintf("%.*f")
+ *
+ */
+bool matches_printf(double value, uint8_t precision) {
+	char expected[TEXT_SIZE];
+	uint8_t text[TEXT_SIZE];
+
+	int expected_length = snprintf(expected, sizeof(expected), "%.*f", precision, value);
+	uint8_t length = fmt_double(text, sizeof(text), value, precision, 0);
+
+	return length == expected_length && !memcmp(text, expected, length);
+}
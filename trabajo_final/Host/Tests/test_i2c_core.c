@@ -0,0 +1,384 @@
+#include "test_check.h"
+#include "stm32f4xx_hal.h"
+#include "cycles.h"
+#include "host_bus.h"
+#include "host_script.h"
+#include "i2c_core.h"
+#include "i2c_trace.h"
+#include <string.h>
+
+#define SCRIPTED_ADDRESS 0x50
+#define NACK_ADDRESS 0x51
+#define STANDARD_ADDRESS 0x52
+
+// Chunked writes span several chunks at I2C_BUS_SPEED_FAST
+#define LONG_WRITE_SIZE 50
+
+typedef struct {
+	uint8_t amount;
+	uint8_t order[4];
+	app_err_t results[4];
+} completions_t;
+
+static host_script_t script;
+static completions_t completions;
+
+// Prototypes
+static void setup(const host_step_t* steps, uint16_t amount_of_steps);
+static void test_write_read();
+static void test_vectored_write();
+static void test_nack();
+static void test_chunked_write();
+static void test_chunk_jitter();
+static void test_priority();
+static void test_timeout();
+static void test_busy_bus();
+static void test_stuck_bus();
+static void record_completion(app_err_t result, void* context);
+static void wait_idle();
+
+/**
+ * @brief tests the I2C core on the HAL stand-in, with scripted devices on I2C1
+ *
+ */
+int main() {
+	HAL_Init();
+	cycles_init();
+
+	test_write_read();
+	test_vectored_write();
+	test_nack();
+	test_chunked_write();
+	test_chunk_jitter();
+	test_priority();
+	test_timeout();
+	test_busy_bus();
+	test_stuck_bus();
+
+	return TEST_RESULT();
+}
+
+/**
+ * @brief puts a scripted device at SCRIPTED_ADDRESS and a silent one at NACK_ADDRESS, both registered
+ *
+ */
+void setup(const host_step_t* steps, uint16_t amount_of_steps) {
+	static host_step_t nack_step = {.kind = HOST_STEP_WRITE, .nack = true};
+	static host_script_t nack_script;
+
+	host_bus_reset(HOST_CLOCK_REAL);
+	host_script_init(&script, steps, amount_of_steps, false);
+	host_script_init(&nack_script, &nack_step, 1, true);
+
+	host_model_t scripted = {SCRIPTED_ADDRESS, I2C_BUS_1, host_script_write, host_script_read, &script};
+	host_model_t silent = {NACK_ADDRESS, I2C_BUS_1, host_script_write, host_script_read, &nack_script};
+	CHECK(host_bus_add_model(&scripted) == APP_OK);
+	CHECK(host_bus_add_model(&silent) == APP_OK);
+
+	CHECK(I2C_register_device(SCRIPTED_ADDRESS, I2C_BUS_1, I2C_BUS_SPEED_FAST, I2C_PRIORITY_LOW) == APP_OK);
+	CHECK(I2C_register_device(NACK_ADDRESS, I2C_BUS_1, I2C_BUS_SPEED_FAST, I2C_PRIORITY_LOW) == APP_OK);
+	CHECK(I2C_probe_speed(SCRIPTED_ADDRESS, NULL) == APP_OK);
+
+	memset(&completions, 0, sizeof(completions));
+	i2c_trace_clear();
+}
+
+/**
+ * @brief the read of a write-read gets the answer of the device and both transfers are traced
+ *
+ */
+void test_write_read() {
+	static const uint8_t cmd[] = {0x10};
+	static const uint8_t answer[] = {0xAB, 0xCD};
+	static const host_step_t steps[] = {
+			{HOST_STEP_WRITE, cmd, sizeof(cmd), false},
+			{HOST_STEP_READ, answer, sizeof(answer), false},
+	};
+
+	setup(steps, 2);
+
+	uint8_t buffer[2] = {0};
+	CHECK(I2C_write_read(SCRIPTED_ADDRESS, (uint8_t*)cmd, sizeof(cmd), buffer, sizeof(buffer)) == APP_OK);
+	CHECK(!memcmp(buffer, answer, sizeof(answer)));
+	CHECK(host_script_done(&script));
+	CHECK(I2C_get_device_speed(SCRIPTED_ADDRESS) == I2C_BUS_SPEED_FAST);
+
+	i2c_trace_record_t records[4];
+	CHECK(i2c_trace_snapshot(records, 4) == 2);
+	CHECK(records[0].direction == I2C_TRACE_WRITE && records[0].length == sizeof(cmd) && records[0].result == APP_OK);
+	CHECK(records[1].direction == I2C_TRACE_READ && records[1].length == sizeof(answer) && records[1].result == APP_OK);
+}
+
+/**
+ * @brief the segments of a vectored write reach the device as a single write
+ *
+ */
+void test_vectored_write() {
+	static const uint8_t joined[] = {1, 2, 3, 4, 5};
+	static const host_step_t steps[] = {
+			{HOST_STEP_WRITE, joined, sizeof(joined), false},
+	};
+
+	setup(steps, 1);
+
+	i2c_segment_t segments[] = {
+			{(uint8_t*)&joined[0], 2},
+			{(uint8_t*)&joined[2], 3},
+	};
+
+	CHECK(I2C_write_vectored(SCRIPTED_ADDRESS, segments, 2) == APP_OK);
+	CHECK(host_script_done(&script));
+}
+
+/**
+ * @brief a device that does not acknowledge fails with I2C_ERR_NACK, counted apart from errors
+ *
+ */
+void test_nack() {
+	setup(NULL, 0);
+
+	uint8_t data = 0;
+	CHECK(I2C_master_transmit(NACK_ADDRESS, &data, 1) == I2C_ERR_NACK);
+
+	for (uint8_t idx = 0; idx < I2C_get_amount_of_devices(); idx++) {
+		i2c_device_info_t info;
+		CHECK(I2C_get_device_info(idx, &info) == APP_OK);
+		if (info.address == NACK_ADDRESS) {
+			CHECK(info.nacks == 1 && info.errors == 0);
+		}
+	}
+}
+
+/**
+ * @brief a chunked write is sent as transfers of at most I2C_MAX_JITTER_US each
+ *
+ */
+void test_chunked_write() {
+	static const host_step_t steps[] = {
+			{HOST_STEP_WRITE, NULL, 0, false},
+			{HOST_STEP_WRITE, NULL, 0, false},
+			{HOST_STEP_WRITE, NULL, 0, false},
+	};
+
+	setup(steps, 3);
+
+	uint8_t data[LONG_WRITE_SIZE] = {0};
+	i2c_transaction_t transaction = {
+			.address = SCRIPTED_ADDRESS,
+			.tx_buffer = data,
+			.tx_size = sizeof(data),
+			.flags = I2C_FLAG_CHUNKED,
+			.callback = record_completion,
+	};
+
+	CHECK(I2C_submit(&transaction) == APP_OK);
+	CHECK(!I2C_is_idle());
+	wait_idle();
+
+	host_bus_stats_t stats;
+	host_bus_get_stats(&stats);
+	CHECK(completions.amount == 1 && completions.results[0] == APP_OK);
+	CHECK(stats.transfers == 3 && stats.bytes == LONG_WRITE_SIZE);
+	CHECK(host_script_done(&script));
+}
+
+/**
+ * @brief every chunk, with its address byte, fits in I2C_MAX_JITTER_US at both bus speeds
+ *
+ */
+void test_chunk_jitter() {
+	static host_step_t any_write = {.kind = HOST_STEP_WRITE};
+	static host_script_t standard_script;
+
+	setup(NULL, 0);
+	host_script_init(&standard_script, &any_write, 1, true);
+	host_script_init(&script, &any_write, 1, true);
+
+	host_model_t standard = {STANDARD_ADDRESS, I2C_BUS_1, host_script_write, host_script_read, &standard_script};
+	CHECK(host_bus_add_model(&standard) == APP_OK);
+	CHECK(I2C_register_device(STANDARD_ADDRESS, I2C_BUS_1, I2C_BUS_SPEED_STANDARD, I2C_PRIORITY_LOW) == APP_OK);
+
+	static const uint16_t ADDRESSES[] = {STANDARD_ADDRESS, SCRIPTED_ADDRESS};
+	for (uint8_t idx = 0; idx < sizeof(ADDRESSES) / sizeof(ADDRESSES[0]); idx++) {
+		uint8_t data[LONG_WRITE_SIZE] = {0};
+		i2c_transaction_t transaction = {
+				.address = ADDRESSES[idx],
+				.tx_buffer = data,
+				.tx_size = sizeof(data),
+				.flags = I2C_FLAG_CHUNKED,
+				.callback = record_completion,
+		};
+
+		i2c_trace_clear();
+		CHECK(I2C_submit(&transaction) == APP_OK);
+		wait_idle();
+
+		uint32_t speed = I2C_get_device_speed(ADDRESSES[idx]);
+		i2c_trace_record_t records[I2C_TRACE_LENGTH];
+		uint8_t amount = i2c_trace_snapshot(records, I2C_TRACE_LENGTH);
+		uint32_t sent = 0;
+		CHECK(amount > 1);
+		for (uint8_t record = 0; record < amount; record++) {
+			uint32_t length = records[record].length;
+			sent += length;
+			if ((length + 1) * 9 * 1000000 / speed > I2C_MAX_JITTER_US) {
+				fprintf(stderr, "%u bytes at %u Hz take longer than %u us\n", length, speed, I2C_MAX_JITTER_US);
+				test_failures++;
+			}
+		}
+
+		CHECK(sent == LONG_WRITE_SIZE);
+	}
+
+	CHECK(completions.amount == 2 && completions.results[0] == APP_OK && completions.results[1] == APP_OK);
+}
+
+/**
+ * @brief a high priority transaction goes in between the chunks of a write queued before it
+ *
+ */
+void test_priority() {
+	static const host_step_t steps[] = {
+			{HOST_STEP_WRITE, NULL, 0, false},
+			{HOST_STEP_WRITE, NULL, 0, false},
+			{HOST_STEP_WRITE, NULL, 0, false},
+			{HOST_STEP_WRITE, NULL, 0, false},
+	};
+
+	setup(steps, 4);
+
+	uint8_t data[LONG_WRITE_SIZE] = {0};
+	i2c_transaction_t chunked = {
+			.address = SCRIPTED_ADDRESS,
+			.tx_buffer = data,
+			.tx_size = sizeof(data),
+			.flags = I2C_FLAG_CHUNKED,
+			.callback = record_completion,
+			.context = (void*)0,
+	};
+
+	i2c_transaction_t urgent = {
+			.address = SCRIPTED_ADDRESS,
+			.tx_buffer = data,
+			.tx_size = 1,
+			.flags = I2C_FLAG_HIGH_PRIORITY,
+			.callback = record_completion,
+			.context = (void*)1,
+	};
+
+	CHECK(I2C_submit(&chunked) == APP_OK);
+	CHECK(I2C_submit(&urgent) == APP_OK);
+	wait_idle();
+
+	CHECK(completions.amount == 2);
+	CHECK(completions.order[0] == 1 && completions.order[1] == 0);
+	CHECK(host_script_done(&script));
+}
+
+/**
+ * @brief a transfer that never completes is failed by I2C_process() and its late completion is dropped
+ *
+ */
+void test_timeout() {
+	static const host_step_t steps[] = {
+			{HOST_STEP_WRITE, NULL, 0, false},
+	};
+
+	setup(steps, 1);
+
+	uint8_t data = 0;
+	i2c_transaction_t transaction = {
+			.address = SCRIPTED_ADDRESS,
+			.tx_buffer = &data,
+			.tx_size = 1,
+			.callback = record_completion,
+	};
+
+	CHECK(I2C_submit(&transaction) == APP_OK);
+
+	// HAL_Delay() does not deliver the completion, as if the interrupt was lost
+	HAL_Delay(I2C_DEFAULT_TIMEOUT_MS + 10);
+	I2C_process();
+
+	CHECK(completions.amount == 1 && completions.results[0] == I2C_ERR_TIMEOUT);
+	CHECK(I2C_is_idle());
+	CHECK(!host_i2c_poll());
+	CHECK(completions.amount == 1);
+}
+
+/**
+ * @brief a transaction that finds BUSY set does not start until I2C_process() recovers the bus
+ *
+ */
+void test_busy_bus() {
+	static const host_step_t steps[] = {
+			{HOST_STEP_WRITE, NULL, 0, false},
+	};
+
+	setup(steps, 1);
+
+	uint8_t data = 0;
+	i2c_transaction_t transaction = {
+			.address = SCRIPTED_ADDRESS,
+			.tx_buffer = &data,
+			.tx_size = 1,
+			.callback = record_completion,
+	};
+
+	I2C1->SR2 |= I2C_SR2_BUSY;
+	CHECK(I2C_submit(&transaction) == APP_OK);
+
+	host_bus_stats_t stats;
+	host_bus_get_stats(&stats);
+	CHECK(stats.transfers == 0);
+	CHECK(!I2C_is_idle());
+
+	// The recovery resets the peripheral, which clears BUSY, and starts the transaction
+	I2C_process();
+	CHECK(!(I2C1->SR2 & I2C_SR2_BUSY));
+	wait_idle();
+
+	CHECK(completions.amount == 1 && completions.results[0] == APP_OK);
+	CHECK(host_script_done(&script));
+}
+
+/**
+ * @brief a transaction on a bus whose SDA stays low after the recovery fails with I2C_ERR_BUS_STUCK
+ *
+ */
+void test_stuck_bus() {
+	setup(NULL, 0);
+
+	// SDA of I2C1
+	GPIOB->held_low = GPIO_PIN_9;
+	I2C1->SR2 |= I2C_SR2_BUSY;
+
+	uint8_t data = 0;
+	CHECK(I2C_master_transmit(SCRIPTED_ADDRESS, &data, 1) == I2C_ERR_BUS_STUCK);
+	CHECK(I2C_is_idle());
+
+	GPIOB->held_low = 0;
+	I2C1->SR2 &= ~I2C_SR2_BUSY;
+}
+
+void record_completion(app_err_t result, void* context) {
+	if (completions.amount < sizeof(completions.order)) {
+		completions.order[completions.amount] = (uint8_t)(uintptr_t)context;
+		completions.results[completions.amount] = result;
+		completions.amount++;
+	}
+}
+
+/**
+ * @brief delivers the completions until every queue is empty
+ *
+ */
+void wait_idle() {
+	uint32_t start = HAL_GetTick();
+	while (!I2C_is_idle() && HAL_GetTick() - start < 1000) {
+		I2C_process();
+		__WFI();
+	}
+
+	CHECK(I2C_is_idle());
+}
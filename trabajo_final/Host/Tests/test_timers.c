@@ -0,0 +1,230 @@
+#include "test_check.h"
+#include "API_timers.h"
+#include "port.h"
+#include "host_bus.h"
+#include <stdbool.h>
+#include <string.h>
+
+// Ticks spanned by a slot of each level of the wheel
+#define LEVEL_1_SPAN 64UL
+#define LEVEL_2_SPAN 4096UL
+#define LEVEL_3_SPAN 262144UL
+
+// Delay beyond the last level, the timer is placed again when it cascades
+#define BEYOND_WHEEL_DELAY ((1UL << 24) + 1000)
+
+#define NOT_FIRED UINT32_MAX
+
+typedef struct {
+	uint32_t fired_at;
+	uint32_t times_fired;
+} record_t;
+
+static uint32_t fake_now;
+static record_t records[TIMERS_MAX];
+
+// Timers take their identifiers in order from timers_init(), so this is the record of the next one
+static uint8_t amount_created;
+
+// Prototypes
+static uint32_t get_fake_now();
+static void setup(uint32_t start);
+static timer_id_t start_timer(uint32_t delay_ms, uint32_t period_ms);
+static void run_ticks(uint32_t amount);
+static void sleep_until_idle(uint32_t end);
+static void test_wrap_around();
+static void test_cascade_boundaries();
+static void test_tickless_catch_up();
+static void test_late_periodic();
+static void record_expiry(void* context);
+
+/**
+ * @brief tests the timer wheel on a clock driven by the test
+ *
+ */
+int main() {
+	static port_ops_t ops;
+	ops = PORT_HOST_OPS;
+	ops.now = get_fake_now;
+	CHECK(port_init(&ops) == APP_OK);
+
+	test_wrap_around();
+	test_cascade_boundaries();
+	test_tickless_catch_up();
+	test_late_periodic();
+
+	return TEST_RESULT();
+}
+
+uint32_t get_fake_now() {
+	return fake_now;
+}
+
+/**
+ * @brief empties the wheel at the given tick
+ *
+ */
+void setup(uint32_t start) {
+	fake_now = start;
+	timers_init();
+	amount_created = 0;
+
+	for (uint8_t idx = 0; idx < TIMERS_MAX; idx++) {
+		records[idx] = (record_t){.fired_at = NOT_FIRED};
+	}
+}
+
+timer_id_t start_timer(uint32_t delay_ms, uint32_t period_ms) {
+	timer_id_t id = 0;
+	CHECK(timers_create(record_expiry, &records[amount_created++], &id) == APP_OK);
+	CHECK(timers_start(id, delay_ms, period_ms) == APP_OK);
+	return id;
+}
+
+/**
+ * @brief processes the wheel on every tick, as the tick interrupt does
+ *
+ */
+void run_ticks(uint32_t amount) {
+	for (uint32_t idx = 0; idx < amount; idx++) {
+		fake_now++;
+		timers_process();
+	}
+}
+
+/**
+ * @brief sleeps as the tickless idle does, jumping to the time the wheel asks for, until end
+ *
+ */
+void sleep_until_idle(uint32_t end) {
+	while ((int32_t)(end - fake_now) > 0) {
+		uint32_t sleep = timers_get_sleep_time();
+		if (sleep > end - fake_now) {
+			sleep = end - fake_now;
+		}
+
+		fake_now += (sleep > 0) ? sleep : 1;
+		timers_process();
+	}
+}
+
+/**
+ * @brief timers keep their delays and order across the wrap-around of the tick
+ *
+ */
+void test_wrap_around() {
+	setup(UINT32_MAX - 20);
+
+	timer_id_t before = start_timer(10, 0);
+	timer_id_t across = start_timer(30, 0);
+	timer_id_t periodic = start_timer(15, 15);
+
+	CHECK(timers_get_sleep_time() == 10);
+	run_ticks(100);
+
+	CHECK(records[before].fired_at == UINT32_MAX - 10 && records[before].times_fired == 1);
+	CHECK(records[across].fired_at == 9 && records[across].times_fired == 1);
+	CHECK(records[periodic].times_fired == 6);
+	CHECK(records[periodic].fired_at == UINT32_MAX - 20 + 90);
+}
+
+/**
+ * @brief timers on both sides of the span of each level fire on their tick, whatever the start tick
+ *
+ */
+void test_cascade_boundaries() {
+	static const uint32_t DELAYS[] = {
+			0, 1, LEVEL_1_SPAN - 1, LEVEL_1_SPAN, LEVEL_1_SPAN + 1,
+			LEVEL_2_SPAN - 1, LEVEL_2_SPAN, LEVEL_2_SPAN + 1,
+			LEVEL_3_SPAN - 1, LEVEL_3_SPAN, LEVEL_3_SPAN + 1,
+	};
+	static const uint32_t STARTS[] = {0, 1, LEVEL_1_SPAN - 1, LEVEL_2_SPAN - 5, 123457};
+
+	for (uint8_t start_idx = 0; start_idx < sizeof(STARTS) / sizeof(STARTS[0]); start_idx++) {
+		uint32_t start = STARTS[start_idx];
+		setup(start);
+
+		timer_id_t ids[sizeof(DELAYS) / sizeof(DELAYS[0])];
+		for (uint8_t idx = 0; idx < sizeof(DELAYS) / sizeof(DELAYS[0]); idx++) {
+			ids[idx] = start_timer(DELAYS[idx], 0);
+		}
+
+		run_ticks(LEVEL_3_SPAN + 2);
+
+		for (uint8_t idx = 0; idx < sizeof(DELAYS) / sizeof(DELAYS[0]); idx++) {
+			// A delay of 0 expires on the next tick
+			uint32_t expected = start + ((DELAYS[idx] > 0) ? DELAYS[idx] : 1);
+			if (records[ids[idx]].fired_at != expected || records[ids[idx]].times_fired != 1) {
+				fprintf(stderr, "start %u delay %u: fired %u times at %u instead of %u\n", start, DELAYS[idx],
+						records[ids[idx]].times_fired, records[ids[idx]].fired_at, expected);
+				test_failures++;
+			}
+		}
+	}
+}
+
+/**
+ * @brief sleeping for the time the wheel asks never oversleeps an expiry, across every level and beyond
+ *
+ */
+void test_tickless_catch_up() {
+	static const uint32_t DELAYS[] = {
+			5, LEVEL_1_SPAN + 3, LEVEL_2_SPAN + 77, LEVEL_3_SPAN + 1000, 3 * LEVEL_3_SPAN + 5, BEYOND_WHEEL_DELAY,
+	};
+
+	uint32_t start = UINT32_MAX - LEVEL_2_SPAN;
+	setup(start);
+
+	timer_id_t ids[sizeof(DELAYS) / sizeof(DELAYS[0])];
+	for (uint8_t idx = 0; idx < sizeof(DELAYS) / sizeof(DELAYS[0]); idx++) {
+		ids[idx] = start_timer(DELAYS[idx], 0);
+	}
+
+	sleep_until_idle(start + BEYOND_WHEEL_DELAY + 1);
+
+	for (uint8_t idx = 0; idx < sizeof(DELAYS) / sizeof(DELAYS[0]); idx++) {
+		if (records[ids[idx]].fired_at != start + DELAYS[idx] || records[ids[idx]].times_fired != 1) {
+			fprintf(stderr, "delay %u: fired %u times at %u instead of %u\n", DELAYS[idx],
+					records[ids[idx]].times_fired, records[ids[idx]].fired_at, start + DELAYS[idx]);
+			test_failures++;
+		}
+	}
+
+	CHECK(timers_get_sleep_time() == TIMERS_NO_EXPIRY);
+}
+
+/**
+ * @brief ticks missed in one go fire each expired timer once, and a periodic one keeps its period from then
+ *
+ */
+void test_late_periodic() {
+	setup(1000);
+
+	timer_id_t periodic = start_timer(10, 10);
+	timer_id_t one_shot = start_timer(LEVEL_1_SPAN + 10, 0);
+	timer_id_t later = start_timer(LEVEL_2_SPAN, 0);
+
+	// The tick interrupt was suppressed for longer than the wheel asked
+	fake_now += LEVEL_1_SPAN * 3 + 7;
+	timers_process();
+
+	CHECK(records[periodic].times_fired == 1 && records[periodic].fired_at == fake_now);
+	CHECK(records[one_shot].times_fired == 1 && records[one_shot].fired_at == fake_now);
+	CHECK(records[later].times_fired == 0);
+	CHECK(timers_get_sleep_time() == 10);
+
+	uint32_t late = fake_now;
+	run_ticks(10);
+	CHECK(records[periodic].times_fired == 2 && records[periodic].fired_at == late + 10);
+
+	CHECK(timers_stop(periodic) == APP_OK);
+	sleep_until_idle(1000 + LEVEL_2_SPAN + 1);
+	CHECK(records[later].times_fired == 1 && records[later].fired_at == 1000 + LEVEL_2_SPAN);
+	CHECK(records[periodic].times_fired == 2);
+}
+
+void record_expiry(void* context) {
+	record_t* record = context;
+	record->fired_at = fake_now;
+	record->times_fired++;
+}